@@ -9,21 +9,41 @@ namespace About
 	static constexpr char soft_ver = 1;			// 6 bits
 	static constexpr char can_ver = 1;			// 2 bits
 	static constexpr char git[] = "https://github.com/starfactorypixel/SlaveECU_Motor";
+	static constexpr char build_date[] = __DATE__;
+	static constexpr char build_time[] = __TIME__;
 	
-	inline void Setup()
+	static constexpr uint32_t CFG_BannerTimeout = 100;	// Баннер без первого кадра CAN через, мс.
+	
+	uint32_t first_frame_time = 0;		// Время мс от сброса до первого переданного кадра CAN.
+	bool banner_done = false;
+	
+	/*
+		Передан кадр CAN, вызывается из HAL_CAN_Send.
+	*/
+	inline void OnTransmit(uint32_t time)
 	{
-		Logger.PrintNewLine();
-		Logger.PrintTopic("INFO").Printf("%s, board:%d, soft:%d, can:%d", name, board_ver, soft_ver, can_ver).PrintNewLine();
-		Logger.PrintTopic("INFO").Printf("Desc: %s", desc).PrintNewLine();
-		Logger.PrintTopic("INFO").Printf("Build: %s %s", __DATE__, __TIME__).PrintNewLine();
-		Logger.PrintTopic("INFO").Printf("GitHub: %s", git).PrintNewLine();
-		Logger.PrintTopic("READY").PrintNewLine();
+		if(first_frame_time == 0) first_frame_time = (time > 0) ? time : 1;
 		
 		return;
 	}
 	
+	/*
+		Баннер выводится асинхронно (AsyncLog, и в Release), когда блок уже на шине,
+			вместе со временем от сброса до первого кадра.
+	*/
 	inline void Loop(uint32_t &current_time)
 	{
+		if(banner_done == true) return;
+		if(first_frame_time == 0 && current_time < CFG_BannerTimeout) return;
+		banner_done = true;
+		
+		AsyncLog::Push("INFO", "%s, board:%d, soft:%d, can:%d\r\n", name, board_ver, soft_ver, can_ver);
+		AsyncLog::Push("INFO", "Desc: %s\r\n", desc);
+		AsyncLog::Push("INFO", "Build: %s %s\r\n", build_date, build_time);
+		AsyncLog::Push("INFO", "GitHub: %s\r\n", git);
+		AsyncLog::Push("BOOT", "First CAN frame: %lu ms\r\n", first_frame_time);
+		AsyncLog::Push("READY", "\r\n");
+		
 		return;
 	}
 }
@@ -0,0 +1,243 @@
+/*
+	Асинхронный лог в отладочный UART через DMA.
+
+	ASYNC_LOG_TOPIC() не форматирует и не передаёт: в кольцевой буфер кладутся указатели
+		на строки топика и формата (строки лежат во flash и служат их идентификаторами)
+		и до 4 аргументов как uint32_t. Слот резервируется через LDREX/STREX, поэтому
+		запись O(1), без запрета прерываний, и безопасна из любого ISR.
+
+	Форматирование и передача выполняются в Loop(): готовые записи форматируются в буфер
+		передачи, который отправляется по DMA на USART1. При переполнении кольца запись
+		отбрасывается и учитывается в счётчике drops.
+
+	Аргументы - целые до 32 бит и указатели (%d, %u, %X, %lu, %p, ...), float и 64 бита не поддерживаются.
+		Формат проверяется компилятором по настоящим типам аргументов (_Check() с атрибутом format).
+		%s запрещён: в кольцо попадает только указатель, и строка к форматированию в Loop() может
+		измениться или исчезнуть вместе со стеком. Вместо имени из таблицы пишется индекс.
+		Как и DEBUG_LOG_TOPIC, макрос работает только в Debug (-DDEBUG).
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <stm32f1xx_hal.h>
+
+extern UART_HandleTypeDef hDebugUart;
+
+#if defined(DEBUG)
+	#define ASYNC_LOG_TOPIC(topic, format, ...) do { \
+		static_assert(AsyncLog::_NoString(format), "AsyncLog keeps pointers only, %s is not allowed!"); \
+		if(false) AsyncLog::_Check(format, ##__VA_ARGS__); \
+		AsyncLog::Push(topic, format, ##__VA_ARGS__); \
+	} while(0)
+#else
+	#define ASYNC_LOG_TOPIC(topic, format, ...)
+#endif
+
+namespace AsyncLog
+{
+	static constexpr uint8_t CFG_RingSize = 32;			// Количество записей, степень двойки.
+	static constexpr uint8_t CFG_ArgsMax = 4;			// Максимум аргументов записи.
+	static constexpr uint16_t CFG_TXBufferSize = 256;	// Буфер передачи DMA.
+	static constexpr uint16_t CFG_LineMax = 96;			// Максимальная длина строки.
+	static constexpr uint32_t CFG_SyncTimeout = 10;		// Ожидание окончания DMA в Sync(), мс.
+
+	static_assert((CFG_RingSize & (CFG_RingSize - 1)) == 0, "CFG_RingSize must be a power of two!");
+
+	struct entry_t
+	{
+		const char *topic;
+		const char *format;
+		uint32_t args[CFG_ArgsMax];
+		uint32_t time;
+		volatile bool ready;			// Запись заполнена и может быть отформатирована.
+	};
+
+	entry_t ring[CFG_RingSize];
+	volatile uint32_t head = 0;			// Счётчик зарезервированных записей.
+	volatile uint32_t tail = 0;			// Счётчик обработанных записей.
+	volatile uint32_t drops = 0;		// Отброшено при переполнении.
+
+	uint8_t tx_buffer[CFG_TXBufferSize];
+
+	/*
+		(Interrupt) Резервирует слот, false - кольцо заполнено.
+	*/
+	inline bool _Reserve(uint32_t &idx)
+	{
+		do
+		{
+			idx = __LDREXW(&head);
+			if(idx - tail >= CFG_RingSize)
+			{
+				__CLREX();
+				return false;
+			}
+		}
+		while(__STREXW(idx + 1, &head) != 0);
+
+		return true;
+	}
+
+	inline void _AtomicIncrement(volatile uint32_t *value)
+	{
+		uint32_t tmp;
+		do
+		{
+			tmp = __LDREXW(value);
+		}
+		while(__STREXW(tmp + 1, value) != 0);
+
+		return;
+	}
+
+	/*
+		(Interrupt) Кладёт запись в кольцо.
+	*/
+	inline void _Push(const char *topic, const char *format, const uint32_t *args, uint8_t argc)
+	{
+		uint32_t idx;
+		if(_Reserve(idx) == false)
+		{
+			_AtomicIncrement(&drops);
+			return;
+		}
+
+		entry_t &entry = ring[idx & (CFG_RingSize - 1)];
+		entry.topic = topic;
+		entry.format = format;
+		for(uint8_t i = 0; i < argc; ++i)
+		{
+			entry.args[i] = args[i];
+		}
+		entry.time = HAL_GetTick();
+		__DMB();
+		entry.ready = true;
+
+		return;
+	}
+
+	// Только для проверки формата компилятором, не вызывается.
+	__attribute__((format(printf, 1, 2))) inline void _Check(const char * /* format */, ...) {}
+
+	constexpr bool _IsModifier(char c)
+	{
+		return c == '-' || c == '+' || c == ' ' || c == '#' || c == '.' || c == '*' || (c >= '0' && c <= '9') ||
+			c == 'l' || c == 'h' || c == 'j' || c == 'z' || c == 't' || c == 'L';
+	}
+
+	// Символ преобразования: флаги, ширина, точность и длина пропускаются.
+	constexpr const char *_Conversion(const char *spec)
+	{
+		return _IsModifier(*spec) ? _Conversion(spec + 1) : spec;
+	}
+
+	// В формате нет %s.
+	constexpr bool _NoString(const char *format)
+	{
+		return (*format == '\0') ? true :
+			(*format != '%') ? _NoString(format + 1) :
+			(*_Conversion(format + 1) == 's') ? false :
+			(*_Conversion(format + 1) == '\0') ? true : _NoString(_Conversion(format + 1) + 1);
+	}
+
+	template <typename T>
+	inline uint32_t _Arg(T value)
+	{
+		return (uint32_t)value;
+	}
+
+	template <typename T>
+	inline uint32_t _Arg(T *value)
+	{
+		return (uint32_t)(uintptr_t)value;
+	}
+
+	template <typename... Args>
+	inline void Push(const char *topic, const char *format, Args... args)
+	{
+		static_assert(sizeof...(args) <= CFG_ArgsMax, "Too many arguments for AsyncLog!");
+
+		const uint32_t values[sizeof...(args) + 1] = { _Arg(args)... };
+		_Push(topic, format, values, sizeof...(args));
+
+		return;
+	}
+
+	/*
+		Свободных записей в кольце.
+	*/
+	inline uint32_t Free()
+	{
+		return CFG_RingSize - (head - tail);
+	}
+
+	inline bool IsBusy()
+	{
+		return hDebugUart.gState != HAL_UART_STATE_READY;
+	}
+
+	/*
+		Ждёт окончания передачи DMA перед синхронным выводом через Logger.
+	*/
+	inline void Sync()
+	{
+		uint32_t start = HAL_GetTick();
+		while(IsBusy() == true && HAL_GetTick() - start < CFG_SyncTimeout) {}
+
+		return;
+	}
+
+	/*
+		Форматирует готовые записи в буфер передачи, возвращает длину.
+	*/
+	inline uint16_t _Format()
+	{
+		uint16_t length = 0;
+
+		// Отчёт о потерях идёт первой строкой.
+		static uint32_t drops_reported = 0;
+		uint32_t drops_now = drops;
+		if(drops_now != drops_reported)
+		{
+			length += snprintf((char *)tx_buffer, CFG_TXBufferSize, "[LOG] dropped: %" PRIu32 "\r\n", drops_now - drops_reported);
+			drops_reported = drops_now;
+		}
+
+		while(tail != head && CFG_TXBufferSize - length > CFG_LineMax)
+		{
+			entry_t &entry = ring[tail & (CFG_RingSize - 1)];
+			if(entry.ready == false) break;
+
+			char *line = (char *)tx_buffer + length;
+			// snprintf возвращает длину без усечения или < 0 при ошибке: в буфер попало не больше CFG_LineMax - 1.
+			int prefix = snprintf(line, CFG_LineMax, "%" PRIu32 " [%s] ", entry.time, entry.topic);
+			if(prefix < 0) prefix = 0;
+			if(prefix > CFG_LineMax - 1) prefix = CFG_LineMax - 1;
+			int body = snprintf(line + prefix, CFG_LineMax - prefix, entry.format, entry.args[0], entry.args[1], entry.args[2], entry.args[3]);
+			if(body < 0) body = 0;
+			length += prefix + ((body < CFG_LineMax - prefix) ? body : (CFG_LineMax - prefix - 1));
+
+			entry.ready = false;
+			__DMB();
+			tail = tail + 1;
+		}
+
+		return length;
+	}
+
+	inline void Loop(uint32_t &current_time)
+	{
+		if(IsBusy() == true) return;
+
+		uint16_t length = _Format();
+		if(length == 0) return;
+
+		HAL_UART_Transmit_DMA(&hDebugUart, tx_buffer, length);
+		current_time = HAL_GetTick();
+
+		return;
+	}
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <new>
 #include <CANLibrary.h>
 
 void HAL_CAN_Send(can_object_id_t id, uint8_t *data, uint8_t length);
@@ -13,12 +14,40 @@ namespace CANLib
 	// CAN Library settings
 	//*********************************************************************
 
+	/// @brief Number of diagnostic CANObjects, registered in Debug builds only
+#if defined(PROFILER_ENABLED)
+	static constexpr uint8_t CFG_CANDebugObjectsCount = 1;
+#else
+	static constexpr uint8_t CFG_CANDebugObjectsCount = 0;
+#endif
+
 	/// @brief Number of CANObjects in CANManager
-	static constexpr uint8_t CFG_CANObjectsCount = 13;
+	static constexpr uint8_t CFG_CANObjectsCount = 24 + CFG_CANDebugObjectsCount;
 
 	/// @brief The size of CANManager's internal CAN frame buffer
 	static constexpr uint8_t CFG_CANFrameBufferSize = 16;
 
+	/// @brief Storage for a CANObject that Setup() builds after Config::Setup() instead of before main():
+	/// the library takes the period in the constructor only. obj() is a plain reference, nothing is checked on access.
+	template <typename T>
+	class Deferred
+	{
+	public:
+		template <typename... Args>
+		void Construct(Args... args)
+		{
+			new (_storage) T(args...);
+		}
+
+		T &operator()()
+		{
+			return *reinterpret_cast<T *>(_storage);
+		}
+
+	private:
+		alignas(T) uint8_t _storage[sizeof(T)];
+	};
+
 	//*********************************************************************
 	// CAN Manager
 	//*********************************************************************
@@ -54,88 +83,299 @@ namespace CANLib
 	//*********************************************************************
 	// CAN Blocks: specific blocks
 	//*********************************************************************
+	// Timed objects take their period from Config and are built by Setup(), after Config::Setup().
+	// A new period key value therefore takes effect after a restart; SET_OUT says so, see block_cfg_set_handler().
+	//*********************************************************************
 	// 0x0104 ControllerErrors
 	// request | timer:250
 	// uint16_t bitmask 1 + 2 + 2 { type[0] m1[1..2] m2[3..4] }
 	// Ошибки контроллеров: контроллер №1 — uint16, контроллер №2 — uint16
-	CANObject<uint16_t, 2> obj_controller_errors(0x0104, 250, CAN_ERROR_DISABLED);
+	Deferred<CANObject<uint16_t, 2>> obj_controller_errors;
 
 	// 0x0105 RPM
 	// request | timer:250
 	// uint16_t Об\м 1 + 2 + 2 { type[0] m1[1..2] m2[3..4] }
 	// Обороты двигателей: контроллер №1 — uint16, контроллер №2 — uint16
-	CANObject<uint16_t, 2> obj_controller_rpm(0x0105, 250, CAN_ERROR_DISABLED);
+	Deferred<CANObject<uint16_t, 2>> obj_controller_rpm;
 
 	// 0x0106 Speed
 	// request | timer:250
 	// uint16_t 100м\ч 1 + 2 + 2 { type[0] m1[1..2] m2[3..4] }
 	// Расчетная скорость в сотнях метров в час: контроллер №1 — uint16, контроллер №2 — uint16
-	CANObject<uint16_t, 2> obj_controller_speed(0x0106, 250, CAN_ERROR_DISABLED);
+	Deferred<CANObject<uint16_t, 2>> obj_controller_speed;
 
 	// 0x0107 Voltage
 	// request | timer:500
 	// uint16_t 100мВ 1 + 2 + 2 { type[0] m1[1..2] m2[3..4] }
 	// Напряжение на контроллерах в сотнях мВ: контроллер №1 — uint16, контроллер №2 — uint16
-	CANObject<uint16_t, 2> obj_controller_voltage(0x0107, 500, CAN_ERROR_DISABLED);
+	Deferred<CANObject<uint16_t, 2>> obj_controller_voltage;
 
 	// 0x0108 Current
 	// request | timer:500
 	// int16_t 100мА 1 + 2 + 2 { type[0] m1[1..2] m2[3..4] }
 	// Ток контроллеров в сотнях мА: контроллер №1 — int16, контроллер №2 — int16
-	CANObject<int16_t, 2> obj_controller_current(0x0108, 500, CAN_ERROR_DISABLED);
+	Deferred<CANObject<int16_t, 2>> obj_controller_current;
 
 	// 0x0109 Power
 	// request | timer:500
 	// int16_t Вт 1 + 2 + 2 { type[0] m1[1..2] m2[3..4] }
 	// Потребляемая (отдаваемая) мощность в Вт: контроллер №1 — uint16, контроллер №2 — uint16
-	CANObject<int16_t, 2> obj_controller_power(0x0109, 500, CAN_ERROR_DISABLED);
+	Deferred<CANObject<int16_t, 2>> obj_controller_power;
 
 	// 0x010A Gear+Roll
 	// request | timer:500
 	// uint8_t bitmask 1 + 1+1 + 1+1 { type[0] mg1[1] mr1[2] mg2[3] mr2[3] }
 	// Передача и фактическое направление вращения
-	CANObject<uint8_t, 4> obj_controller_gear_n_roll(0x010A, 500, CAN_ERROR_DISABLED);
+	Deferred<CANObject<uint8_t, 4>> obj_controller_gear_n_roll;
 
 	// 0x010B TemperatureMotor
 	// request | timer:1000
 	// int16_t	°C	1 + 2 + 2	{ type[0] mt1[1..2] mt2[3..4] }
 	// Температура двигателей: №1 — int16, №2 — int16
-	CANObject<int16_t, 2> obj_motor_temperature(0x010B, 1000, CAN_ERROR_DISABLED);
+	Deferred<CANObject<int16_t, 2>> obj_motor_temperature;
 
 	// 0x010B TemperatureController
 	// request | timer:1000
 	// int16_t	°C	1 + 2 + 2	{ type[0] ct1[1..2] ct2[3..4] }
 	// Температура контроллеров: №1 — int16, №2 — int16
-	CANObject<int16_t, 2> obj_controller_temperature(0x010C, 1000, CAN_ERROR_DISABLED);
+	Deferred<CANObject<int16_t, 2>> obj_controller_temperature;
 
 	// 0x010C Odometer
 	// request | timer:5000
 	// uint32_t 100м 1 + 4 { type[0] m[1..4] }
 	// Одометр (общий для авто), в сотнях метров
-	CANObject<uint32_t, 1> obj_controller_odometer(0x010D, 5000, CAN_ERROR_DISABLED);
+	Deferred<CANObject<uint32_t, 1>> obj_controller_odometer;
+	
+	// 0x010E EnergyTraction
+	// request | timer:1000
+	// uint16_t Вт*ч 1 + 2 + 2 { type[0] m1[1..2] m2[3..4] }
+	// Энергия, потраченная на тягу, с переполнением: контроллер №1 — uint16, контроллер №2 — uint16
+	Deferred<CANObject<uint16_t, 2>> obj_energy_traction;
+	
+	// 0x010F EnergyRegen
+	// request | timer:1000
+	// uint16_t Вт*ч 1 + 2 + 2 { type[0] m1[1..2] m2[3..4] }
+	// Энергия рекуперации, с переполнением: контроллер №1 — uint16, контроллер №2 — uint16
+	Deferred<CANObject<uint16_t, 2>> obj_energy_regen;
+	
+	// 0x0110 ChargeTraction
+	// request | timer:1000
+	// uint16_t 100мА*ч 1 + 2 + 2 { type[0] m1[1..2] m2[3..4] }
+	// Заряд, потраченный на тягу, с переполнением: контроллер №1 — uint16, контроллер №2 — uint16
+	Deferred<CANObject<uint16_t, 2>> obj_charge_traction;
+	
+	// 0x0111 ChargeRegen
+	// request | timer:1000
+	// uint16_t 100мА*ч 1 + 2 + 2 { type[0] m1[1..2] m2[3..4] }
+	// Заряд рекуперации, с переполнением: контроллер №1 — uint16, контроллер №2 — uint16
+	Deferred<CANObject<uint16_t, 2>> obj_charge_regen;
+	
+	// 0x0113 LinkStats
+	// request | timer:250
+	// uint8_t 1 + 6 { type[0] motor[1] counter[2] value[3..6] }
+	// Счётчики связи с контроллерами, передаются по очереди. counter: motor_link_stats_t::counter_t
+	// либо 0x80 | адрес для числа валидных пакетов по адресу (только ненулевые). Значение uint32.
+	Deferred<CANObject<uint8_t, 6>> obj_link_stats;
+	
+	// 0x0114 LoopStats
+	// request | timer:500
+	// uint8_t 1 + 7 { type[0] idx[1] data[2..7] }
+	// Гистограмма длительности итераций основного цикла и зависания модулей, передаются по очереди. См. LoopMonitor.h.
+	Deferred<CANObject<uint8_t, 7>> obj_loop_stats;
+	
+	// 0x0115 FlightRecorder
+	// event
+	// uint8_t 1 + 7 { type[0] record[1] part[2] data[3..7] }
+	// Выгрузка бортового самописца по запросу BlockCfg 0x04: события, затем пакеты, от старых к новым. См. FlightRecorder.h.
+	CANObject<uint8_t, 7> obj_flight_recorder(0x0115, CAN_TIMER_DISABLED, CAN_ERROR_DISABLED);
+	
+	// 0x0116 Freshness
+	// request | timer:250
+	// uint8_t 1 + 7 { type[0] object[1] p50[2..3] p99[4..5] max[6..7] }
+	// Возраст данных контроллера в момент передачи, мс: object - младший байт ID объекта 0x0104..0x010D,
+	// объекты передаются по очереди. См. Freshness.h.
+	Deferred<CANObject<uint8_t, 7>> obj_freshness;
+	
+	// 0x0117 SupplyVoltage
+	// request | timer:1000
+	// uint16_t мВ 1 + 2 { type[0] voltage[1..2] }
+	// Напряжение питания платы в мВ, АЦП с передискретизацией и IIR. См. Supply.h.
+	Deferred<CANObject<uint16_t, 1>> obj_supply_voltage;
+	
+	// 0x0118 MemoryStats
+	// request | timer:1000 | event
+	// uint8_t 1 + 6 { type[0] stack_used[1..2] headroom[3..4] module[5] module_ram[6] }
+	// Глубина стека и запас RAM в байтах, статическая память модуля в единицах по 16 байт; модули
+	// передаются по очереди, при малом запасе - событием. См. MemoryMonitor.h.
+	Deferred<CANObject<uint8_t, 6>> obj_memory_stats;
+	
+#if defined(PROFILER_ENABLED)
+	// 0x0112 Profiler (Debug only)
+	// request | timer:250
+	// uint8_t 1 + 7 { type[0] probe[1] min[2..3] max[4..5] mean[6..7] }
+	// Такты CPU точки профилирования, точки передаются по очереди. См. Profiler.h.
+	Deferred<CANObject<uint8_t, 7>> obj_profiler;
+#endif
+	
+	//*********************************************************************
+	// BlockCfg parameters
+	//*********************************************************************
+	// SET: { type[0] param[1] value[2..] }, value is little-endian.
+	// Persistent parameters are the keys of Config (Config.h): 0x01, 0x02, 0x07..0x0C and 0x0F..0x11.
+	// SET_OUT of a key that takes effect after a restart (CAN periods) carries one more byte 0x01: { param[1] value[2..] restart[..] }.
+	enum block_cfg_param_t : uint8_t
+	{
+		BLOCK_CFG_WHEEL_DIAMETER = 0x01,	// uint16_t, мм.
+		BLOCK_CFG_GEAR_RATIO = 0x02,		// uint16_t, x100.
+		BLOCK_CFG_ENERGY_RESET = 0x03,		// Без значения, обнуляет счётчики энергии и заряда.
+		BLOCK_CFG_RECORDER_DUMP = 0x04,		// uint8_t, выгрузка самописца: FlightRecorder::dump_t.
+		BLOCK_CFG_TRACE = 0x05,				// uint8_t, 1 - включить двоичную трассу в отладочный UART, 0 - выключить.
+		BLOCK_CFG_CAPTURE = 0x06,			// uint8_t, 1 - писать в трассу приём от контроллеров, 0 - нет.
+		BLOCK_CFG_CONFIG_GET = 0x0D,		// uint8_t key, ответ { param[1] key[2] value[3..] }.
+		BLOCK_CFG_CONFIG_RESET = 0x0E,		// Без значения, все ключи Config по умолчанию.
+	};
+	
+	/// @brief Copies the energy and charge counters of both motors to their CANObjects.
+	inline void PublishEnergy()
+	{
+		for(uint8_t idx = 0; idx < Energy::CFG_MotorCount; ++idx)
+		{
+			obj_energy_traction().SetValue(idx, Energy::Get(idx, Energy::COUNTER_ENERGY_TRACTION), CAN_TIMER_TYPE_NORMAL);
+			obj_energy_regen().SetValue(idx, Energy::Get(idx, Energy::COUNTER_ENERGY_REGEN), CAN_TIMER_TYPE_NORMAL);
+			obj_charge_traction().SetValue(idx, Energy::Get(idx, Energy::COUNTER_CHARGE_TRACTION), CAN_TIMER_TYPE_NORMAL);
+			obj_charge_regen().SetValue(idx, Energy::Get(idx, Energy::COUNTER_CHARGE_REGEN), CAN_TIMER_TYPE_NORMAL);
+		}
+		
+		return;
+	}
+	
+	// Energy reset requested from the CAN interrupt, applied in Loop() next to the integration.
+	volatile bool energy_reset = false;
 	
+	/// @brief BlockCfg SET handler: applies the parameter and echoes the frame back.
+	/// Config keys, Config reset and energy reset are only queued here and applied by Config::Loop() and Loop().
+	/// @param can_frame Incoming frame, reused as the response.
+	/// @param error Error descriptor (unused).
+	/// @return CAN_RESULT_CAN_FRAME on success, CAN_RESULT_IGNORE for unknown or invalid parameters.
+	can_result_t block_cfg_set_handler(can_frame_t &can_frame, can_error_t & /* error */)
+	{
+		if(can_frame.raw_data_length < 2) return CAN_RESULT_IGNORE;
+		
+		uint8_t value8 = (can_frame.raw_data_length >= 3) ? can_frame.data[1] : 0;
+		uint16_t value16 = (can_frame.raw_data_length >= 4) ? (can_frame.data[1] | (can_frame.data[2] << 8)) : 0;
+		
+		FlightRecorder::Record(FlightRecorder::EVENT_CONFIG, 0, can_frame.data, can_frame.raw_data_length - 1);
+		
+		bool result = false;
+		uint16_t value = 0;
+		uint8_t size = 0;
+		switch(can_frame.data[0])
+		{
+			case BLOCK_CFG_ENERGY_RESET: { energy_reset = true; result = true; break; }
+			case BLOCK_CFG_RECORDER_DUMP: { FlightRecorder::RequestDump(value8); result = (value8 != 0); break; }
+			case BLOCK_CFG_TRACE: { Trace::SetEnabled(value8 != 0); result = (can_frame.raw_data_length >= 3); break; }
+			case BLOCK_CFG_CAPTURE: { Trace::SetCapture(value8 != 0); result = (can_frame.raw_data_length >= 3); break; }
+			case BLOCK_CFG_CONFIG_GET:
+			{
+				result = (can_frame.raw_data_length >= 3 && Config::Get(value8, value, size) == true);
+				if(result == false) break;
+				
+				can_frame.data[2] = value & 0xFF;
+				can_frame.data[3] = value >> 8;
+				can_frame.raw_data_length = 3 + size;
+				break;
+			}
+			case BLOCK_CFG_CONFIG_RESET: { result = Config::RequestReset(); break; }
+			default:
+			{
+				// Config keys: the value has the size of the key.
+				result = (Config::Get(can_frame.data[0], value, size) == true && can_frame.raw_data_length >= 2 + size &&
+					Config::RequestSet(can_frame.data[0], (size == 1) ? value8 : value16) == true);
+				if(result == false || Config::Restart(can_frame.data[0]) == false) break;
+				
+				can_frame.data[1 + size] = 0x01;
+				can_frame.raw_data_length = 3 + size;
+				break;
+			}
+		}
+		if(result == false) return CAN_RESULT_IGNORE;
+		
+		can_frame.initialized = true;
+		can_frame.function_id = CAN_FUNC_SET_OUT_OK;
+		
+		return CAN_RESULT_CAN_FRAME;
+	}
+	
+	/// @brief Announces the block right after start: BlockInfo goes out with the first Loop() instead of waiting for its timer.
+	inline void Announce()
+	{
+		obj_block_info.SetValue(0, obj_block_info.GetValue(0), CAN_TIMER_TYPE_NONE, CAN_EVENT_TYPE_NORMAL);
+
+		return;
+	}
 	
 	inline void Setup()
 	{
+		obj_controller_errors.Construct(0x0104, Config::values.can_period_fast, CAN_ERROR_DISABLED);
+		obj_controller_rpm.Construct(0x0105, Config::values.can_period_fast, CAN_ERROR_DISABLED);
+		obj_controller_speed.Construct(0x0106, Config::values.can_period_fast, CAN_ERROR_DISABLED);
+		obj_controller_voltage.Construct(0x0107, Config::values.can_period_medium, CAN_ERROR_DISABLED);
+		obj_controller_current.Construct(0x0108, Config::values.can_period_medium, CAN_ERROR_DISABLED);
+		obj_controller_power.Construct(0x0109, Config::values.can_period_medium, CAN_ERROR_DISABLED);
+		obj_controller_gear_n_roll.Construct(0x010A, Config::values.can_period_medium, CAN_ERROR_DISABLED);
+		obj_motor_temperature.Construct(0x010B, Config::values.can_period_slow, CAN_ERROR_DISABLED);
+		obj_controller_temperature.Construct(0x010C, Config::values.can_period_slow, CAN_ERROR_DISABLED);
+		obj_controller_odometer.Construct(0x010D, Config::values.can_period_odometer, CAN_ERROR_DISABLED);
+		obj_energy_traction.Construct(0x010E, Config::values.can_period_slow, CAN_ERROR_DISABLED);
+		obj_energy_regen.Construct(0x010F, Config::values.can_period_slow, CAN_ERROR_DISABLED);
+		obj_charge_traction.Construct(0x0110, Config::values.can_period_slow, CAN_ERROR_DISABLED);
+		obj_charge_regen.Construct(0x0111, Config::values.can_period_slow, CAN_ERROR_DISABLED);
+		obj_link_stats.Construct(0x0113, Config::values.can_period_diag, CAN_ERROR_DISABLED);
+		obj_loop_stats.Construct(0x0114, 2 * Config::values.can_period_diag, CAN_ERROR_DISABLED);
+		obj_freshness.Construct(0x0116, Config::values.can_period_diag, CAN_ERROR_DISABLED);
+		obj_supply_voltage.Construct(0x0117, 4 * Config::values.can_period_diag, CAN_ERROR_DISABLED);
+		obj_memory_stats.Construct(0x0118, 4 * Config::values.can_period_diag, CAN_ERROR_DISABLED);
+#if defined(PROFILER_ENABLED)
+		obj_profiler.Construct(0x0112, Config::values.can_period_diag, CAN_ERROR_DISABLED);
+#endif
+		
 		set_block_info_params(obj_block_info);
 		set_block_health_params(obj_block_health);
 		set_block_features_params(obj_block_features);
 		set_block_error_params(obj_block_error);
 		
+		obj_block_features.RegisterFunctionSet(&block_cfg_set_handler);
+		
+		Config::Subscribe(Config::KEY_WHEEL_DIAMETER, []() { Speed::SetWheelDiameter(Config::values.wheel_diameter); });
+		Config::Subscribe(Config::KEY_GEAR_RATIO, []() { Speed::SetGearRatio(Config::values.gear_ratio); });
+		
 		can_manager.RegisterObject(obj_block_info);
 		can_manager.RegisterObject(obj_block_health);
 		can_manager.RegisterObject(obj_block_features);
 		can_manager.RegisterObject(obj_block_error);
-		can_manager.RegisterObject(obj_controller_errors);
-		can_manager.RegisterObject(obj_controller_rpm);
-		can_manager.RegisterObject(obj_controller_speed);
-		can_manager.RegisterObject(obj_controller_voltage);
-		can_manager.RegisterObject(obj_controller_current);
-		can_manager.RegisterObject(obj_controller_power);
-		can_manager.RegisterObject(obj_controller_gear_n_roll);
-		can_manager.RegisterObject(obj_motor_temperature);
-		can_manager.RegisterObject(obj_controller_temperature);
-		can_manager.RegisterObject(obj_controller_odometer);
+		can_manager.RegisterObject(obj_controller_errors());
+		can_manager.RegisterObject(obj_controller_rpm());
+		can_manager.RegisterObject(obj_controller_speed());
+		can_manager.RegisterObject(obj_controller_voltage());
+		can_manager.RegisterObject(obj_controller_current());
+		can_manager.RegisterObject(obj_controller_power());
+		can_manager.RegisterObject(obj_controller_gear_n_roll());
+		can_manager.RegisterObject(obj_motor_temperature());
+		can_manager.RegisterObject(obj_controller_temperature());
+		can_manager.RegisterObject(obj_controller_odometer());
+		can_manager.RegisterObject(obj_energy_traction());
+		can_manager.RegisterObject(obj_energy_regen());
+		can_manager.RegisterObject(obj_charge_traction());
+		can_manager.RegisterObject(obj_charge_regen());
+		can_manager.RegisterObject(obj_link_stats());
+		can_manager.RegisterObject(obj_loop_stats());
+		can_manager.RegisterObject(obj_flight_recorder);
+		can_manager.RegisterObject(obj_freshness());
+		can_manager.RegisterObject(obj_supply_voltage());
+		can_manager.RegisterObject(obj_memory_stats());
+#if defined(PROFILER_ENABLED)
+		can_manager.RegisterObject(obj_profiler());
+#endif
 		
 		// Set versions data to block_info.
 		obj_block_info.SetValue(0, (About::board_type << 3 | About::board_ver), CAN_TIMER_TYPE_NORMAL);
@@ -146,7 +386,53 @@ namespace CANLib
 	
 	inline void Loop(uint32_t &current_time)
 	{
-		can_manager.Process(current_time);
+		{
+			PROFILER_SCOPE(Profiler::PROBE_CAN_PROCESS);
+			can_manager.Process(current_time);
+		}
+		
+		if(energy_reset == true)
+		{
+			energy_reset = false;
+			Energy::Reset();
+			PublishEnergy();
+			Storage::Request();
+		}
+		
+		// Flight recorder dump, one frame per CFG_DumpPeriod.
+		static uint32_t recorder_time = 0;
+		if(current_time - recorder_time > FlightRecorder::CFG_DumpPeriod)
+		{
+			recorder_time = current_time;
+			
+			uint8_t data[7];
+			if(FlightRecorder::PackNext(data) == true)
+			{
+				for(uint8_t i = 0; i < sizeof(data); ++i)
+				{
+					obj_flight_recorder.SetValue(i, data[i], CAN_TIMER_TYPE_NONE, (i == sizeof(data) - 1) ? CAN_EVENT_TYPE_NORMAL : CAN_EVENT_TYPE_NONE);
+				}
+			}
+		}
+		
+#if defined(PROFILER_ENABLED)
+		// Profiler probes round-robin.
+		static uint32_t profiler_time = 0;
+		static uint8_t profiler_probe = 0;
+		if(current_time - profiler_time > 250)
+		{
+			profiler_time = current_time;
+			
+			uint8_t data[7];
+			Profiler::Pack((Profiler::probe_id_t)profiler_probe, data);
+			for(uint8_t i = 0; i < sizeof(data); ++i)
+			{
+				obj_profiler().SetValue(i, data[i], CAN_TIMER_TYPE_NORMAL);
+			}
+			
+			if(++profiler_probe >= Profiler::PROBE_COUNT) profiler_probe = 0;
+		}
+#endif
 		
 		// Set uptime to block_info.
 		static uint32_t iter = 0;
@@ -170,10 +456,10 @@ namespace CANLib
 			//uint16_t rand1 = current_time ^ current_time / 2;
 			//uint16_t rand2 = current_time ^ current_time / 4;
 
-			//obj_controller_voltage.SetValue(0, rand1, CAN_TIMER_TYPE_NORMAL);
-			//obj_controller_voltage.SetValue(1, rand1+50, CAN_TIMER_TYPE_NORMAL);
-			//obj_controller_current.SetValue(0, rand2, CAN_TIMER_TYPE_NORMAL);
-			//obj_controller_current.SetValue(1, rand2-50, CAN_TIMER_TYPE_NORMAL);
+			//obj_controller_voltage().SetValue(0, rand1, CAN_TIMER_TYPE_NORMAL);
+			//obj_controller_voltage().SetValue(1, rand1+50, CAN_TIMER_TYPE_NORMAL);
+			//obj_controller_current().SetValue(0, rand2, CAN_TIMER_TYPE_NORMAL);
+			//obj_controller_current().SetValue(1, rand2-50, CAN_TIMER_TYPE_NORMAL);
 		}
 
 		current_time = HAL_GetTick();
@@ -0,0 +1,342 @@
+/*
+	Настройки блока: типизированное хранилище ключ/значение с сохранением во flash.
+
+	Ключ - номер параметра BlockCfg 0x0102 (CANLogic.h), у каждого ключа размер (1 или 2 байта),
+		допустимый диапазон и значение по умолчанию. Значения лежат в структуре values, модули
+		читают её поля напрямую: на горячем пути нет ни поиска по ключу, ни копирования.
+		Set() проверяет диапазон и при изменении вызывает обработчик ключа (Subscribe()),
+		который применяет значение к модулю. Периоды CAN применяются при старте, см. CANLib::Setup():
+		у таких ключей restart, и ответ BlockCfg SET сообщает, что нужен перезапуск.
+		Из прерывания (BlockCfg SET) ключ не меняется: RequestSet() и RequestReset() только проверяют
+		запрос и кладут его в очередь, а Set() с обработчиками выполняет Loop() - обработчики
+		меняют состояние модулей основного цикла (Speed, Odometer) не посреди их вычислений.
+
+	Хранение - две страницы flash перед журналом пробега (Storage.h), кольцевой журнал FlashJournal.h
+		с записями по 64 байта: { seq version count pairs[count] crc }, пара - { key value[4] }.
+		Новая запись дописывается через CFG_SaveDelay мс после последнего изменения, по шагу из
+		Loop(). При загрузке берётся запись с наибольшим seq и верной CRC; ключи, которых в записи нет или которые вне диапазона, остаются по умолчанию, незнакомые
+		ключи пропускаются, поэтому список ключей можно расширять без смены CFG_Version.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <stddef.h>
+
+namespace Config
+{
+	static constexpr uint8_t CFG_PageCount = 2;							// Страниц журнала, пишутся по очереди.
+	static constexpr uint32_t CFG_PageSize = FLASH_PAGE_SIZE;
+	static constexpr uint32_t CFG_Start = Storage::CFG_Start - CFG_PageCount * CFG_PageSize;	// Страницы перед журналом пробега.
+	static constexpr uint16_t CFG_Version = 1;							// Версия формата записи.
+	static constexpr uint16_t CFG_SaveDelay = 2000;						// Задержка записи после изменения, мс.
+	static constexpr uint8_t CFG_PairsMax = 11;							// Пар в записи.
+	static constexpr uint8_t CFG_UartChunkMax = 128;					// Не больше UART_BUFFER_SIZE (main.cpp).
+	static constexpr uint16_t CFG_SupplyGain = 11000;					// Делитель питания 10к / 1к, x1000, см. Supply.h.
+	static constexpr uint16_t CFG_SupplyGainMax = 19000;				// Шкала АЦП до 62.7 В: мВ помещаются в uint16.
+	static constexpr uint8_t CFG_QueueSize = 8;							// Запросов из прерывания до Loop(), на один меньше.
+	static constexpr uint8_t CFG_ResetKey = 0x00;						// Запрос в очереди: все ключи по умолчанию.
+
+	enum key_t : uint8_t
+	{
+		KEY_WHEEL_DIAMETER = 0x01,		// uint16_t, мм.
+		KEY_GEAR_RATIO = 0x02,			// uint16_t, x100.
+		KEY_REQUEST_TIME = 0x07,		// uint16_t, мс, интервал запроса данных у контроллеров.
+		KEY_UNACTIVE_TIMEOUT = 0x08,	// uint16_t, мс, тишина контроллера до потери связи.
+		KEY_CAN_PERIOD_FAST = 0x09,		// uint16_t, мс, 0x0104..0x0106, после перезапуска.
+		KEY_CAN_PERIOD_MEDIUM = 0x0A,	// uint16_t, мс, 0x0107..0x010A, после перезапуска.
+		KEY_CAN_PERIOD_SLOW = 0x0B,		// uint16_t, мс, 0x010B, 0x010C, 0x010E..0x0111, после перезапуска.
+		KEY_UART_RX_CHUNK = 0x0C,		// uint8_t, байт, порция приёма UART контроллеров до прерывания.
+		KEY_CAN_PERIOD_ODOMETER = 0x0F,	// uint16_t, мс, 0x010D, после перезапуска.
+		KEY_CAN_PERIOD_DIAG = 0x10,		// uint16_t, мс, 0x0112, 0x0113, 0x0116; 0x0114 - x2, 0x0117 и 0x0118 - x4, после перезапуска.
+		KEY_SUPPLY_GAIN = 0x11,			// uint16_t, x1000, коэффициент делителя напряжения питания (калибровка).
+	};
+
+	struct values_t
+	{
+		uint16_t wheel_diameter;
+		uint16_t gear_ratio;
+		uint16_t request_time;
+		uint16_t unactive_timeout;
+		uint16_t can_period_fast;
+		uint16_t can_period_medium;
+		uint16_t can_period_slow;
+		uint8_t uart_rx_chunk;
+		uint16_t can_period_odometer;
+		uint16_t can_period_diag;
+		uint16_t supply_gain;
+	};
+
+	struct param_t
+	{
+		key_t key;
+		uint8_t size;			// Байт: 1 или 2.
+		uint8_t offset;			// Смещение поля в values_t.
+		uint16_t min;
+		uint16_t max;
+		uint16_t def;
+		bool restart;			// Применяется после перезапуска.
+	};
+
+	static constexpr values_t defaults = { Speed::CFG_WheelDiameter, Speed::CFG_GearRatio, 550, 500, 250, 500, 1000, CFG_UartChunkMax, 5000, 250, CFG_SupplyGain };
+
+	static constexpr param_t params[] =
+	{
+		{ KEY_WHEEL_DIAMETER, 2, offsetof(values_t, wheel_diameter), Speed::CFG_WheelDiameterMin, Speed::CFG_WheelDiameterMax, defaults.wheel_diameter, false },
+		{ KEY_GEAR_RATIO, 2, offsetof(values_t, gear_ratio), Speed::CFG_GearRatioMin, Speed::CFG_GearRatioMax, defaults.gear_ratio, false },
+		{ KEY_REQUEST_TIME, 2, offsetof(values_t, request_time), 100, 5000, defaults.request_time, false },
+		{ KEY_UNACTIVE_TIMEOUT, 2, offsetof(values_t, unactive_timeout), 100, 5000, defaults.unactive_timeout, false },
+		{ KEY_CAN_PERIOD_FAST, 2, offsetof(values_t, can_period_fast), 50, 5000, defaults.can_period_fast, true },
+		{ KEY_CAN_PERIOD_MEDIUM, 2, offsetof(values_t, can_period_medium), 50, 5000, defaults.can_period_medium, true },
+		{ KEY_CAN_PERIOD_SLOW, 2, offsetof(values_t, can_period_slow), 50, 10000, defaults.can_period_slow, true },
+		{ KEY_UART_RX_CHUNK, 1, offsetof(values_t, uart_rx_chunk), 16, CFG_UartChunkMax, defaults.uart_rx_chunk, false },
+		{ KEY_CAN_PERIOD_ODOMETER, 2, offsetof(values_t, can_period_odometer), 250, 60000, defaults.can_period_odometer, true },
+		{ KEY_CAN_PERIOD_DIAG, 2, offsetof(values_t, can_period_diag), 50, 5000, defaults.can_period_diag, true },
+		{ KEY_SUPPLY_GAIN, 2, offsetof(values_t, supply_gain), 1000, CFG_SupplyGainMax, defaults.supply_gain, false },
+	};
+	static constexpr uint8_t CFG_ParamCount = sizeof(params) / sizeof(params[0]);
+	static_assert(CFG_ParamCount <= CFG_PairsMax, "Every parameter must fit into one record!");
+
+	using hook_t = void (*)();
+
+	struct __attribute__((__packed__)) pair_t
+	{
+		uint8_t key;
+		uint32_t value;
+	};
+
+	struct __attribute__((__packed__)) record_t
+	{
+		uint32_t seq;			// Порядковый номер записи.
+		uint16_t version;		// Версия формата.
+		uint8_t count;			// Заполненных пар.
+		pair_t pairs[CFG_PairsMax];
+		uint16_t crc;			// CRC-16/CCITT всех предыдущих полей.
+
+		bool Valid() const
+		{
+			return version == CFG_Version && count <= CFG_PairsMax;
+		}
+	};
+	static_assert(sizeof(record_t) == 64, "Record size must stay 64 bytes!");
+
+	values_t values = defaults;
+	hook_t hooks[CFG_ParamCount] = {};
+
+	struct request_t
+	{
+		uint8_t key;			// Ключ или CFG_ResetKey.
+		uint16_t value;
+	};
+
+	FlashJournal<record_t, CFG_Start, CFG_PageCount> journal;
+	request_t queue[CFG_QueueSize] = {};
+	volatile uint8_t queue_head = 0;	// Пишет прерывание.
+	volatile uint8_t queue_tail = 0;	// Читает Loop().
+	bool dirty = false;				// Есть несохранённые изменения.
+	uint32_t change_time = 0;		// Время последнего изменения, мс.
+
+	inline const param_t *_Find(uint8_t key, uint8_t &idx)
+	{
+		for(idx = 0; idx < CFG_ParamCount; ++idx)
+		{
+			if(params[idx].key == key) return &params[idx];
+		}
+
+		return nullptr;
+	}
+
+	inline uint16_t _Read(const param_t &param)
+	{
+		const uint8_t *field = (const uint8_t *)&values + param.offset;
+
+		return (param.size == 1) ? *field : *(const uint16_t *)field;
+	}
+
+	inline void _Write(const param_t &param, uint16_t value)
+	{
+		uint8_t *field = (uint8_t *)&values + param.offset;
+		if(param.size == 1) *field = value;
+		else *(uint16_t *)field = value;
+
+		return;
+	}
+
+	/*
+		Значение ключа key в value, false - ключ неизвестен.
+	*/
+	inline bool Get(uint8_t key, uint16_t &value, uint8_t &size)
+	{
+		uint8_t idx;
+		const param_t *param = _Find(key, idx);
+		if(param == nullptr) return false;
+
+		value = _Read(*param);
+		size = param->size;
+
+		return true;
+	}
+
+	/*
+		Ключ key применяется только после перезапуска.
+	*/
+	inline bool Restart(uint8_t key)
+	{
+		uint8_t idx;
+		const param_t *param = _Find(key, idx);
+
+		return param != nullptr && param->restart == true;
+	}
+
+	/*
+		Установка ключа key: проверка диапазона, при изменении - обработчик и отложенная запись.
+	*/
+	inline bool Set(uint8_t key, uint16_t value)
+	{
+		uint8_t idx;
+		const param_t *param = _Find(key, idx);
+		if(param == nullptr || value < param->min || value > param->max) return false;
+		if(_Read(*param) == value) return true;
+
+		_Write(*param, value);
+		if(hooks[idx] != nullptr) hooks[idx]();
+
+		dirty = true;
+		change_time = HAL_GetTick();
+
+		return true;
+	}
+
+	/*
+		Возврат всех ключей к значениям по умолчанию.
+	*/
+	inline void Reset()
+	{
+		for(uint8_t i = 0; i < CFG_ParamCount; ++i)
+		{
+			Set(params[i].key, params[i].def);
+		}
+
+		return;
+	}
+
+	inline bool _Queue(uint8_t key, uint16_t value)
+	{
+		uint8_t head = queue_head;
+		uint8_t next = (head + 1) % CFG_QueueSize;
+		if(next == queue_tail) return false;
+
+		queue[head].key = key;
+		queue[head].value = value;
+		queue_head = next;
+
+		return true;
+	}
+
+	/*
+		(Interrupt) Запрос установки ключа key, применяется в Loop().
+		false - ключ неизвестен, значение вне диапазона или очередь полна.
+	*/
+	inline bool RequestSet(uint8_t key, uint16_t value)
+	{
+		uint8_t idx;
+		const param_t *param = _Find(key, idx);
+		if(param == nullptr || value < param->min || value > param->max) return false;
+
+		return _Queue(key, value);
+	}
+
+	/*
+		(Interrupt) Запрос возврата всех ключей к значениям по умолчанию, применяется в Loop().
+	*/
+	inline bool RequestReset()
+	{
+		return _Queue(CFG_ResetKey, 0);
+	}
+
+	/*
+		Обработчик применения ключа key, вызывается сразу с текущим значением и при каждом изменении.
+	*/
+	inline void Subscribe(key_t key, hook_t hook)
+	{
+		uint8_t idx;
+		if(_Find(key, idx) == nullptr) return;
+
+		hooks[idx] = hook;
+		hook();
+
+		return;
+	}
+
+	/*
+		Начинает запись текущих значений.
+	*/
+	inline void Write()
+	{
+		record_t record;
+		memset(&record, 0xFF, sizeof(record));
+		record.version = CFG_Version;
+		record.count = CFG_ParamCount;
+		for(uint8_t i = 0; i < CFG_ParamCount; ++i)
+		{
+			record.pairs[i].key = params[i].key;
+			record.pairs[i].value = _Read(params[i]);
+		}
+
+		journal.Write(record);
+
+		return;
+	}
+
+	/*
+		Загрузка последней целой записи, до Setup() модулей, подписанных на ключи.
+	*/
+	inline void Setup()
+	{
+		const record_t *ptr = journal.Setup();
+		if(ptr == nullptr) return;
+
+		for(uint8_t n = 0; n < ptr->count; ++n)
+		{
+			uint8_t param_idx;
+			const param_t *param = _Find(ptr->pairs[n].key, param_idx);
+			uint32_t value = ptr->pairs[n].value;
+			if(param == nullptr || value < param->min || value > param->max) continue;
+
+			_Write(*param, value);
+		}
+
+		return;
+	}
+
+	inline void Loop(uint32_t &current_time)
+	{
+		bool applied = (queue_tail != queue_head);
+		while(queue_tail != queue_head)
+		{
+			const request_t &request = queue[queue_tail];
+			if(request.key == CFG_ResetKey) Reset();
+			else Set(request.key, request.value);
+			queue_tail = (queue_tail + 1) % CFG_QueueSize;
+		}
+
+		if(journal.Busy() == true)
+		{
+			journal.Step();
+		}
+		else if(dirty == true && current_time - change_time > CFG_SaveDelay)
+		{
+			dirty = false;
+			Write();
+		}
+		else if(applied == false)
+		{
+			return;
+		}
+
+		current_time = HAL_GetTick();
+
+		return;
+	}
+}
@@ -0,0 +1,115 @@
+/*
+	Счётчики энергии и заряда двигателей, раздельно тяга и рекуперация.
+
+	Интегрирование по пакетам 0x01: ток и напряжение пакета действуют на интервале
+		от предыдущего пакета до времени приёма текущего. Произведения накапливаются
+		в сырых единицах контроллера (ток 0.25 А, напряжение 0.1 В) без округления,
+		в единицы счётчика переносится только целая часть, остаток сохраняется.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+namespace Energy
+{
+	static constexpr uint8_t CFG_MotorCount = 2;
+	static constexpr uint32_t CFG_MaxGap = 2000;			// Разрыв мс между пакетами, после которого интервал не учитывается.
+	static constexpr uint32_t CFG_EnergyUnit = 144000000;	// 1 Вт*ч в единицах 0.25А * 0.1В * мс.
+	static constexpr uint32_t CFG_ChargeUnit = 1440000;		// 0.1 А*ч в единицах 0.25А * мс.
+
+	enum counter_idx_t : uint8_t
+	{
+		COUNTER_ENERGY_TRACTION = 0,	// Вт*ч
+		COUNTER_ENERGY_REGEN = 1,		// Вт*ч
+		COUNTER_CHARGE_TRACTION = 2,	// 100 мА*ч
+		COUNTER_CHARGE_REGEN = 3,		// 100 мА*ч
+		COUNTER_COUNT = 4
+	};
+
+	struct counter_t
+	{
+		uint32_t value;		// Значение в единицах счётчика.
+		uint64_t rem;		// Остаток в сырых единицах.
+	};
+
+	struct motor_t
+	{
+		counter_t counters[COUNTER_COUNT];
+		uint32_t last_time;
+		bool init;
+	};
+
+	motor_t motors[CFG_MotorCount] = {};
+
+	inline void _Add(counter_t &counter, uint64_t inc, uint32_t unit)
+	{
+		counter.rem += inc;
+		if(counter.rem >= unit)
+		{
+			counter.value += counter.rem / unit;
+			counter.rem %= unit;
+		}
+
+		return;
+	}
+
+	/*
+		Добавляет отсчёт тока и напряжения двигателя idx (0..1), принятый в момент time.
+	*/
+	inline void Integrate(uint8_t idx, int16_t current, uint16_t voltage, uint32_t time)
+	{
+		if(idx >= CFG_MotorCount) return;
+
+		motor_t &motor = motors[idx];
+		uint32_t dt = time - motor.last_time;
+
+		if(motor.init == true && dt <= CFG_MaxGap && current != 0)
+		{
+			uint32_t charge = (uint32_t)abs(current) * dt;
+			uint64_t energy = (uint64_t)((uint32_t)abs(current) * voltage) * dt;
+			bool regen = (current < 0);
+
+			_Add(motor.counters[regen ? COUNTER_ENERGY_REGEN : COUNTER_ENERGY_TRACTION], energy, CFG_EnergyUnit);
+			_Add(motor.counters[regen ? COUNTER_CHARGE_REGEN : COUNTER_CHARGE_TRACTION], charge, CFG_ChargeUnit);
+		}
+
+		motor.last_time = time;
+		motor.init = true;
+
+		return;
+	}
+
+	inline uint32_t Get(uint8_t idx, counter_idx_t counter)
+	{
+		return motors[idx].counters[counter].value;
+	}
+
+	/*
+		Восстанавливает значение счётчика, остаток обнуляется.
+	*/
+	inline void Restore(uint8_t idx, counter_idx_t counter, uint32_t value)
+	{
+		motors[idx].counters[counter].value = value;
+		motors[idx].counters[counter].rem = 0;
+
+		return;
+	}
+
+	/*
+		Обнуляет все счётчики.
+	*/
+	inline void Reset()
+	{
+		for(uint8_t idx = 0; idx < CFG_MotorCount; ++idx)
+		{
+			for(uint8_t counter = 0; counter < COUNTER_COUNT; ++counter)
+			{
+				Restore(idx, (counter_idx_t)counter, 0);
+			}
+		}
+
+		return;
+	}
+}
@@ -0,0 +1,34 @@
+/*
+	Фильтры телеметрии контроллеров перед публикацией в CAN.
+
+	Настройки на сигнал: { окно медианы, сдвиг IIR, ограничение изменения за отсчёт }.
+		Фильтруются сырые значения пакета, счётчики энергии считаются по нефильтрованным.
+*/
+
+#pragma once
+
+#include <SignalFilter.h>
+
+namespace Filters
+{
+	static constexpr uint8_t CFG_MotorCount = 2;
+
+	// Напряжение: медиана 3, alpha = 1/4.
+	SignalFilter voltage[CFG_MotorCount] = { {3, 2, 0}, {3, 2, 0} };
+
+	// Ток: медиана 3, alpha = 1/2.
+	SignalFilter current[CFG_MotorCount] = { {3, 1, 0}, {3, 1, 0} };
+
+	/*
+		Сбрасывает фильтры двигателя idx (0..1), например после потери связи.
+	*/
+	inline void Reset(uint8_t idx)
+	{
+		if(idx >= CFG_MotorCount) return;
+
+		voltage[idx].Reset();
+		current[idx].Reset();
+
+		return;
+	}
+}
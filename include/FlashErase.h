@@ -0,0 +1,353 @@
+/*
+	Стирание страницы flash без потери приёма от контроллеров и из CAN.
+
+	Стирание страницы - 20..40 мс (tERASE по datasheet), всё это время выборка из flash стоит:
+		код во flash, включая обработчики прерываний HAL, не выполняется, и USART2/3 на 19200
+		потеряли бы до ~75 байт. Поэтому само стирание (_Run) и обработчики на его время лежат
+		в RAM (секция .RamFunc, копируется в RAM вместе с .data):
+		- таблица векторов переключается на копию vectors в RAM: USART2/3, CAN RX0 и SysTick -
+		  короткие обработчики в RAM, остальные прерывания запрещены в NVIC и ждут конца стирания;
+		- обработчик USART складывает байты в capture.uart с отметкой времени порций, обработчик
+		  CAN - кадры FIFO0 в capture.can, SysTick продолжает счёт HAL_GetTick();
+		- после стирания таблица и NVIC восстанавливаются, и Page() из flash отдаёт принятое
+		  в обычный путь: FlashErase_UARTData() и FlashErase_CANFrame() (main.cpp).
+
+	Перед стиранием FlashErase_UARTPause() отдаёт парсеру то, что HAL уже принял в свой буфер,
+		и останавливает приём HAL, чтобы байты шли в парсер в порядке приёма. После стирания
+		FlashErase_UARTResume() снова запускает приём HAL, но прерывания USART и CAN остаются
+		запрещены в NVIC, пока не выдано принятое: новые байты ждут в DR и идут в парсер после.
+		Основной цикл на время стирания стоит (он во flash), но данные не теряются.
+		Программирование полуслова - до 70 мкс, меньше одного байта UART, его Storage и Config
+		делают как обычно.
+
+	Длительность стираний в тактах DWT - cycles / cycles_max, переполнения буферов - lost.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <stm32f1xx_hal.h>
+
+// Код, который выполняется во время стирания, - в RAM (на хосте - как обычно).
+#if defined(HAL_SHIM)
+	#define FLASH_ERASE_RAM
+#else
+	#define FLASH_ERASE_RAM __attribute__((section(".RamFunc"), noinline))
+#endif
+
+// Реализуются в main.cpp (на хосте - в native/MotorStack.cpp).
+// port - 0 для USART2 (контроллер 1), 1 для USART3 (контроллер 2).
+void FlashErase_UARTPause(uint8_t port);
+void FlashErase_UARTResume(uint8_t port);
+void FlashErase_UARTData(uint8_t port, uint8_t *data, uint8_t length, uint32_t time);
+void FlashErase_CANFrame(uint16_t id, uint8_t *data, uint8_t length);
+
+namespace FlashErase
+{
+	static constexpr uint8_t CFG_PortCount = 2;				// USART2 и USART3.
+	static constexpr uint8_t CFG_UartSize = 128;			// Байт на порт: 40 мс на 19200 - ~77 байт.
+	static constexpr uint8_t CFG_UartChunks = 8;			// Порций на порт, порция - байты без паузы.
+	static constexpr uint8_t CFG_ChunkGap = 2;				// Пауза мс, с которой начинается новая порция.
+	static constexpr uint8_t CFG_CANSize = 8;				// Кадров CAN.
+
+	struct uart_capture_t
+	{
+		uint8_t data[CFG_UartSize];
+		uint8_t length;
+		uint8_t chunk_end[CFG_UartChunks];		// Конец порции в data.
+		uint32_t chunk_time[CFG_UartChunks];	// Время последнего байта порции, мс.
+		uint8_t chunks;
+	};
+
+	struct can_capture_t
+	{
+		uint16_t id;
+		uint8_t length;
+		uint8_t data[8];
+	};
+
+	struct capture_t
+	{
+		uart_capture_t uart[CFG_PortCount];
+		can_capture_t can[CFG_CANSize];
+		uint8_t can_count;
+	};
+
+	capture_t capture = {};
+	volatile uint32_t lost = 0;			// Байт и кадров, не поместившихся в capture.
+	uint32_t cycles = 0;				// Длительность последнего стирания, такты.
+	uint32_t cycles_max = 0;			// Наибольшая длительность стирания, такты.
+
+	/*
+		(Interrupt) Байт порта port (0..CFG_PortCount-1), принятый во время стирания.
+	*/
+	FLASH_ERASE_RAM
+	void _CaptureUART(uint8_t port, uint8_t byte, uint32_t time)
+	{
+		uart_capture_t &uart = capture.uart[port];
+		if(uart.length >= CFG_UartSize)
+		{
+			lost++;
+			return;
+		}
+
+		bool gap = (uart.chunks == 0 || time - uart.chunk_time[uart.chunks - 1] >= CFG_ChunkGap);
+		if(gap == true && uart.chunks < CFG_UartChunks) uart.chunks++;
+
+		uart.data[uart.length++] = byte;
+		uart.chunk_end[uart.chunks - 1] = uart.length;
+		uart.chunk_time[uart.chunks - 1] = time;
+
+		return;
+	}
+
+	/*
+		(Interrupt) Кадр CAN, принятый во время стирания.
+	*/
+	FLASH_ERASE_RAM
+	void _CaptureCAN(uint16_t id, uint8_t length, uint32_t low, uint32_t high)
+	{
+		if(capture.can_count >= CFG_CANSize)
+		{
+			lost++;
+			return;
+		}
+
+		can_capture_t &frame = capture.can[capture.can_count++];
+		frame.id = id;
+		frame.length = (length > 8) ? 8 : length;
+		for(uint8_t i = 0; i < 4; ++i)
+		{
+			frame.data[i] = low >> (i * 8);
+			frame.data[i + 4] = high >> (i * 8);
+		}
+
+		return;
+	}
+
+#if defined(HAL_SHIM)
+
+	// Хост: стирание эмулирует HalShim, приём во время стирания подставляет тест (HalShim::on_flash_erase).
+	inline void _Run(uint32_t address)
+	{
+		FLASH_EraseInitTypeDef erase = {};
+		uint32_t page_error = 0;
+
+		erase.TypeErase = FLASH_TYPEERASE_PAGES;
+		erase.Banks = FLASH_BANK_1;
+		erase.PageAddress = address;
+		erase.NbPages = 1;
+
+		HAL_FLASH_Unlock();
+		HAL_FLASHEx_Erase(&erase, &page_error);
+		HAL_FLASH_Lock();
+
+		return;
+	}
+
+	inline void Setup()
+	{
+		return;
+	}
+
+#else
+
+	static constexpr uint8_t CFG_VectorCount = 16 + USBWakeUp_IRQn + 1;
+	static_assert(CFG_VectorCount <= 64, "NVIC words beyond ISER[1] are not saved!");
+
+	__attribute__((aligned(256))) uint32_t vectors[CFG_VectorCount];
+
+	FLASH_ERASE_RAM
+	void _USART2Handler()
+	{
+		uint32_t sr = USART2->SR;
+		uint8_t byte = USART2->DR;		// Чтение SR, затем DR сбрасывает и RXNE, и ORE.
+		if(sr & USART_SR_RXNE) _CaptureUART(0, byte, uwTick);
+
+		return;
+	}
+
+	FLASH_ERASE_RAM
+	void _USART3Handler()
+	{
+		uint32_t sr = USART3->SR;
+		uint8_t byte = USART3->DR;
+		if(sr & USART_SR_RXNE) _CaptureUART(1, byte, uwTick);
+
+		return;
+	}
+
+	FLASH_ERASE_RAM
+	void _CANHandler()
+	{
+		if(CAN1->RF0R & CAN_RF0R_FOVR0) lost++;
+		while(CAN1->RF0R & CAN_RF0R_FMP0)
+		{
+			CAN_FIFOMailBox_TypeDef &box = CAN1->sFIFOMailBox[0];
+			if((box.RIR & CAN_RI0R_IDE) == 0)
+			{
+				_CaptureCAN(box.RIR >> CAN_RI0R_STID_Pos, box.RDTR & CAN_RDT0R_DLC, box.RDLR, box.RDHR);
+			}
+			CAN1->RF0R = CAN_RF0R_RFOM0;
+		}
+		CAN1->RF0R = CAN_RF0R_FULL0 | CAN_RF0R_FOVR0;
+
+		return;
+	}
+
+	FLASH_ERASE_RAM
+	void _SysTickHandler()
+	{
+		uwTick += uwTickFreq;
+
+		return;
+	}
+
+	/*
+		Любое другое прерывание: запрещаем его до конца стирания, запрет снимет восстановление NVIC.
+	*/
+	FLASH_ERASE_RAM
+	void _OtherHandler()
+	{
+		uint32_t irq = (__get_IPSR() & 0x1FF) - 16;
+		NVIC->ICER[irq >> 5] = 1UL << (irq & 0x1F);
+
+		return;
+	}
+
+	/*
+		Маска приёмных прерываний (USART2/3, CAN RX0) в слове word регистров NVIC ISER/ICER.
+	*/
+	constexpr uint32_t _RXMask(uint8_t word)
+	{
+		return ((USART2_IRQn / 32 == word) ? (1UL << (USART2_IRQn % 32)) : 0) |
+			((USART3_IRQn / 32 == word) ? (1UL << (USART3_IRQn % 32)) : 0) |
+			((USB_LP_CAN1_RX0_IRQn / 32 == word) ? (1UL << (USB_LP_CAN1_RX0_IRQn % 32)) : 0);
+	}
+
+	/*
+		Стирание страницы address целиком из RAM: прерывания на это время обслуживает таблица vectors.
+		После возврата приёмные прерывания USART2/3 и CAN RX0 остаются запрещены в NVIC, их
+		разрешает Page() после выдачи принятого.
+	*/
+	FLASH_ERASE_RAM __attribute__((long_call))
+	void _Run(uint32_t address)
+	{
+		// Константы, а не таблица: чтение .rodata из flash во время стирания встанет до его конца.
+		constexpr uint32_t rx_low = _RXMask(0);
+		constexpr uint32_t rx_high = _RXMask(1);
+
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+
+		uint32_t enabled[2] = { NVIC->ISER[0], NVIC->ISER[1] };
+		NVIC->ICER[0] = enabled[0] & ~rx_low;
+		NVIC->ICER[1] = enabled[1] & ~rx_high;
+		USART2->CR1 |= USART_CR1_RXNEIE;
+		USART3->CR1 |= USART_CR1_RXNEIE;
+
+		uint32_t vtor = SCB->VTOR;
+		SCB->VTOR = (uint32_t)vectors;
+		__DSB();
+		__ISB();
+
+		if(FLASH->CR & FLASH_CR_LOCK)
+		{
+			FLASH->KEYR = FLASH_KEY1;
+			FLASH->KEYR = FLASH_KEY2;
+		}
+		while(FLASH->SR & FLASH_SR_BSY);
+		FLASH->CR |= FLASH_CR_PER;
+		FLASH->AR = address;
+		FLASH->CR |= FLASH_CR_STRT;
+		__DSB();
+
+		// Стирание идёт: прерывания обслуживаются обработчиками из RAM.
+		__enable_irq();
+		while(FLASH->SR & FLASH_SR_BSY);
+		__disable_irq();
+
+		FLASH->CR &= ~FLASH_CR_PER;
+		FLASH->SR = FLASH_SR_EOP;
+		FLASH->CR |= FLASH_CR_LOCK;
+
+		USART2->CR1 &= ~USART_CR1_RXNEIE;
+		USART3->CR1 &= ~USART_CR1_RXNEIE;
+		SCB->VTOR = vtor;
+		__DSB();
+		__ISB();
+
+		NVIC->ICER[0] = rx_low;
+		NVIC->ICER[1] = rx_high;
+		NVIC->ISER[0] = enabled[0] & ~rx_low;
+		NVIC->ISER[1] = enabled[1] & ~rx_high;
+
+		__set_PRIMASK(primask);
+
+		return;
+	}
+
+	/*
+		Таблица векторов для стирания: исключения ядра - из текущей таблицы, прерывания - обработчики в RAM.
+	*/
+	inline void Setup()
+	{
+		const uint32_t *flash_vectors = (const uint32_t *)SCB->VTOR;
+		for(uint8_t i = 0; i < CFG_VectorCount; ++i)
+		{
+			vectors[i] = (i < 16) ? flash_vectors[i] : (uint32_t)&_OtherHandler;
+		}
+		vectors[15] = (uint32_t)&_SysTickHandler;
+		vectors[16 + USART2_IRQn] = (uint32_t)&_USART2Handler;
+		vectors[16 + USART3_IRQn] = (uint32_t)&_USART3Handler;
+		vectors[16 + USB_LP_CAN1_RX0_IRQn] = (uint32_t)&_CANHandler;
+
+		return;
+	}
+
+#endif
+
+	/*
+		Стирает страницу по адресу address, принятое во время стирания отдаётся в обычный путь.
+	*/
+	inline void Page(uint32_t address)
+	{
+		for(uint8_t port = 0; port < CFG_PortCount; ++port)
+		{
+			FlashErase_UARTPause(port);
+		}
+		memset(&capture, 0x00, sizeof(capture));
+
+		uint32_t start = DWT->CYCCNT;
+		_Run(address);
+		cycles = DWT->CYCCNT - start;
+		if(cycles > cycles_max) cycles_max = cycles;
+
+		for(uint8_t port = 0; port < CFG_PortCount; ++port)
+		{
+			FlashErase_UARTResume(port);
+		}
+
+		for(uint8_t port = 0; port < CFG_PortCount; ++port)
+		{
+			uart_capture_t &uart = capture.uart[port];
+			uint8_t begin = 0;
+			for(uint8_t chunk = 0; chunk < uart.chunks; ++chunk)
+			{
+				FlashErase_UARTData(port, &uart.data[begin], uart.chunk_end[chunk] - begin, uart.chunk_time[chunk]);
+				begin = uart.chunk_end[chunk];
+			}
+		}
+		for(uint8_t i = 0; i < capture.can_count; ++i)
+		{
+			FlashErase_CANFrame(capture.can[i].id, capture.can[i].data, capture.can[i].length);
+		}
+
+		HAL_NVIC_EnableIRQ(USART2_IRQn);
+		HAL_NVIC_EnableIRQ(USART3_IRQn);
+		HAL_NVIC_EnableIRQ(USB_LP_CAN1_RX0_IRQn);
+
+		return;
+	}
+}
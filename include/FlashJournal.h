@@ -0,0 +1,234 @@
+/*
+	Кольцевой журнал записей фиксированного размера во flash - общий для Storage.h и Config.h.
+
+	Журнал - PageCount страниц с адреса Start, record_t - запись:
+		{ uint32_t seq, ..., uint16_t crc }, seq - первое поле, crc (CRC-16/CCITT всех
+		предыдущих полей) - последнее, bool Valid() const - проверка формата (версия и т.п.).
+		Каждая новая запись дописывается в следующий слот, поэтому страницы стираются по
+		очереди и износ распределяется равномерно. Актуальная запись - с наибольшим seq среди целых.
+
+	Запись идёт шагами Step(): за шаг либо программируется одно полуслово (до 70 мкс),
+		либо стирается одна страница через FlashErase::Page() (20..40 мс, приём UART и CAN
+		при этом не теряется). Следующая страница стирается заранее, как только на текущей
+		записана CRC первой записи: при сбое питания во время записи или стирания во flash
+		всегда остаётся целая запись, а запись новой страницы начинается без стирания.
+		Flush() дописывает начатую запись без стирания - для записи при падении питания.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+inline uint16_t FlashJournalCRC16(const uint8_t *data, uint16_t length)
+{
+	uint16_t crc = 0xFFFF;
+
+	for(uint16_t idx = 0; idx < length; ++idx)
+	{
+		crc ^= (uint16_t)data[idx] << 8;
+		for(uint8_t i = 8; i != 0; --i)
+		{
+			crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+template <typename record_t, uint32_t Start, uint8_t PageCount>
+class FlashJournal
+{
+	static_assert(sizeof(record_t) % 4 == 0, "Record must be a whole number of words!");
+	static_assert(FLASH_PAGE_SIZE % sizeof(record_t) == 0, "Page must hold a whole number of records!");
+	static_assert(PageCount >= 2, "The previous page must survive while the next one is erased!");
+
+public:
+
+	static constexpr uint32_t SlotsPerPage = FLASH_PAGE_SIZE / sizeof(record_t);
+	static constexpr uint32_t SlotCount = PageCount * SlotsPerPage;
+	static constexpr uint8_t HalfWords = sizeof(record_t) / 2;
+
+	/*
+		Поиск последней целой записи, nullptr - журнал пуст. Если стирание следующей страницы
+		оборвалось сбоем питания, оно повторится первым шагом Step().
+	*/
+	const record_t *Setup()
+	{
+		// Номер оборванной записи может быть записан наполовину, поэтому ищем только среди целых;
+		// занятые слоты после последней целой записи пропускает Write().
+		bool found = false;
+		uint32_t last_seq = 0;
+		uint32_t last_slot = 0;
+		for(uint32_t idx = 0; idx < SlotCount; ++idx)
+		{
+			if(_SlotErased(idx) == true || _SlotValid(idx) == false) continue;
+
+			uint32_t idx_seq = _SlotPtr(idx)->seq;
+			if(found == false || (int32_t)(idx_seq - last_seq) > 0)
+			{
+				found = true;
+				last_seq = idx_seq;
+				last_slot = idx;
+			}
+		}
+		if(found == false) return nullptr;
+
+		_slot = (last_slot + 1) % SlotCount;
+		_seq = last_seq + 1;
+		_EraseAhead(last_slot);
+
+		return _SlotPtr(last_slot);
+	}
+
+	/*
+		Начинает запись record: seq и crc заполняются здесь. Предыдущая запись должна быть завершена.
+	*/
+	void Write(const record_t &record)
+	{
+		// Слот занят после оборванной записи: пропускаем его, но не уходим со страницы раньше её конца.
+		while(_slot % SlotsPerPage != 0 && _SlotErased(_slot) == false)
+		{
+			_slot = (_slot + 1) % SlotCount;
+		}
+		// Страница стирается заранее; здесь - только если это стирание оборвалось.
+		if(_slot % SlotsPerPage == 0 && _PageErased(_PageOf(_slot)) == false)
+		{
+			_erase_page = _PageOf(_slot);
+		}
+
+		_record = record;
+		_record.seq = _seq;
+		_record.crc = FlashJournalCRC16((const uint8_t *)&_record, sizeof(record_t) - 2);
+		_write_idx = 0;
+
+		return;
+	}
+
+	/*
+		Один шаг записи: программирование полуслова или стирание страницы. true - стёрта страница.
+	*/
+	bool Step()
+	{
+		if(_CanProgram() == true)
+		{
+			_Program();
+
+			return false;
+		}
+		if(_erase_page < PageCount)
+		{
+			FlashErase::Page(Start + _erase_page * FLASH_PAGE_SIZE);
+			_erase_page = PageCount;
+
+			return true;
+		}
+
+		return false;
+	}
+
+	/*
+		Дописывает начатую запись без стирания страниц.
+	*/
+	void Flush()
+	{
+		while(_CanProgram() == true)
+		{
+			_Program();
+		}
+
+		return;
+	}
+
+	// Запись ещё не дописана.
+	bool Writing() const
+	{
+		return _write_idx < HalfWords;
+	}
+
+	// Есть незавершённая запись или стирание.
+	bool Busy() const
+	{
+		return Writing() == true || _erase_page < PageCount;
+	}
+
+private:
+
+	const record_t *_SlotPtr(uint32_t idx) const
+	{
+		return (const record_t *)(uintptr_t)(Start + idx * sizeof(record_t));
+	}
+
+	bool _SlotErased(uint32_t idx) const
+	{
+		const uint32_t *ptr = (const uint32_t *)(uintptr_t)(Start + idx * sizeof(record_t));
+		for(uint8_t i = 0; i < sizeof(record_t) / 4; ++i)
+		{
+			if(ptr[i] != 0xFFFFFFFF) return false;
+		}
+
+		return true;
+	}
+
+	bool _SlotValid(uint32_t idx) const
+	{
+		const record_t *ptr = _SlotPtr(idx);
+
+		return ptr->Valid() == true && ptr->crc == FlashJournalCRC16((const uint8_t *)ptr, sizeof(record_t) - 2);
+	}
+
+	uint8_t _PageOf(uint32_t idx) const
+	{
+		return idx / SlotsPerPage;
+	}
+
+	bool _PageErased(uint8_t page) const
+	{
+		for(uint32_t idx = page * SlotsPerPage; idx < (page + 1) * SlotsPerPage; ++idx)
+		{
+			if(_SlotErased(idx) == false) return false;
+		}
+
+		return true;
+	}
+
+	// Запись идёт и её страница не ждёт стирания.
+	bool _CanProgram() const
+	{
+		return _write_idx < HalfWords && _PageOf(_slot) != _erase_page;
+	}
+
+	// Записи на странице после страницы слота idx больше не нужны: стираем её заранее.
+	void _EraseAhead(uint32_t idx)
+	{
+		uint8_t next = (_PageOf(idx) + 1) % PageCount;
+		if(_PageErased(next) == false) _erase_page = next;
+
+		return;
+	}
+
+	void _Program()
+	{
+		uint16_t data;
+		memcpy(&data, (const uint8_t *)&_record + _write_idx * 2, sizeof(data));
+
+		HAL_FLASH_Unlock();
+		HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, Start + _slot * sizeof(record_t) + _write_idx * 2, data);
+		HAL_FLASH_Lock();
+
+		if(++_write_idx >= HalfWords)
+		{
+			_EraseAhead(_slot);
+			_slot = (_slot + 1) % SlotCount;
+			_seq++;
+		}
+
+		return;
+	}
+
+	uint32_t _slot = 0;					// Слот для следующей записи.
+	uint32_t _seq = 0;					// Номер следующей записи.
+	record_t _record = {};				// Записываемая запись.
+	uint8_t _write_idx = HalfWords;		// Индекс программируемого полуслова, HalfWords - запись не идёт.
+	uint8_t _erase_page = PageCount;	// Страница для стирания следующим шагом, PageCount - нет.
+};
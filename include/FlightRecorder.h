@@ -0,0 +1,324 @@
+/*
+	Бортовой самописец: кольцевые буферы последних событий и пакетов в RAM.
+
+	События (ошибки, CAN, настройки) и пакеты контроллеров лежат в разных кольцах по CFG_Size
+		записей: два контроллера присылают ~140 пакетов в секунду и в общем кольце вытеснили бы
+		события за доли секунды. Пакет двигателя попадает в кольцо не чаще раза в
+		CFG_FramePeriod мс, кольцо пакетов хранит ~CFG_Size * CFG_FramePeriod / 2 мс истории.
+
+	Буфер лежит в секции .noinit и не очищается при программном сбросе или сбросе
+		по watchdog, поэтому после сбоя его можно выгрузить в CAN или отладочный UART.
+		Целостность проверяется по сигнатуре и её инверсии, при несовпадении (включение
+		питания) буфер очищается.
+
+	Запись события - резервирование слота с кратким запретом прерываний и копирование
+		до 14 байт, несколько десятков тактов, поэтому самописец работает и в Release.
+
+	Все события дублируются в двоичную трассу (Trace.h), если она включена.
+
+	На время выгрузки запись в кольца останавливается (события считаются в lost), иначе за
+		секунду выгрузки в CAN кольцо перезаписалось бы и выгрузка смешала старые и новые записи.
+
+	Выгрузка в UART идёт через AsyncLog: Loop() кладёт в лог по CFG_DumpRecordsPerLoop
+		записей за итерацию, пока в кольце лога есть место, и не задерживает основной цикл.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <stm32f1xx_hal.h>
+
+namespace FlightRecorder
+{
+	static constexpr uint8_t CFG_Size = 32;					// Записей в каждом кольце, степень двойки.
+	static constexpr uint32_t CFG_Magic = 0x46524532;		// 'FRE2', два кольца.
+	static constexpr uint16_t CFG_FramePeriod = 100;		// Минимальный интервал мс между пакетами одного двигателя.
+	static constexpr uint8_t CFG_MotorCount = 2;			// Источники пакетов 1..CFG_MotorCount.
+	static constexpr uint8_t CFG_DataSize = 14;				// Размер данных записи.
+	static constexpr uint8_t CFG_PartSize = 5;				// Байт записи в одном кадре CAN.
+	static constexpr uint16_t CFG_DumpPeriod = 5;			// Интервал мс между кадрами выгрузки в CAN.
+	static constexpr uint8_t CFG_DumpRecordsPerLoop = 2;	// Записей за итерацию при выгрузке в UART.
+
+	static_assert((CFG_Size & (CFG_Size - 1)) == 0, "CFG_Size must be a power of two!");
+
+	enum event_t : uint8_t
+	{
+		EVENT_NONE = 0x00,
+		EVENT_BOOT = 0x01,			// data: RCC->CSR[4] до сброса флагов.
+		EVENT_FRAME = 0x02,			// data: пакет контроллера без CRC и 0xAA, { D11..D0 A1 }.
+		EVENT_MOTOR_ERROR = 0x03,	// data: ErrorFlags[2].
+		EVENT_LINK_ERROR = 0x04,	// data: код ошибки связи FardriverController::error_t[1].
+		EVENT_CAN_ERROR = 0x05,		// data: HAL_CAN_GetError()[4].
+		EVENT_UART_ERROR = 0x06,	// data: ErrorCode[4].
+		EVENT_CONFIG = 0x07,		// data: кадр BlockCfg SET { param value.. }.
+	};
+
+	enum ring_t : uint8_t
+	{
+		RING_EVENTS = 0,
+		RING_FRAMES = 1,
+		RING_COUNT = 2,
+	};
+
+	enum dump_t : uint8_t
+	{
+		DUMP_CAN = 0x01,
+		DUMP_UART = 0x02,
+	};
+
+	struct __attribute__((__packed__)) record_t
+	{
+		uint32_t time;					// Время мс.
+		event_t type;					// Тип события.
+		uint8_t source;					// Источник: номер двигателя, 0 - блок.
+		uint8_t data[CFG_DataSize];		// Данные события.
+	};
+	static_assert(sizeof(record_t) == 20, "Record size must stay 20 bytes!");
+
+	struct ring_storage_t
+	{
+		uint32_t head;					// Счётчик записей, слот = head % CFG_Size.
+		record_t records[CFG_Size];
+	};
+
+	struct storage_t
+	{
+		uint32_t magic;
+		uint32_t magic_inv;
+		ring_storage_t rings[RING_COUNT];
+	};
+
+	__attribute__((section(".noinit"))) storage_t storage;
+
+	uint32_t frame_time[CFG_MotorCount + 1] = {};	// Время последнего записанного пакета по источнику.
+
+	volatile uint8_t frozen = 0;				// Идущие выгрузки, dump_t: запись в кольца остановлена.
+	volatile uint32_t lost = 0;					// Событий не записано, пока шла выгрузка.
+
+	uint32_t dump_heads[RING_COUNT] = {};		// Значения head на момент запроса выгрузки в CAN.
+	uint16_t dump_frame = 0;					// Номер следующего кадра выгрузки в CAN.
+	bool dump_can = false;
+
+	uint32_t dump_uart_heads[RING_COUNT] = {};	// Значения head на момент запроса выгрузки в UART.
+	uint8_t dump_uart_idx = 0;					// Следующая запись выгрузки в UART.
+	bool dump_uart = false;
+
+	static constexpr uint8_t PartsPerRecord = (sizeof(record_t) + CFG_PartSize - 1) / CFG_PartSize;
+
+	/*
+		(Interrupt) Добавляет событие. Пакеты EVENT_FRAME идут в своё кольцо, не чаще CFG_FramePeriod
+		на двигатель; в трассу попадают все.
+	*/
+	inline void Record(event_t type, uint8_t source, const void *data, uint8_t length)
+	{
+		Trace::Record(type, source, data, length);
+
+		uint32_t time = HAL_GetTick();
+		ring_storage_t &ring = storage.rings[(type == EVENT_FRAME) ? RING_FRAMES : RING_EVENTS];
+
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		if(frozen != 0)
+		{
+			lost++;
+			__set_PRIMASK(primask);
+			return;
+		}
+		if(type == EVENT_FRAME && source <= CFG_MotorCount)
+		{
+			if(time - frame_time[source] < CFG_FramePeriod && ring.head != 0)
+			{
+				__set_PRIMASK(primask);
+				return;
+			}
+			frame_time[source] = time;
+		}
+		uint32_t idx = ring.head++;
+		__set_PRIMASK(primask);
+
+		record_t &record = ring.records[idx & (CFG_Size - 1)];
+		record.time = time;
+		record.type = type;
+		record.source = source;
+		if(length > CFG_DataSize) length = CFG_DataSize;
+		memcpy(record.data, data, length);
+		memset(record.data + length, 0x00, CFG_DataSize - length);
+
+		return;
+	}
+
+	/*
+		Количество записей в кольце на момент head.
+	*/
+	inline uint8_t Count(uint32_t head)
+	{
+		return (head > CFG_Size) ? CFG_Size : head;
+	}
+
+	/*
+		Количество записей во всех кольцах на момент heads.
+	*/
+	inline uint8_t Count(const uint32_t *heads)
+	{
+		return Count(heads[RING_EVENTS]) + Count(heads[RING_FRAMES]);
+	}
+
+	/*
+		Запись idx на момент heads: сначала события, затем пакеты, в каждом кольце от самой старой.
+	*/
+	inline const record_t &Get(const uint32_t *heads, uint8_t idx)
+	{
+		uint8_t ring = RING_EVENTS;
+		if(idx >= Count(heads[RING_EVENTS]))
+		{
+			idx -= Count(heads[RING_EVENTS]);
+			ring = RING_FRAMES;
+		}
+
+		return storage.rings[ring].records[(heads[ring] - Count(heads[ring]) + idx) & (CFG_Size - 1)];
+	}
+
+	inline void _Snapshot(uint32_t *heads)
+	{
+		for(uint8_t ring = 0; ring < RING_COUNT; ++ring)
+		{
+			heads[ring] = storage.rings[ring].head;
+		}
+
+		return;
+	}
+
+	/*
+		Запрос выгрузки, mask - набор dump_t.
+	*/
+	inline void RequestDump(uint8_t mask)
+	{
+		// Сначала останавливаем запись: после снимка кольца не меняются до конца выгрузки.
+		mask &= DUMP_CAN | DUMP_UART;
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		frozen |= mask;
+		__set_PRIMASK(primask);
+
+		if(mask & DUMP_UART)
+		{
+			_Snapshot(dump_uart_heads);
+			dump_uart_idx = 0;
+			dump_uart = true;
+
+			AsyncLog::Push("FREC", "events: %u of %lu, frames: %u of %lu\r\n",
+				Count(dump_uart_heads[RING_EVENTS]), dump_uart_heads[RING_EVENTS],
+				Count(dump_uart_heads[RING_FRAMES]), dump_uart_heads[RING_FRAMES]);
+		}
+		if(mask & DUMP_CAN)
+		{
+			_Snapshot(dump_heads);
+			dump_frame = 0;
+			dump_can = true;
+		}
+
+		return;
+	}
+
+	/*
+		Выгрузка mask закончена: запись возобновляется, когда закончены обе.
+	*/
+	inline void _DumpDone(uint8_t mask)
+	{
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		frozen &= ~mask;
+		__set_PRIMASK(primask);
+
+		return;
+	}
+
+	/*
+		Упаковывает следующий кадр выгрузки в 7 байт { record[0] part[1] data[2..6] }.
+		Записи нумеруются как в Get(), false - выгрузка закончена.
+	*/
+	inline bool PackNext(uint8_t *data)
+	{
+		if(dump_can == false) return false;
+
+		uint8_t record_idx = dump_frame / PartsPerRecord;
+		uint8_t part = dump_frame % PartsPerRecord;
+		if(record_idx >= Count(dump_heads))
+		{
+			dump_can = false;
+			_DumpDone(DUMP_CAN);
+			return false;
+		}
+
+		const uint8_t *raw = (const uint8_t *)&Get(dump_heads, record_idx);
+		uint8_t offset = part * CFG_PartSize;
+		uint8_t length = (sizeof(record_t) - offset < CFG_PartSize) ? (sizeof(record_t) - offset) : CFG_PartSize;
+
+		memset(data, 0x00, 2 + CFG_PartSize);
+		data[0] = record_idx;
+		data[1] = part;
+		memcpy(&data[2], raw + offset, length);
+
+		dump_frame++;
+
+		return true;
+	}
+
+	inline void Setup()
+	{
+		if(storage.magic != CFG_Magic || storage.magic_inv != ~CFG_Magic)
+		{
+			memset(&storage, 0x00, sizeof(storage));
+			storage.magic = CFG_Magic;
+			storage.magic_inv = ~CFG_Magic;
+		}
+
+		uint32_t csr = RCC->CSR;
+		__HAL_RCC_CLEAR_RESET_FLAGS();
+		Record(EVENT_BOOT, 0, &csr, sizeof(csr));
+
+		// После сброса не по питанию сразу выгружаем историю в UART.
+		if((csr & RCC_CSR_PORRSTF) == 0 && (storage.rings[RING_EVENTS].head > 1 || storage.rings[RING_FRAMES].head > 0))
+		{
+			RequestDump(DUMP_UART);
+		}
+
+		return;
+	}
+
+	/*
+		Выгрузка в UART в порядке Get(). Запись - две строки лога:
+		время, тип и источник, затем 14 байт данных.
+	*/
+	inline void Loop(uint32_t & /* current_time */)
+	{
+		if(dump_uart == false) return;
+
+		for(uint8_t i = 0; i < CFG_DumpRecordsPerLoop; ++i)
+		{
+			if(dump_uart_idx >= Count(dump_uart_heads))
+			{
+				if(AsyncLog::Free() < 1) break;
+				AsyncLog::Push("FREC", "done, lost: %lu\r\n", lost);
+				dump_uart = false;
+				_DumpDone(DUMP_UART);
+				break;
+			}
+			if(AsyncLog::Free() < 2) break;
+
+			const record_t &record = Get(dump_uart_heads, dump_uart_idx);
+			const uint8_t *d = record.data;
+			AsyncLog::Push("FREC", "%10lu %02X %u:\r\n", record.time, record.type, record.source);
+			AsyncLog::Push("FREC", "  %08lX %08lX %08lX %04lX\r\n",
+				(uint32_t)d[0] << 24 | (uint32_t)d[1] << 16 | (uint32_t)d[2] << 8 | d[3],
+				(uint32_t)d[4] << 24 | (uint32_t)d[5] << 16 | (uint32_t)d[6] << 8 | d[7],
+				(uint32_t)d[8] << 24 | (uint32_t)d[9] << 16 | (uint32_t)d[10] << 8 | d[11],
+				(uint32_t)d[12] << 8 | d[13]);
+
+			dump_uart_idx++;
+		}
+
+		return;
+	}
+}
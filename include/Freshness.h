@@ -0,0 +1,217 @@
+/*
+	Свежесть значений в CAN: возраст данных контроллера в момент передачи кадра.
+
+	Декодер (MotorEvents.h) отмечает объект временем прихода пакета по UART (последний байт,
+		Motors::GetPacketTime()), HAL_CAN_Send при передаче кадра объекта считает возраст
+		каждой отметки: время передачи минус время прихода. Так учитываются и период
+		опроса контроллера, и период таймера объекта, и ожидание в очереди CANManager.
+
+	Возраст раскладывается по корзинам CFG_BucketEdges, p50/p99 - верхняя граница корзины
+		(не больше максимума), максимум точный. Счётчики uint16, при переполнении корзины
+		все корзины объекта делятся пополам - распределение сохраняется.
+		После потери связи с контроллером его отметки сбрасываются, пока не придёт новый пакет.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stm32f1xx_hal.h>
+
+namespace Freshness
+{
+	static constexpr uint16_t CFG_CANPeriod = 250;			// Период публикации в CAN, мс.
+	static constexpr uint8_t CFG_BucketCount = 20;
+	static constexpr uint16_t CFG_BucketEdges[CFG_BucketCount] =		// Верхние границы корзин, мс (не включая).
+	{
+		2, 4, 8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, UINT16_MAX
+	};
+
+	// Объекты с данными контроллеров, идут подряд с ID CFG_FirstId (см. CANLogic.h).
+	enum object_t : uint8_t
+	{
+		OBJ_ERRORS = 0,			// 0x0104
+		OBJ_RPM,				// 0x0105
+		OBJ_SPEED,				// 0x0106
+		OBJ_VOLTAGE,			// 0x0107
+		OBJ_CURRENT,			// 0x0108
+		OBJ_POWER,				// 0x0109
+		OBJ_GEAR_ROLL,			// 0x010A
+		OBJ_MOTOR_TEMP,			// 0x010B
+		OBJ_CONTROLLER_TEMP,	// 0x010C
+		OBJ_ODOMETER,			// 0x010D
+		OBJ_COUNT
+	};
+
+	static constexpr uint16_t CFG_FirstId = 0x0104;
+
+	static constexpr const char *object_names[OBJ_COUNT] =
+	{
+		"Errors", "RPM", "Speed", "Voltage", "Current", "Power", "GearRoll", "MotorTemp", "ControllerTemp", "Odometer"
+	};
+
+	struct stats_t
+	{
+		uint16_t buckets[CFG_BucketCount];
+		uint16_t max;			// Максимальный возраст, мс.
+		uint32_t samples;		// Всего передач с отметкой.
+	};
+
+	struct report_t
+	{
+		uint16_t p50;
+		uint16_t p99;
+		uint16_t max;
+		uint32_t samples;
+	};
+
+	stats_t stats[OBJ_COUNT] = {};
+	uint32_t stamps[OBJ_COUNT][2] = {};		// Время прихода пакета, мс, по контроллерам.
+	bool stamped[OBJ_COUNT][2] = {};
+
+	/*
+		Отметка объекта пакетом контроллера idx (0 или 1), пришедшим в packet_time.
+	*/
+	inline void Stamp(object_t object, uint8_t idx, uint32_t packet_time)
+	{
+		stamps[object][idx] = packet_time;
+		stamped[object][idx] = true;
+
+		return;
+	}
+
+	/*
+		Сброс отметок контроллера idx (0 или 1) после потери связи.
+	*/
+	inline void Reset(uint8_t idx)
+	{
+		for(uint8_t i = 0; i < OBJ_COUNT; ++i)
+		{
+			stamped[i][idx] = false;
+		}
+
+		return;
+	}
+
+	inline void _Add(stats_t &object, uint32_t age)
+	{
+		uint16_t value = (age < UINT16_MAX) ? age : UINT16_MAX;
+
+		uint8_t bucket = 0;
+		while(bucket < CFG_BucketCount - 1 && value >= CFG_BucketEdges[bucket]) ++bucket;
+
+		if(object.buckets[bucket] == UINT16_MAX)
+		{
+			for(uint8_t i = 0; i < CFG_BucketCount; ++i)
+			{
+				object.buckets[i] >>= 1;
+			}
+		}
+		object.buckets[bucket]++;
+
+		if(value > object.max) object.max = value;
+		object.samples++;
+
+		return;
+	}
+
+	/*
+		Передача кадра объекта id, вызывается из HAL_CAN_Send.
+	*/
+	inline void OnTransmit(uint16_t id, uint32_t time)
+	{
+		uint16_t object = id - CFG_FirstId;
+		if(object >= OBJ_COUNT) return;
+
+		for(uint8_t idx = 0; idx < 2; ++idx)
+		{
+			if(stamped[object][idx] == false) continue;
+
+			_Add(stats[object], time - stamps[object][idx]);
+		}
+
+		return;
+	}
+
+	/*
+		Процентиль percent (1..100) по корзинам, мс.
+	*/
+	inline uint16_t _Percentile(const stats_t &object, uint8_t percent)
+	{
+		uint32_t total = 0;
+		for(uint8_t i = 0; i < CFG_BucketCount; ++i)
+		{
+			total += object.buckets[i];
+		}
+		if(total == 0) return 0;
+
+		uint32_t target = (total * percent + 99) / 100;
+		uint32_t sum = 0;
+		for(uint8_t i = 0; i < CFG_BucketCount; ++i)
+		{
+			sum += object.buckets[i];
+			if(sum >= target)
+			{
+				return (CFG_BucketEdges[i] < object.max) ? CFG_BucketEdges[i] : object.max;
+			}
+		}
+
+		return object.max;
+	}
+
+	inline report_t Report(object_t object)
+	{
+		const stats_t &item = stats[object];
+
+		return { _Percentile(item, 50), _Percentile(item, 99), item.max, item.samples };
+	}
+
+	/*
+		Следующий объект с передачами для CAN: { object[0] p50[1..2] p99[3..4] max[5..6] }.
+			object - младший байт ID объекта. Возвращает false, если передач ещё не было.
+	*/
+	inline bool PackNext(uint8_t *data)
+	{
+		static uint8_t object = 0;
+
+		for(uint8_t n = 0; n < OBJ_COUNT; ++n)
+		{
+			uint8_t cur = object;
+			if(++object >= OBJ_COUNT) object = 0;
+
+			if(stats[cur].samples == 0) continue;
+
+			report_t report = Report((object_t)cur);
+			data[0] = (CFG_FirstId + cur) & 0xFF;
+			data[1] = report.p50 & 0xFF;
+			data[2] = report.p50 >> 8;
+			data[3] = report.p99 & 0xFF;
+			data[4] = report.p99 >> 8;
+			data[5] = report.max & 0xFF;
+			data[6] = report.max >> 8;
+
+			return true;
+		}
+
+		return false;
+	}
+
+	inline void Loop(uint32_t &current_time)
+	{
+		static uint32_t can_time = 0;
+		if(current_time - can_time > CFG_CANPeriod)
+		{
+			can_time = current_time;
+
+			uint8_t data[7];
+			if(PackNext(data) == true)
+			{
+				for(uint8_t i = 0; i < sizeof(data); ++i)
+				{
+					CANLib::obj_freshness().SetValue(i, data[i], CAN_TIMER_TYPE_NORMAL);
+				}
+			}
+		}
+
+		return;
+	}
+}
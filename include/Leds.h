@@ -15,8 +15,17 @@ namespace Leds
 		LED_BLUE = 4,
 	};
 	
+	// Самопроверка при старте: светодиоды по очереди, затем мигание зелёного 'работаю'.
+	// Идёт из Loop(), чтобы не задерживать запуск CAN и приём от контроллеров.
+	static constexpr leds_t CFG_SelfTest[] = { LED_BLUE, LED_YELLOW, LED_RED, LED_GREEN };
+	static constexpr uint8_t CFG_SelfTestCount = sizeof(CFG_SelfTest) / sizeof(CFG_SelfTest[0]);
+	static constexpr uint16_t CFG_SelfTestStep = 100;
+	
 	InfoLeds<CFG_LedCount> obj;
 	
+	uint8_t self_test_step = 0;
+	uint32_t self_test_time = 0;
+	
 	inline void Setup()
 	{
 		obj.AddLed( {GPIOC, GPIO_PIN_14}, LED_YELLOW);
@@ -24,27 +33,26 @@ namespace Leds
 		obj.AddLed( {GPIOA, GPIO_PIN_0}, LED_GREEN);
 		obj.AddLed( {GPIOA, GPIO_PIN_1}, LED_BLUE);
 		
-		obj.SetOn(LED_BLUE);
-		HAL_Delay(100);
-		obj.SetOff(LED_BLUE);
-		
-		obj.SetOn(LED_YELLOW);
-		HAL_Delay(100);
-		obj.SetOff(LED_YELLOW);
-		
-		obj.SetOn(LED_RED);
-		HAL_Delay(100);
-		obj.SetOff(LED_RED);
-		
-		obj.SetOn(LED_GREEN);
-		HAL_Delay(100);
-		obj.SetOff(LED_GREEN);
-		
 		return;
 	}
 	
 	inline void Loop(uint32_t &current_time)
 	{
+		if(self_test_step <= CFG_SelfTestCount && (self_test_step == 0 || current_time - self_test_time >= CFG_SelfTestStep))
+		{
+			self_test_time = current_time;
+			
+			if(self_test_step < CFG_SelfTestCount)
+			{
+				obj.SetOn(CFG_SelfTest[self_test_step], CFG_SelfTestStep);
+			}
+			else
+			{
+				obj.SetOn(LED_GREEN, 50, 1950);
+			}
+			self_test_step++;
+		}
+		
 		obj.Processing(current_time);
 
 		current_time = HAL_GetTick();
@@ -0,0 +1,230 @@
+/*
+	Контроль основного цикла: гистограмма длительности итераций и детектор зависаний.
+
+	Длительность итерации измеряется по DWT->CYCCNT и раскладывается по корзинам log2:
+		корзина N - итерации длительностью [2^N, 2^(N+1)) тактов, последняя - всё длиннее.
+
+	Модули цикла вызываются через Run(), который запоминает текущий модуль и время его старта.
+		Если модуль работает дольше CFG_StallThreshold, это фиксируется ещё во время работы
+		из SysTick (Tick()), поэтому видно и модуль, который так и не вернул управление.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stm32f1xx_hal.h>
+
+namespace LoopMonitor
+{
+	static constexpr uint8_t CFG_BucketCount = 24;			// 2^23 тактов ~ 131 мс при 64 МГц.
+	static constexpr uint32_t CFG_StallThreshold = 5;		// Длительность модуля, мс, считающаяся зависанием.
+	static constexpr uint16_t CFG_CANPeriod = 500;			// Период публикации в CAN, мс.
+	static constexpr uint32_t CFG_DumpPeriod = 60000;		// Период вывода в отладочный UART, мс.
+	static constexpr uint8_t CFG_DumpReserve = 8;			// Записи AsyncLog, оставляемые другим модулям при выводе.
+
+	enum module_t : uint8_t
+	{
+		MODULE_NONE = 0,
+		MODULE_ABOUT,
+		MODULE_LEDS,
+		MODULE_CAN,
+		MODULE_MOTORS,
+		MODULE_STORAGE,
+		MODULE_PROFILER,
+		MODULE_LOG,
+		MODULE_TRACE,
+		MODULE_MEMORY,
+		MODULE_FRESHNESS,
+		MODULE_SUPPLY,
+		MODULE_CONFIG,
+		MODULE_RECORDER,
+		MODULE_COUNT
+	};
+
+	static constexpr const char *module_names[MODULE_COUNT] = { "None", "About", "Leds", "CAN", "Motors", "Storage", "Profiler", "Log", "Trace", "Memory", "Freshness", "Supply", "Config", "Recorder" };
+
+	struct stall_t
+	{
+		uint16_t count;			// Количество зависаний модуля.
+		uint16_t max;			// Максимальная длительность, мс.
+	};
+
+	uint32_t buckets[CFG_BucketCount] = {};
+	stall_t stalls[MODULE_COUNT] = {};
+
+	uint32_t heartbeats[MODULE_COUNT] = {};		// Время мс последнего завершения модуля, см. Watchdog.h.
+	uint32_t durations[MODULE_COUNT] = {};		// Длительность последнего Run() модуля, мс, см. Watchdog.h.
+	uint32_t iteration_start = 0;				// CYCCNT начала итерации.
+	volatile module_t module = MODULE_NONE;		// Выполняемый модуль.
+	volatile uint32_t module_start = 0;			// Время мс старта модуля.
+	volatile bool module_stalled = false;		// Зависание модуля уже учтено.
+
+	/*
+		Учёт итерации, вызывается в начале каждой итерации основного цикла.
+	*/
+	inline void Iteration()
+	{
+		uint32_t now = DWT->CYCCNT;
+		uint32_t cycles = now - iteration_start;
+		iteration_start = now;
+
+		uint8_t bucket = (cycles == 0) ? 0 : (31 - __builtin_clz(cycles));
+		if(bucket >= CFG_BucketCount) bucket = CFG_BucketCount - 1;
+		buckets[bucket]++;
+
+		return;
+	}
+
+	/*
+		Выполняет Loop() модуля с учётом зависаний.
+	*/
+	inline void Run(module_t id, void (*loop)(uint32_t &), uint32_t &current_time)
+	{
+		module_start = HAL_GetTick();
+		module_stalled = false;
+		module = id;
+
+		loop(current_time);
+
+		module = MODULE_NONE;
+
+		uint32_t now = HAL_GetTick();
+		heartbeats[id] = now;
+
+		uint32_t duration = now - module_start;
+		durations[id] = duration;
+		if(duration >= CFG_StallThreshold)
+		{
+			stall_t &stall = stalls[id];
+			if(module_stalled == false) stall.count++;
+			if(duration > stall.max) stall.max = (duration > 0xFFFF) ? 0xFFFF : duration;
+
+			ASYNC_LOG_TOPIC("STALL", "module: %d, %lu ms\r\n", id, duration);
+		}
+
+		return;
+	}
+
+	/*
+		(Interrupt) Вызывается из SysTick, фиксирует модуль, превысивший порог.
+	*/
+	inline void Tick()
+	{
+		if(module != MODULE_NONE && module_stalled == false && HAL_GetTick() - module_start >= CFG_StallThreshold)
+		{
+			module_stalled = true;
+			stalls[module].count++;
+		}
+
+		return;
+	}
+
+	/*
+		Упаковывает следующую запись в 7 байт:
+			{ idx[0] count[1..4] } - корзина гистограммы idx (только ненулевые);
+			{ 0x80 | module[0] count[1..2] max_ms[3..4] } - зависания модуля (только ненулевые).
+	*/
+	inline bool PackNext(uint8_t *data)
+	{
+		static constexpr uint8_t slot_count = CFG_BucketCount + MODULE_COUNT;
+		static uint8_t slot = 0;
+
+		for(uint8_t i = 0; i < slot_count; ++i)
+		{
+			uint8_t cur = slot;
+			if(++slot >= slot_count) slot = 0;
+
+			memset(data, 0x00, 7);
+			if(cur < CFG_BucketCount)
+			{
+				if(buckets[cur] == 0) continue;
+
+				data[0] = cur;
+				memcpy(&data[1], &buckets[cur], sizeof(uint32_t));
+			}
+			else
+			{
+				const stall_t &stall = stalls[cur - CFG_BucketCount];
+				if(stall.count == 0) continue;
+
+				data[0] = 0x80 | (cur - CFG_BucketCount);
+				memcpy(&data[1], &stall.count, sizeof(uint16_t));
+				memcpy(&data[3], &stall.max, sizeof(uint16_t));
+			}
+
+			return true;
+		}
+
+		return false;
+	}
+
+	/*
+		Выводит гистограмму и зависания в отладочный UART через AsyncLog, начиная с записи slot.
+			Записи кладутся, пока в кольце больше CFG_DumpReserve свободных мест, остальные -
+			следующими вызовами. Возвращает следующую запись, slot_count - вывод окончен.
+	*/
+	inline uint8_t Dump(uint8_t slot)
+	{
+		static constexpr uint8_t slot_count = CFG_BucketCount + MODULE_COUNT;
+
+		for(; slot < slot_count && AsyncLog::Free() > CFG_DumpReserve; ++slot)
+		{
+			if(slot < CFG_BucketCount)
+			{
+				if(buckets[slot] == 0) continue;
+				ASYNC_LOG_TOPIC("LOOP", "cycles >= 2^%u: %lu\r\n", slot, buckets[slot]);
+			}
+			else
+			{
+				const stall_t &stall = stalls[slot - CFG_BucketCount];
+				if(stall.count == 0) continue;
+				ASYNC_LOG_TOPIC(module_names[slot - CFG_BucketCount], "stall count %u, max %u ms\r\n", stall.count, stall.max);
+			}
+		}
+
+		return slot;
+	}
+
+	inline void Setup()
+	{
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+		iteration_start = DWT->CYCCNT;
+
+		return;
+	}
+
+	inline void Loop(uint32_t &current_time)
+	{
+		static uint32_t can_time = 0;
+		if(current_time - can_time > CFG_CANPeriod)
+		{
+			can_time = current_time;
+
+			uint8_t data[7];
+			if(PackNext(data) == true)
+			{
+				for(uint8_t i = 0; i < sizeof(data); ++i)
+				{
+					CANLib::obj_loop_stats().SetValue(i, data[i], CAN_TIMER_TYPE_NORMAL);
+				}
+			}
+		}
+
+		static constexpr uint8_t slot_count = CFG_BucketCount + MODULE_COUNT;
+		static uint8_t dump_slot = slot_count;
+		static uint32_t dump_time = 0;
+		if(current_time - dump_time > CFG_DumpPeriod && dump_slot == slot_count)
+		{
+			dump_time = current_time;
+			dump_slot = 0;
+		}
+		if(dump_slot < slot_count)
+		{
+			dump_slot = Dump(dump_slot);
+		}
+
+		return;
+	}
+}
@@ -0,0 +1,216 @@
+/*
+	Контроль RAM: максимальная глубина стека и статическая память по модулям.
+
+	Paint() в самом начале main() заполняет свободную RAM между концом статических данных
+		(символ _end скрипта компоновки) и текущим SP шаблоном CFG_Pattern. Loop() периодически
+		ищет снизу первое слово, отличное от шаблона: всё выше него когда-либо использовалось стеком.
+		Поиск идёт порциями по CFG_ScanWords слов за вызов, чтобы не задерживать основной цикл.
+		Куча (malloc) растёт от _end навстречу стеку и в отчёте учитывается как стек.
+
+	Статическая память модулей считается через sizeof() их глобальных объектов, общий объём
+		статики (.data + .bss + .noinit) - по символам компоновщика. Разбивка по символам
+		из карты компоновки: tools/ram_report.py.
+
+	Отчёт публикуется в диагностический объект 0x0118 MemoryStats (CANLib::obj_memory_stats):
+		{ stack_used[0..1] headroom[2..3] module[4] module_ram[5] }, байты,
+		module_ram - в единицах по 16 байт с насыщением, модули передаются по очереди.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stm32f1xx_hal.h>
+
+extern "C" uint32_t _sdata;
+extern "C" uint32_t _end;
+extern "C" uint32_t _estack;
+
+namespace MemoryMonitor
+{
+	static constexpr uint32_t CFG_Pattern = 0xC5C5C5C5;		// Шаблон незанятой RAM.
+	static constexpr uint32_t CFG_PaintGuard = 32;			// Не закрашивать ближайшие к SP байты.
+	static constexpr uint16_t CFG_ScanWords = 128;			// Слов проверяется за один вызов Loop().
+	static constexpr uint32_t CFG_ScanPeriod = 1000;		// Период полного поиска, мс.
+	static constexpr uint16_t CFG_CANPeriod = 1000;			// Период публикации в CAN, мс.
+	static constexpr uint16_t CFG_HeadroomWarning = 512;	// Запас RAM, при котором отчёт уходит событием, байт.
+	static constexpr uint8_t CFG_ModuleUnit = 16;			// Единица module_ram, байт.
+	static constexpr uint32_t CFG_DumpPeriod = 60000;		// Период вывода в отладочный UART, мс.
+
+	enum module_t : uint8_t
+	{
+		MODULE_STATIC = 0,			// Вся статика: .data + .bss + .noinit.
+		MODULE_CAN,
+		MODULE_MOTORS,
+		MODULE_UART,
+		MODULE_LOG,
+		MODULE_TRACE,
+		MODULE_RECORDER,
+		MODULE_STORAGE,
+		MODULE_METERS,
+		MODULE_DIAG,
+		MODULE_COUNT
+	};
+
+	static constexpr const char *module_names[MODULE_COUNT] = { "Static", "CAN", "Motors", "UART", "Log", "Trace", "Recorder", "Storage", "Meters", "Diag" };
+
+	uint32_t module_ram[MODULE_COUNT] = {};
+
+	uint32_t *paint_start = nullptr;		// Начало закрашенной области.
+	uint32_t *peak = nullptr;				// Самое нижнее использованное слово стека.
+	uint32_t *scan_ptr = nullptr;			// Позиция текущего поиска.
+	bool scan_active = false;
+
+	template <typename... T>
+	constexpr uint32_t _Sizeof(const T &...objs)
+	{
+		return (0 + ... + sizeof(objs));
+	}
+
+	/*
+		Закрашивает свободную RAM шаблоном. Вызывается первой строкой main().
+	*/
+	__attribute__((always_inline)) inline void Paint()
+	{
+		paint_start = &_end;
+		uint32_t *ptr = paint_start;
+		uint32_t *limit = (uint32_t *)(__get_MSP() - CFG_PaintGuard);
+		while(ptr < limit)
+		{
+			*ptr++ = CFG_Pattern;
+		}
+		peak = limit;
+
+		return;
+	}
+
+	inline uint32_t StackUsed()
+	{
+		return (uint32_t)&_estack - (uint32_t)peak;
+	}
+
+	inline uint32_t Headroom()
+	{
+		return (uint32_t)peak - (uint32_t)paint_start;
+	}
+
+	/*
+		Объём модуля, который не виден из этого файла (буферы в main.cpp).
+	*/
+	inline void SetModule(module_t id, uint32_t size)
+	{
+		module_ram[id] = size;
+
+		return;
+	}
+
+	/*
+		Порция поиска, true - поиск закончен.
+	*/
+	inline bool _Scan()
+	{
+		for(uint16_t i = 0; i < CFG_ScanWords; ++i)
+		{
+			// Выше прежнего максимума искать незачем: он может только опускаться.
+			if(scan_ptr >= peak) return true;
+			if(*scan_ptr != CFG_Pattern)
+			{
+				peak = scan_ptr;
+				return true;
+			}
+			scan_ptr++;
+		}
+
+		return false;
+	}
+
+	inline void Setup()
+	{
+		module_ram[MODULE_STATIC] = (uint32_t)&_end - (uint32_t)&_sdata;
+		module_ram[MODULE_CAN] = _Sizeof(CANLib::can_manager, CANLib::obj_block_info, CANLib::obj_block_health,
+			CANLib::obj_block_features, CANLib::obj_block_error, CANLib::obj_controller_errors(), CANLib::obj_controller_rpm(),
+			CANLib::obj_controller_speed(), CANLib::obj_controller_voltage(), CANLib::obj_controller_current(),
+			CANLib::obj_controller_power(), CANLib::obj_controller_gear_n_roll(), CANLib::obj_motor_temperature(),
+			CANLib::obj_controller_temperature(), CANLib::obj_controller_odometer(), CANLib::obj_energy_traction(),
+			CANLib::obj_energy_regen(), CANLib::obj_charge_traction(), CANLib::obj_charge_regen(), CANLib::obj_link_stats(),
+			CANLib::obj_loop_stats(), CANLib::obj_flight_recorder, CANLib::obj_freshness(), CANLib::obj_supply_voltage(),
+			CANLib::obj_memory_stats());
+		module_ram[MODULE_MOTORS] = _Sizeof(Motors::motor1, Motors::motor2);
+		module_ram[MODULE_LOG] = _Sizeof(AsyncLog::ring, AsyncLog::tx_buffer);
+		module_ram[MODULE_TRACE] = _Sizeof(Trace::ring, Trace::tx_buffer);
+		module_ram[MODULE_RECORDER] = _Sizeof(FlightRecorder::storage);
+		module_ram[MODULE_STORAGE] = _Sizeof(Storage::journal, Config::journal, Config::values, Config::hooks);
+		module_ram[MODULE_METERS] = _Sizeof(Odometer::motors, Energy::motors, Filters::voltage, Filters::current, Supply::samples, Supply::filter);
+		module_ram[MODULE_DIAG] = _Sizeof(LoopMonitor::buckets, LoopMonitor::stalls, Freshness::stats, Freshness::stamps, Freshness::stamped);
+#if defined(PROFILER_ENABLED)
+		module_ram[MODULE_CAN] += _Sizeof(CANLib::obj_profiler());
+		module_ram[MODULE_DIAG] += _Sizeof(Profiler::probes);
+#endif
+
+		return;
+	}
+
+	/*
+		Выводит стек и статику по модулям в отладочный UART.
+	*/
+	inline void Dump()
+	{
+		AsyncLog::Sync();
+
+		Logger.PrintTopic("RAM").Printf("stack used: %lu, headroom: %lu", StackUsed(), Headroom()).PrintNewLine();
+		for(uint8_t i = 0; i < MODULE_COUNT; ++i)
+		{
+			Logger.PrintTopic("RAM").Printf("%-8s %lu", module_names[i], module_ram[i]).PrintNewLine();
+		}
+
+		return;
+	}
+
+	inline void Loop(uint32_t &current_time)
+	{
+		static uint32_t scan_time = 0;
+		if(scan_active == false && current_time - scan_time > CFG_ScanPeriod)
+		{
+			scan_time = current_time;
+			scan_ptr = paint_start;
+			scan_active = true;
+		}
+		if(scan_active == true && _Scan() == true)
+		{
+			scan_active = false;
+		}
+
+		static uint32_t can_time = 0;
+		static uint8_t module = 0;
+		if(current_time - can_time > CFG_CANPeriod)
+		{
+			can_time = current_time;
+
+			uint32_t used = StackUsed();
+			uint32_t headroom = Headroom();
+			uint32_t ram = (module_ram[module] + CFG_ModuleUnit - 1) / CFG_ModuleUnit;
+			if(used > 0xFFFF) used = 0xFFFF;
+			if(headroom > 0xFFFF) headroom = 0xFFFF;
+			if(ram > 0xFF) ram = 0xFF;
+
+			CANLib::obj_memory_stats().SetValue(0, used & 0xFF, CAN_TIMER_TYPE_NORMAL);
+			CANLib::obj_memory_stats().SetValue(1, used >> 8, CAN_TIMER_TYPE_NORMAL);
+			CANLib::obj_memory_stats().SetValue(2, headroom & 0xFF, CAN_TIMER_TYPE_NORMAL);
+			CANLib::obj_memory_stats().SetValue(3, headroom >> 8, CAN_TIMER_TYPE_NORMAL);
+			CANLib::obj_memory_stats().SetValue(4, module, CAN_TIMER_TYPE_NORMAL);
+			CANLib::obj_memory_stats().SetValue(5, ram, CAN_TIMER_TYPE_NORMAL, (headroom < CFG_HeadroomWarning) ? CAN_EVENT_TYPE_NORMAL : CAN_EVENT_TYPE_NONE);
+
+			if(++module >= MODULE_COUNT) module = 0;
+		}
+
+		static uint32_t dump_time = 0;
+		if(current_time - dump_time > CFG_DumpPeriod)
+		{
+			dump_time = current_time;
+
+			Dump();
+			current_time = HAL_GetTick();
+		}
+
+		return;
+	}
+}
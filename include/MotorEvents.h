@@ -0,0 +1,136 @@
+/*
+	Декодирование пакетов контроллеров в CANObjects: обработчики событий FardriverController.
+
+	Вынесены из main.cpp, чтобы их можно было собрать и на хосте (native/).
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <MotorLogic.h>
+
+/// @brief Callback function: It is called when correct packet from motor controller PCB is received.
+/// @param motor_idx Index of the motor
+/// @param raw_packet Pointer to the structure with data.
+void OnMotorEvent(const uint8_t motor_idx, motor_packet_raw_t *raw_packet)
+{
+    if (motor_idx > 2 || motor_idx == 0)
+        return;
+
+    uint8_t idx = motor_idx - 1;
+	uint32_t packet_time = Motors::GetPacketTime(motor_idx);
+
+	// Пакет без CRC и 0xAA, до декодирования (декодер правит пакет на месте).
+	FlightRecorder::Record(FlightRecorder::EVENT_FRAME, motor_idx, &raw_packet->D11, FlightRecorder::CFG_DataSize - 1);
+
+    switch (raw_packet->_A1)
+    {
+    case 0x00:
+    {
+        motor_packet_0_t *packet0 = (motor_packet_0_t *)raw_packet;
+
+		// RPM fix. Контроллер возвращает RPMx4.
+		packet0->RPM >>= 2;
+
+        CANLib::obj_controller_rpm().SetValue(idx, packet0->RPM, CAN_TIMER_TYPE_NORMAL);
+
+		// Геометрия колеса настраивается через BlockCfg, см. Speed.h.
+		CANLib::obj_controller_speed().SetValue(idx, Speed::Calc(packet0->RPM), CAN_TIMER_TYPE_NORMAL);
+        
+		// TODO: Добавить сюда флаги пониженной передачи и кнопки закиси азота..
+		// А пока просто фиксим значения до 2 младших бит.
+        CANLib::obj_controller_gear_n_roll().SetValue(2 * idx, FardriverController<>::FixGear(packet0->Gear), CAN_TIMER_TYPE_NORMAL);
+        CANLib::obj_controller_gear_n_roll().SetValue(2 * idx + 1, FardriverController<>::FixRoll(packet0->Roll), CAN_TIMER_TYPE_NORMAL);
+
+		ASYNC_LOG_TOPIC("GearRoll", "Motor: %d, Gear: %02X, Roll: %02X;\r\n", motor_idx, packet0->Gear, packet0->Roll);
+
+		Odometer::Integrate(idx, packet0->RPM, packet_time, Motors::IsBothActive());
+        CANLib::obj_controller_odometer().SetValue(0, Odometer::GetTotal(), CAN_TIMER_TYPE_NORMAL);
+
+		Freshness::Stamp(Freshness::OBJ_RPM, idx, packet_time);
+		Freshness::Stamp(Freshness::OBJ_SPEED, idx, packet_time);
+		Freshness::Stamp(Freshness::OBJ_GEAR_ROLL, idx, packet_time);
+		Freshness::Stamp(Freshness::OBJ_ODOMETER, idx, packet_time);
+        break;
+    }
+
+    case 0x01:
+    {
+        motor_packet_1_t *packet1 = (motor_packet_1_t *)raw_packet;
+        
+        Energy::Integrate(idx, packet1->Current, packet1->Voltage, packet_time);
+        
+        int16_t current_raw = Filters::current[idx].Process(packet1->Current);
+        uint16_t voltage_raw = Filters::voltage[idx].Process(packet1->Voltage);
+        
+        int16_t current = (current_raw * 10) / 4;
+        int16_t power = ((uint32_t)abs(current_raw) * (uint32_t)voltage_raw) / 40U;
+        if(current_raw < 0) power = -power;
+        
+		CANLib::obj_controller_voltage().SetValue(idx, voltage_raw, CAN_TIMER_TYPE_NORMAL);
+        CANLib::obj_controller_current().SetValue(idx, current, CAN_TIMER_TYPE_NORMAL);
+        CANLib::obj_controller_power().SetValue(idx, power, CAN_TIMER_TYPE_NORMAL);
+        CANLib::PublishEnergy();
+
+		Freshness::Stamp(Freshness::OBJ_VOLTAGE, idx, packet_time);
+		Freshness::Stamp(Freshness::OBJ_CURRENT, idx, packet_time);
+		Freshness::Stamp(Freshness::OBJ_POWER, idx, packet_time);
+        
+		break;
+    }
+
+    case 0x04:
+    {
+        // Градусы : uint8, но до 200 градусов. Если больше то int8
+        CANLib::obj_controller_temperature().SetValue(idx, FardriverController<>::FixTemp(raw_packet->D2), CAN_TIMER_TYPE_NORMAL);
+		Freshness::Stamp(Freshness::OBJ_CONTROLLER_TEMP, idx, packet_time);
+        break;
+    }
+
+    case 0x0D:
+    {
+        // Градусы : uint8, но до 200 градусов. Если больше то int8
+        CANLib::obj_motor_temperature().SetValue(idx, FardriverController<>::FixTemp(raw_packet->D0), CAN_TIMER_TYPE_NORMAL);
+		Freshness::Stamp(Freshness::OBJ_MOTOR_TEMP, idx, packet_time);
+        break;
+    }
+
+    default:
+        return;
+    }
+}
+
+/// @brief Callback function: It is called when motor controller reports errors
+/// @param motor_idx Index of the motor
+/// @param code Motor error code
+void OnMotorError(const uint8_t motor_idx, const motor_error_t code)
+{
+    if (motor_idx > 2 || motor_idx == 0)
+        return;
+
+    FlightRecorder::Record(FlightRecorder::EVENT_MOTOR_ERROR, motor_idx, &code, sizeof(code));
+
+    CANLib::obj_controller_errors().SetValue(motor_idx - 1, (uint16_t)code, CAN_TIMER_TYPE_NORMAL, CAN_EVENT_TYPE_NORMAL);
+	Freshness::Stamp(Freshness::OBJ_ERRORS, motor_idx - 1, Motors::GetPacketTime(motor_idx));
+}
+
+void OnMotorHWError(const uint8_t motor_idx, const uint8_t code)
+{
+	ASYNC_LOG_TOPIC("MotorErr", "motor: %d, code: %d\r\n", motor_idx, code);
+	FlightRecorder::Record(FlightRecorder::EVENT_LINK_ERROR, motor_idx, &code, sizeof(code));
+
+	// После потери связи фильтры начинают с первого нового отсчёта, без старой истории.
+	if(code == FardriverController<>::ERROR_LOST)
+	{
+		Filters::Reset(motor_idx - 1);
+		Freshness::Reset(motor_idx - 1);
+	}
+
+	uint8_t value_old = CANLib::obj_block_health.GetValue(6);
+	uint8_t value_new = (motor_idx == 2) ? ((code << 4) | (value_old & 0x0F)) : (code | (value_old & 0xF0));
+	CANLib::obj_block_health.SetValue(6, value_new, CAN_TIMER_TYPE_NONE, CAN_EVENT_TYPE_NORMAL);
+	#warning Move to BlockError ???
+	
+	return;
+}
@@ -10,9 +10,61 @@ void OnMotorTX(const uint8_t motor_idx, const uint8_t *raw, const uint8_t raw_le
 
 namespace Motors
 {
+    static constexpr uint16_t CFG_LinkStatsPeriod = 250;	// Период публикации счётчиков связи, мс.
+
     FardriverController<1> motor1;
     FardriverController<2> motor2;
 
+	/*
+		Упаковывает следующий счётчик связи в 6 байт { motor[0] counter[1] value[2..5] }.
+		Обходит оба контроллера: сначала общие счётчики, затем ненулевые счётчики по адресам.
+	*/
+	inline void PackNextLinkStats(uint8_t *data)
+	{
+		static constexpr uint8_t slot_count = motor_link_stats_t::COUNT + motor_link_stats_t::addr_count;
+		static uint8_t motor = 0;
+		static uint8_t slot = 0;
+		
+		// Общие счётчики публикуются всегда, поэтому подходящий слот найдётся за один проход.
+		while(true)
+		{
+			uint8_t idx = motor;
+			uint8_t cur = slot;
+			if(++slot >= slot_count)
+			{
+				slot = 0;
+				motor ^= 1;
+			}
+			
+			const motor_link_stats_t &stats = (idx == 0) ? motor1.GetStats() : motor2.GetStats();
+			uint8_t counter = cur;
+			uint32_t value = 0;
+			if(cur < motor_link_stats_t::COUNT)
+			{
+				value = stats.counters[cur];
+			}
+			else
+			{
+				uint8_t addr = cur - motor_link_stats_t::COUNT;
+				value = stats.frames_by_addr[addr];
+				if(value == 0) continue;
+				
+				counter = 0x80 | addr;
+			}
+			
+			data[0] = idx + 1;
+			data[1] = counter;
+			data[2] = value & 0xFF;
+			data[3] = (value >> 8) & 0xFF;
+			data[4] = (value >> 16) & 0xFF;
+			data[5] = (value >> 24) & 0xFF;
+			
+			break;
+		}
+		
+		return;
+	}
+
     inline void Setup()
     {
         motor1.SetEventDataCallback(OnMotorEvent);
@@ -27,17 +79,44 @@ namespace Motors
 		motor1.SetTXCallback(OnMotorTX);
         motor2.SetTXCallback(OnMotorTX);
 		
+		auto timing = []()
+		{
+			motor1.SetTiming(Config::values.request_time, Config::values.unactive_timeout);
+			motor2.SetTiming(Config::values.request_time, Config::values.unactive_timeout);
+		};
+		Config::Subscribe(Config::KEY_REQUEST_TIME, timing);
+		Config::Subscribe(Config::KEY_UNACTIVE_TIMEOUT, timing);
+		
 		return;
 	}
 
     inline void Loop(uint32_t &current_time)
     {
-        motor1.Processing(current_time);
+		{
+			PROFILER_SCOPE(Profiler::PROBE_MOTOR_PROCESSING);
+			motor1.Processing(current_time);
+		}
 		current_time = HAL_GetTick();
 		
-		motor2.Processing(current_time);
+		{
+			PROFILER_SCOPE(Profiler::PROBE_MOTOR_PROCESSING);
+			motor2.Processing(current_time);
+		}
 		current_time = HAL_GetTick();
 		
+		static uint32_t link_stats_time = 0;
+		if(current_time - link_stats_time > CFG_LinkStatsPeriod)
+		{
+			link_stats_time = current_time;
+			
+			uint8_t data[6];
+			PackNextLinkStats(data);
+			for(uint8_t i = 0; i < sizeof(data); ++i)
+			{
+				CANLib::obj_link_stats().SetValue(i, data[i], CAN_TIMER_TYPE_NORMAL);
+			}
+		}
+		
 		return;
 	}
 
@@ -66,6 +145,27 @@ namespace Motors
     }
 	*/
 
+	inline uint32_t GetPacketTime(uint8_t idx)
+	{
+		return (idx == 1) ? motor1.GetPacketTime() : motor2.GetPacketTime();
+	}
+
+	inline bool IsBothActive()
+	{
+		return motor1.IsActive() && motor2.IsActive();
+	}
+
+	inline void RXErrorProcessing(uint8_t idx)
+	{
+		switch(idx)
+		{
+			case 1: { motor1.RXError(); break; }
+			case 2: { motor2.RXError(); break; }
+		}
+		
+		return;
+	}
+
 	inline void RXEventProcessing(uint8_t idx, uint8_t *hot_buffer, uint8_t length, uint32_t &time)
 	{
 		switch(idx)
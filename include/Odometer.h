@@ -0,0 +1,114 @@
+/*
+	Интегрирование пройденного пути по оборотам двигателей.
+
+	Путь каждого двигателя интегрируется методом трапеций по RPM и времени приёма
+		пакетов 0x00. Коэффициент пути - точная дробь Speed::distance_num / distance_den,
+		накопитель хранит целые мкм в 64 бита, а остаток от деления на знаменатель
+		переносится на следующий пакет, поэтому ни короткие интервалы (~550 мс), ни
+		округление коэффициента не дают ошибки, растущей с пробегом: она меньше 1 мкм.
+		Деление 64 бит - одно на двигатель и одно на общий пробег за пакет.
+
+	Общий пробег авто - среднее по двигателям: если на связи оба, каждый
+		добавляет половину своего приращения, если один - всё приращение.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace Odometer
+{
+	static constexpr uint8_t CFG_MotorCount = 2;
+	static constexpr uint32_t CFG_MaxGap = 2000;		// Разрыв мс между пакетами, после которого путь не интегрируется.
+	static constexpr uint32_t CFG_Unit = 100000000;		// Единица публикуемого одометра (100 м), мкм.
+
+	// Приращение (RPM_prev + RPM) * dt * distance_num - в единицах 1 / (2 * distance_den) мкм
+	// (трапеция даёт лишний множитель 2). Общий пробег - в единицах 1 / (4 * distance_den) мкм,
+	// чтобы делить приращение пополам без потерь. Худший случай - любая геометрия uint16_t:
+	static_assert((uint64_t)2 * 0xFFFF * CFG_MaxGap * (0xFFFF * 5 * Speed::PiNum) * 2 + 4ULL * 3 * Speed::PiDen * 0xFFFF < UINT64_MAX / 2,
+		"Odometer increment overflows uint64!");
+
+	struct motor_t
+	{
+		uint64_t distance;		// Путь двигателя, мкм.
+		uint64_t frac;			// Остаток, 2 * distance_den = 1 мкм.
+		uint32_t last_time;		// Время мс предыдущего пакета.
+		uint16_t last_rpm;		// RPM предыдущего пакета.
+		bool init;				// Есть предыдущая точка.
+	};
+
+	motor_t motors[CFG_MotorCount] = {};
+
+	uint64_t total = 0;			// Общий пробег авто, мкм.
+	uint64_t total_frac = 0;	// Остаток, 4 * distance_den = 1 мкм.
+	uint32_t distance_den = 1;	// Знаменатель, в котором хранятся остатки.
+
+	/*
+		Переводит остатки в новый знаменатель после смены геометрии колеса.
+	*/
+	inline void _Rescale()
+	{
+		for(uint8_t idx = 0; idx < CFG_MotorCount; ++idx)
+		{
+			motors[idx].frac = motors[idx].frac * Speed::distance_den / distance_den;
+		}
+		total_frac = total_frac * Speed::distance_den / distance_den;
+		distance_den = Speed::distance_den;
+
+		return;
+	}
+
+	/*
+		Добавляет точку RPM двигателя idx (0..1), принятую в момент time.
+		shared - на связи оба двигателя.
+	*/
+	inline void Integrate(uint8_t idx, uint16_t rpm, uint32_t time, bool shared)
+	{
+		if(idx >= CFG_MotorCount) return;
+
+		motor_t &motor = motors[idx];
+		uint32_t dt = time - motor.last_time;
+
+		if(motor.init == true && dt <= CFG_MaxGap)
+		{
+			if(distance_den != Speed::distance_den) _Rescale();
+
+			uint64_t inc = (uint64_t)(((uint32_t)motor.last_rpm + rpm) * dt) * Speed::distance_num;
+
+			uint64_t unit = 2ULL * distance_den;
+			motor.frac += inc;
+			motor.distance += motor.frac / unit;
+			motor.frac %= unit;
+
+			unit = 4ULL * distance_den;
+			total_frac += (shared == true) ? inc : (inc << 1);
+			total += total_frac / unit;
+			total_frac %= unit;
+		}
+
+		motor.last_time = time;
+		motor.last_rpm = rpm;
+		motor.init = true;
+
+		return;
+	}
+
+	/*
+		Восстанавливает общий пробег, мкм.
+	*/
+	inline void Restore(uint64_t distance)
+	{
+		total = distance;
+		total_frac = 0;
+
+		return;
+	}
+
+	/*
+		Общий пробег в единицах публикуемого одометра (100 м).
+	*/
+	inline uint32_t GetTotal()
+	{
+		return (uint32_t)(total / CFG_Unit);
+	}
+}
@@ -0,0 +1,254 @@
+/*
+	Замер разбора пакетов контроллера: FardriverController::RXByte / _ValidateBuffer,
+		FardriverCRC::GetCRC_new и декодирование пакета (OnMotorEvent).
+
+	Поток собирается блоками по CFG_BlockPackets пакетов с адресами 0x00, 0x01, 0x04, 0x0D
+		по кругу и случайными данными. Искажение - инверсия случайного бита с вероятностью
+		corruption промилле на байт, без потерь байт, поэтому границы пакетов не смещаются.
+		Генератор детерминированный (xorshift32 от CFG_Seed): поток одинаков на хосте и на
+		целевой платформе. Сборка блока в замер не входит.
+	Пакеты идут с интервалом CFG_PacketPeriod мс, байты пакета - в одну миллисекунду.
+
+	RXByte меряется на всех уровнях искажений, GetCRC_new и декодирование от содержимого
+		пакета не зависят и меряются на чистом потоке. Декодер правит пакет на месте,
+		поэтому каждый пакет декодируется один раз.
+
+	Часы передаются снаружи: на целевой платформе такты DWT->CYCCNT, на хосте наносекунды
+		(native/parser_bench.cpp). Результат - строка JSON на замер:
+		{"bench":"rx","corruption":10,"unit":"cycles","packets":256,"bytes":4096,"frames":..,
+			"ticks":..,"per_packet":..,"per_byte":..}
+		corruption - промилле, per_* - с двумя знаками, для наносекунд ещё и bytes_per_s.
+	Сравнение с эталоном: tools/bench_compare.py.
+
+	На целевой платформе выполняется один раз при старте в сборке env:Bench (-DPARSER_BENCH),
+		результат уходит в отладочный UART. Декодирование в этой сборке пишет в CANObjects
+		и самописец, поэтому для работы на машине она не годится.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <FardriverController.h>
+#include <FardriverCRC.h>
+#include <FardriverPacket.h>
+
+namespace ParserBench
+{
+	static constexpr uint8_t CFG_BlockPackets = 16;		// Пакетов в блоке.
+	static constexpr uint32_t CFG_Seed = 0x2545F491;	// Зерно генератора потока.
+	static constexpr uint8_t CFG_PacketPeriod = 15;		// Интервал пакетов, мс.
+	static constexpr uint16_t CFG_TargetBlocks = 16;	// Блоков на замер на целевой платформе.
+
+	static constexpr uint16_t corruptions[] = { 0, 10, 50 };	// Промилле на байт.
+
+	enum bench_t : uint8_t
+	{
+		BENCH_RX = 0,			// RXByte + _ValidateBuffer.
+		BENCH_CRC_NEW = 1,		// FardriverCRC::GetCRC_new по 14 байтам.
+		BENCH_DECODE = 2,		// Колбек данных (OnMotorEvent).
+		BENCH_COUNT
+	};
+
+	static constexpr const char *bench_names[BENCH_COUNT] = { "rx", "crc_new", "decode" };
+
+	using ticks_t = uint32_t (*)();
+
+	struct result_t
+	{
+		bench_t bench;
+		uint16_t corruption;	// Промилле.
+		uint32_t packets;		// Пакетов в потоке.
+		uint32_t frames;		// Пакетов, принятых парсером (для rx).
+		uint32_t ticks;			// Сумма по всем блокам.
+	};
+
+	struct block_t
+	{
+		uint8_t wire[CFG_BlockPackets][FardriverPacket::Size];		// Порядок линии, с искажениями.
+		uint8_t packet[CFG_BlockPackets][FardriverPacket::Size];	// Порядок структуры, без искажений.
+	};
+
+	inline uint32_t _Next(uint32_t &state)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+
+		return state;
+	}
+
+	inline void _Build(block_t &block, uint32_t &seed, uint16_t corruption)
+	{
+		static constexpr uint8_t addrs[] = { 0x00, 0x01, 0x04, 0x0D };
+
+		for(uint8_t i = 0; i < CFG_BlockPackets; ++i)
+		{
+			uint8_t *buffer = block.packet[i];
+			for(uint8_t j = 0; j < FardriverPacket::Size; ++j)
+			{
+				buffer[j] = _Next(seed);
+			}
+			((motor_packet_raw_t *)buffer)->_A1 = addrs[i % sizeof(addrs)];
+			FardriverPacket::Encode(buffer, block.wire[i]);
+
+			for(uint8_t j = 0; j < FardriverPacket::Size; ++j)
+			{
+				if(_Next(seed) % 1000 < corruption)
+				{
+					block.wire[i][j] ^= 1 << (_Next(seed) & 0x07);
+				}
+			}
+		}
+
+		return;
+	}
+
+	inline result_t RunRX(ticks_t ticks, uint16_t corruption, uint32_t blocks)
+	{
+		block_t block;
+		FardriverController<0> controller;
+		FardriverControllerInterface &parser = controller;
+		uint32_t seed = CFG_Seed;
+		uint32_t time = 0;
+		result_t result = { BENCH_RX, corruption, 0, 0, 0 };
+
+		for(uint32_t b = 0; b < blocks; ++b)
+		{
+			_Build(block, seed, corruption);
+
+			uint32_t start = ticks();
+			for(uint8_t i = 0; i < CFG_BlockPackets; ++i)
+			{
+				for(uint8_t j = 0; j < FardriverPacket::Size; ++j)
+				{
+					parser.RXByte(block.wire[i][j], time);
+				}
+				time += CFG_PacketPeriod;
+			}
+			result.ticks += ticks() - start;
+			result.packets += CFG_BlockPackets;
+		}
+		result.frames = parser.GetStats().counters[motor_link_stats_t::FRAMES];
+
+		return result;
+	}
+
+	inline result_t RunCRC(ticks_t ticks, uint32_t blocks)
+	{
+		block_t block;
+		FardriverCRC crc;
+		volatile uint16_t sink = 0;
+		uint32_t seed = CFG_Seed;
+		result_t result = { BENCH_CRC_NEW, 0, 0, 0, 0 };
+
+		for(uint32_t b = 0; b < blocks; ++b)
+		{
+			_Build(block, seed, 0);
+
+			uint32_t start = ticks();
+			for(uint8_t i = 0; i < CFG_BlockPackets; ++i)
+			{
+				sink = sink ^ crc.GetCRC_new(block.wire[i], FardriverPacket::Size - 2);
+			}
+			result.ticks += ticks() - start;
+			result.packets += CFG_BlockPackets;
+		}
+		result.frames = result.packets;
+
+		return result;
+	}
+
+	inline result_t RunDecode(ticks_t ticks, event_data_callback_t callback, uint32_t blocks)
+	{
+		block_t block;
+		uint32_t seed = CFG_Seed;
+		result_t result = { BENCH_DECODE, 0, 0, 0, 0 };
+
+		for(uint32_t b = 0; b < blocks; ++b)
+		{
+			_Build(block, seed, 0);
+
+			uint32_t start = ticks();
+			for(uint8_t i = 0; i < CFG_BlockPackets; ++i)
+			{
+				callback(1, (motor_packet_raw_t *)block.packet[i]);
+			}
+			result.ticks += ticks() - start;
+			result.packets += CFG_BlockPackets;
+		}
+		result.frames = result.packets;
+
+		return result;
+	}
+
+	/*
+		Строка JSON результата, unit - "cycles" или "ns".
+	*/
+	inline int Format(const result_t &result, const char *unit, char *out, uint16_t size)
+	{
+		uint32_t bytes = result.packets * FardriverPacket::Size;
+		uint32_t per_packet = (uint64_t)result.ticks * 100 / ((result.packets != 0) ? result.packets : 1);
+		uint32_t per_byte = (uint64_t)result.ticks * 100 / ((bytes != 0) ? bytes : 1);
+
+		int length = snprintf(out, size, "{\"bench\":\"%s\",\"corruption\":%u,\"unit\":\"%s\",\"packets\":%" PRIu32 ",\"bytes\":%" PRIu32
+			",\"frames\":%" PRIu32 ",\"ticks\":%" PRIu32 ",\"per_packet\":%" PRIu32 ".%02" PRIu32 ",\"per_byte\":%" PRIu32 ".%02" PRIu32,
+			bench_names[result.bench], result.corruption, unit, result.packets, bytes, result.frames, result.ticks,
+			per_packet / 100, per_packet % 100, per_byte / 100, per_byte % 100);
+
+		if(length > 0 && length < size && unit[0] == 'n')
+		{
+			uint64_t bytes_per_s = (uint64_t)bytes * 1000000000ULL / ((result.ticks != 0) ? result.ticks : 1);
+			length += snprintf(out + length, size - length, ",\"bytes_per_s\":%" PRIu64, bytes_per_s);
+		}
+		if(length > 0 && length < size)
+		{
+			length += snprintf(out + length, size - length, "}");
+		}
+
+		return length;
+	}
+
+#if defined(PARSER_BENCH)
+
+	inline uint32_t _Cycles()
+	{
+		return DWT->CYCCNT;
+	}
+
+	inline void _Print(const result_t &result)
+	{
+		char line[200];
+		Format(result, "cycles", line, sizeof(line));
+		Logger.Printf("%s", line).PrintNewLine();
+
+		return;
+	}
+
+	/*
+		Все замеры подряд, вызывается после Motors::Setup().
+	*/
+	inline void Setup()
+	{
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+		AsyncLog::Sync();
+
+		for(uint16_t corruption : corruptions)
+		{
+			_Print(RunRX(_Cycles, corruption, CFG_TargetBlocks));
+		}
+		_Print(RunCRC(_Cycles, CFG_TargetBlocks));
+		_Print(RunDecode(_Cycles, OnMotorEvent, CFG_TargetBlocks));
+
+		return;
+	}
+
+#else
+
+	inline void Setup() {}
+
+#endif
+}
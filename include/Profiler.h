@@ -0,0 +1,170 @@
+/*
+	Профилирование обработчиков и этапов основного цикла по счётчику тактов DWT->CYCCNT.
+
+	Каждая точка замера (probe) хранит min / max / сумму / количество в статической таблице.
+		Замер - объект Scope на стеке: считывание CYCCNT в конструкторе и деструкторе.
+		У каждой точки один писатель (ISR либо основной цикл), поэтому блокировки не нужны.
+
+	Включается только в Debug (-DDEBUG), в Release макросы PROFILER_* пустые.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stm32f1xx_hal.h>
+
+#if defined(DEBUG)
+	#define PROFILER_ENABLED
+#endif
+
+#if defined(PROFILER_ENABLED)
+	#define PROFILER_SCOPE(probe) Profiler::Scope _profiler_scope(probe)
+#else
+	#define PROFILER_SCOPE(probe)
+#endif
+
+namespace Profiler
+{
+	enum probe_id_t : uint8_t
+	{
+		PROBE_UART_RX = 0,			// HAL_UARTEx_RxEventCallback
+		PROBE_CAN_RX = 1,			// HAL_CAN_RxFifo0MsgPendingCallback
+		PROBE_MOTOR_PROCESSING = 2,	// FardriverController::Processing
+		PROBE_CAN_PROCESS = 3,		// CANManager::Process
+		PROBE_COUNT
+	};
+
+#if defined(PROFILER_ENABLED)
+
+	static constexpr uint32_t CFG_DumpPeriod = 10000;	// Период вывода таблицы в отладочный UART, мс.
+	static constexpr uint32_t CFG_TracePeriod = 1000;	// Период записи точек в двоичную трассу, мс.
+
+	static constexpr const char *probe_names[PROBE_COUNT] = { "UartRx", "CanRx", "MotorProc", "CanProc" };
+
+	struct probe_t
+	{
+		uint32_t min;
+		uint32_t max;
+		uint64_t sum;
+		uint32_t count;
+	};
+
+	probe_t probes[PROBE_COUNT];
+
+	inline void Record(probe_id_t probe, uint32_t cycles)
+	{
+		probe_t &obj = probes[probe];
+
+		if(cycles < obj.min) obj.min = cycles;
+		if(cycles > obj.max) obj.max = cycles;
+		obj.sum += cycles;
+		obj.count++;
+
+		return;
+	}
+
+	class Scope
+	{
+	public:
+		Scope(probe_id_t probe) : _probe(probe), _start(DWT->CYCCNT) {}
+		~Scope() { Record(_probe, DWT->CYCCNT - _start); }
+
+	private:
+		const probe_id_t _probe;
+		const uint32_t _start;
+	};
+
+	inline void Reset()
+	{
+		for(uint8_t i = 0; i < PROBE_COUNT; ++i)
+		{
+			probes[i] = { UINT32_MAX, 0, 0, 0 };
+		}
+
+		return;
+	}
+
+	inline uint32_t Mean(probe_id_t probe)
+	{
+		return (probes[probe].count != 0) ? (uint32_t)(probes[probe].sum / probes[probe].count) : 0;
+	}
+
+	/*
+		Упаковывает точку в 7 байт CAN: { probe[0] min[1..2] max[3..4] mean[5..6] }, такты с насыщением до 0xFFFF.
+	*/
+	inline void Pack(probe_id_t probe, uint8_t *data)
+	{
+		const probe_t &obj = probes[probe];
+		uint32_t values[3] = { (obj.count != 0) ? obj.min : 0, obj.max, Mean(probe) };
+
+		data[0] = probe;
+		for(uint8_t i = 0; i < 3; ++i)
+		{
+			uint16_t value = (values[i] > 0xFFFF) ? 0xFFFF : values[i];
+			data[1 + i * 2] = value & 0xFF;
+			data[2 + i * 2] = value >> 8;
+		}
+
+		return;
+	}
+
+	/*
+		Выводит таблицу в отладочный UART через AsyncLog, строка на точку с её именем вместо топика.
+		false - в кольце AsyncLog нет места на всю таблицу, вывод откладывается.
+	*/
+	inline bool Dump()
+	{
+		if(AsyncLog::Free() < PROBE_COUNT) return false;
+
+		for(uint8_t i = 0; i < PROBE_COUNT; ++i)
+		{
+			const probe_t &obj = probes[i];
+			ASYNC_LOG_TOPIC(probe_names[i], "min:%lu max:%lu mean:%lu count:%lu\r\n",
+				(obj.count != 0) ? obj.min : 0, obj.max, Mean((probe_id_t)i), obj.count);
+		}
+
+		return true;
+	}
+
+	inline void Setup()
+	{
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CYCCNT = 0;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+		Reset();
+
+		return;
+	}
+
+	inline void Loop(uint32_t &current_time)
+	{
+		static uint32_t last_dump = 0;
+		if(current_time - last_dump > CFG_DumpPeriod && Dump() == true)
+		{
+			last_dump = current_time;
+		}
+
+		static uint32_t last_trace = 0;
+		if(Trace::enabled == true && current_time - last_trace > CFG_TracePeriod)
+		{
+			last_trace = current_time;
+
+			uint8_t data[7];
+			for(uint8_t i = 0; i < PROBE_COUNT; ++i)
+			{
+				Pack((probe_id_t)i, data);
+				Trace::Record(Trace::TRACE_PROFILER, 0, data, sizeof(data));
+			}
+		}
+
+		return;
+	}
+
+#else
+
+	inline void Setup() {}
+	inline void Loop(uint32_t & /* current_time */) {}
+
+#endif
+}
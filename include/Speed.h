@@ -0,0 +1,104 @@
+/*
+	Расчёт скорости по оборотам двигателя.
+
+	Коэффициент скорости хранится в формате Q16 и пересчитывается только при
+		изменении геометрии (диаметр колеса, передаточное число), поэтому на
+		каждый пакет приходится одно умножение и сдвиг, без деления.
+
+	speed[100м/ч] = RPM * Pi * D[мм] * 60 / (100000 * gear)
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace Speed
+{
+	static constexpr uint16_t CFG_WheelDiameter = 680;	// Диаметр колеса по умолчанию, мм.
+	static constexpr uint16_t CFG_GearRatio = 100;		// Передаточное число по умолчанию, x100 (1.00 - прямой привод).
+	static constexpr uint16_t CFG_WheelDiameterMin = 100;	// Допустимый диаметр колеса, мм.
+	static constexpr uint16_t CFG_WheelDiameterMax = 2000;
+	static constexpr uint16_t CFG_GearRatioMin = 10;		// Допустимое передаточное число, x100.
+	static constexpr uint16_t CFG_GearRatioMax = 5000;
+	static constexpr uint8_t CFG_CoefShift = 16;		// Количество дробных бит коэффициента скорости.
+	static constexpr uint16_t CFG_SpeedMax = 0xFFFF;	// Значение насыщения скорости.
+
+	// Приближение Pi дробью 355/113, погрешность 8.5e-8.
+	static constexpr uint64_t PiNum = 355;
+	static constexpr uint64_t PiDen = 113;
+
+	// Коэффициенты на краях допустимой геометрии помещаются в свои типы.
+	static_assert(((((uint64_t)CFG_WheelDiameterMax * 6U * PiNum) << CFG_CoefShift) + 100U * PiDen * CFG_GearRatioMin) / (100U * PiDen * CFG_GearRatioMin) <= UINT32_MAX,
+		"speed_coef overflows uint32 at the largest wheel and the smallest gear ratio!");
+	static_assert((uint64_t)0xFFFF * 5U * PiNum <= UINT32_MAX && 3U * PiDen * 0xFFFF <= UINT32_MAX, "distance_num / distance_den overflow uint32!");
+
+	uint16_t wheel_diameter = CFG_WheelDiameter;	// Диаметр колеса, мм.
+	uint16_t gear_ratio = CFG_GearRatio;			// Передаточное число, x100.
+
+	uint32_t speed_coef = 0;						// Коэффициент скорости Q16, 100м/ч на 1 об/мин двигателя.
+	uint32_t distance_num = 0;						// Путь мкм на (об/мин * мс) = distance_num / distance_den.
+	uint32_t distance_den = 1;
+
+	/*
+		Пересчитывает коэффициенты по текущей геометрии.
+	*/
+	inline void Recalc()
+	{
+		// Pi * D * 60 / (100000 * gear_ratio / 100) = Pi * D * 6 / (100 * gear_ratio)
+		uint64_t num = ((uint64_t)wheel_diameter * 6U * PiNum) << CFG_CoefShift;
+		uint64_t den = 100U * PiDen * gear_ratio;
+		speed_coef = (num + (den >> 1)) / den;
+
+		// Путь за оборот двигателя Pi * D * 1000 / (gear_ratio / 100), мкм, делённый на 60000 мс в минуте:
+		// Pi * D * 5 / (3 * gear_ratio). Хранится точной дробью, округление накапливалось бы с каждым пакетом.
+		distance_num = (uint32_t)(wheel_diameter * 5U * PiNum);
+		distance_den = (uint32_t)(3U * PiDen * gear_ratio);
+
+		return;
+	}
+
+	/*
+		Устанавливает диаметр колеса, мм.
+	*/
+	inline bool SetWheelDiameter(uint16_t diameter)
+	{
+		if(diameter < CFG_WheelDiameterMin || diameter > CFG_WheelDiameterMax) return false;
+		if(diameter == wheel_diameter) return true;
+
+		wheel_diameter = diameter;
+		Recalc();
+
+		return true;
+	}
+
+	/*
+		Устанавливает передаточное число от двигателя к колесу, x100.
+	*/
+	inline bool SetGearRatio(uint16_t ratio)
+	{
+		if(ratio < CFG_GearRatioMin || ratio > CFG_GearRatioMax) return false;
+		if(ratio == gear_ratio) return true;
+
+		gear_ratio = ratio;
+		Recalc();
+
+		return true;
+	}
+
+	/*
+		Скорость в сотнях метров в час по оборотам двигателя, с насыщением.
+	*/
+	inline uint16_t Calc(uint16_t rpm)
+	{
+		uint64_t speed = ((uint64_t)rpm * speed_coef + (1UL << (CFG_CoefShift - 1))) >> CFG_CoefShift;
+
+		return (speed > CFG_SpeedMax) ? CFG_SpeedMax : (uint16_t)speed;
+	}
+
+	inline void Setup()
+	{
+		Recalc();
+
+		return;
+	}
+}
@@ -0,0 +1,160 @@
+/*
+	Хранение пробега и счётчиков энергии во flash.
+
+	Последние CFG_PageCount страниц flash - кольцевой журнал FlashJournal.h: запись дописывается
+		в следующий слот, страницы стираются по очереди, актуальная запись - с наибольшим seq
+		и верной CRC.
+
+	Запись выполняется из Loop() по шагу журнала: программирование одного полуслова или
+		стирание одной страницы (из RAM, приём от контроллеров и из CAN на это время
+		продолжается, основной цикл стоит 20..40 мс). Следующая страница стирается заранее,
+		поэтому по сигналу PVD (падение питания) запись дописывается сразу, только
+		программированием полуслов.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+namespace Storage
+{
+	static constexpr uint32_t CFG_FlashEnd = FLASH_BASE + 0x10000;		// Конец flash STM32F103C8 (64 КБ).
+	static constexpr uint8_t CFG_PageCount = 4;							// Количество страниц журнала.
+	static constexpr uint32_t CFG_PageSize = FLASH_PAGE_SIZE;
+	static constexpr uint32_t CFG_Start = CFG_FlashEnd - CFG_PageCount * CFG_PageSize;
+	static constexpr uint64_t CFG_SaveDistance = 250000000ULL;			// Путь мкм между записями.
+	static constexpr uint16_t CFG_Version = 1;							// Версия формата записи.
+
+	struct __attribute__((__packed__)) record_t
+	{
+		uint32_t seq;			// Порядковый номер записи.
+		uint64_t odometer;		// Общий пробег, мкм.
+		uint32_t energy[Energy::CFG_MotorCount][Energy::COUNTER_COUNT];	// Счётчики энергии и заряда двигателей.
+		uint32_t reserved[4];	// Резерв.
+		uint16_t version;		// Версия формата.
+		uint16_t crc;			// CRC-16/CCITT всех предыдущих полей.
+
+		bool Valid() const
+		{
+			return version == CFG_Version;
+		}
+	};
+	static_assert(sizeof(record_t) == 64, "Record size must stay 64 bytes!");
+
+	FlashJournal<record_t, CFG_Start, CFG_PageCount> journal;
+	uint64_t saved_odometer = 0;	// Пробег в последней записи.
+	volatile bool urgent = false;	// Запрос немедленной записи.
+	bool requested = false;			// Запрос записи в обычном порядке.
+
+	/*
+		Начинает запись текущих счётчиков.
+	*/
+	inline void Write()
+	{
+		record_t record = {};
+		record.odometer = Odometer::total;
+		for(uint8_t idx = 0; idx < Energy::CFG_MotorCount; ++idx)
+		{
+			for(uint8_t counter = 0; counter < Energy::COUNTER_COUNT; ++counter)
+			{
+				record.energy[idx][counter] = Energy::Get(idx, (Energy::counter_idx_t)counter);
+			}
+		}
+		record.version = CFG_Version;
+
+		journal.Write(record);
+		saved_odometer = record.odometer;
+
+		return;
+	}
+
+	/*
+		(Interrupt) Запрос немедленной записи, например при падении питания.
+	*/
+	inline void Urgent()
+	{
+		urgent = true;
+
+		return;
+	}
+
+	/*
+		Запрос записи в обычном порядке, например после сброса счётчиков.
+	*/
+	inline void Request()
+	{
+		requested = true;
+
+		return;
+	}
+
+	/*
+		Находит последнюю запись и восстанавливает счётчики.
+	*/
+	inline void Setup()
+	{
+		const record_t *last = journal.Setup();
+		if(last != nullptr)
+		{
+			saved_odometer = last->odometer;
+			Odometer::Restore(saved_odometer);
+			for(uint8_t motor = 0; motor < Energy::CFG_MotorCount; ++motor)
+			{
+				for(uint8_t counter = 0; counter < Energy::COUNTER_COUNT; ++counter)
+				{
+					Energy::Restore(motor, (Energy::counter_idx_t)counter, last->energy[motor][counter]);
+				}
+			}
+		}
+
+		PWR_PVDTypeDef pvd = {};
+		pvd.PVDLevel = PWR_PVDLEVEL_7;
+		pvd.Mode = PWR_PVD_MODE_IT_RISING;
+		HAL_PWR_ConfigPVD(&pvd);
+		HAL_PWR_EnablePVD();
+
+		HAL_NVIC_SetPriority(PVD_IRQn, 0, 0);
+		HAL_NVIC_EnableIRQ(PVD_IRQn);
+
+		return;
+	}
+
+	inline void Loop(uint32_t &current_time)
+	{
+		bool flush = urgent;
+		urgent = false;
+
+		if(flush == true)
+		{
+			// Дописываем начатую запись и сразу сохраняем актуальные счётчики. Стирание
+			// здесь не выполняется: на него может не хватить времени до сброса по питанию.
+			journal.Flush();
+			if(journal.Writing() == false && Odometer::total != saved_odometer)
+			{
+				Write();
+				journal.Flush();
+			}
+		}
+		else if(journal.Busy() == true)
+		{
+			if(journal.Step() == true)
+			{
+				ASYNC_LOG_TOPIC("STOR", "erase: %lu cycles, lost %lu\r\n", FlashErase::cycles, FlashErase::lost);
+			}
+		}
+		else if(requested == true || Odometer::total - saved_odometer >= CFG_SaveDistance)
+		{
+			requested = false;
+			Write();
+		}
+		else
+		{
+			return;
+		}
+
+		current_time = HAL_GetTick();
+
+		return;
+	}
+}
@@ -0,0 +1,92 @@
+/*
+	Напряжение питания платы: ADC1 канал 5 (PA5) через делитель.
+
+	Отсчёты идут без участия CPU: событие CC2 таймера TIM2 (1 МГц / 90 = 11.1 кГц) запускает
+		преобразование, DMA1 канал 1 по кругу пишет результаты в samples. Прерывания DMA
+		приходят на половине и в конце буфера, OnBlock() суммирует половину - CFG_BlockSize
+		отсчётов. Передискретизация 64 = 4^3 даёт +3 бита: блок децимируется в одно 15-битное
+		значение, ~174 блока в секунду.
+	Loop() сглаживает блоки IIR и раз в CFG_CANPeriod мс публикует напряжение в мВ.
+
+	Коэффициент делителя на входе - ключ Config KEY_SUPPLY_GAIN (x1000, по умолчанию 11.000 для
+		10к / 1к): калибруется по мультиметру без перепрошивки и применяется со следующего блока.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stm32f1xx_hal.h>
+#include <SignalFilter.h>
+
+extern ADC_HandleTypeDef hadc1;
+extern TIM_HandleTypeDef htim2;
+
+namespace Supply
+{
+	static constexpr uint16_t CFG_CANPeriod = 100;			// Период обновления значения в CAN, мс.
+	static constexpr uint8_t CFG_BlockSize = 64;			// Отсчётов в блоке децимации.
+	static constexpr uint8_t CFG_BlockShift = 3;			// Сумма 64 x 12 бит -> 15 бит.
+	static constexpr uint32_t CFG_VrefMv = 3300;			// Опорное напряжение АЦП, мВ.
+	static constexpr uint32_t CFG_GainScale = 1000;			// Единица Config::values.supply_gain.
+
+	static constexpr uint32_t CFG_FullScale = (uint32_t)CFG_BlockSize * 4096 >> CFG_BlockShift;
+	static_assert((uint64_t)CFG_VrefMv * Config::CFG_SupplyGainMax / CFG_GainScale <= UINT16_MAX, "Supply voltage at the largest gain overflows uint16 mV!");
+
+	uint16_t samples[CFG_BlockSize * 2];		// Кольцевой буфер DMA.
+	volatile uint16_t block = 0;				// Последний децимированный блок, 0..CFG_FullScale.
+	volatile uint32_t blocks = 0;				// Блоков с запуска.
+
+	// alpha = 1/16: постоянная времени ~90 мс при 174 блоках в секунду.
+	SignalFilter filter = {0, 4, 0};
+	uint16_t millivolts = 0;
+
+	/*
+		(Interrupt) Половина буфера samples заполнена, вызывается из колбэков DMA ADC.
+	*/
+	inline void OnBlock(const uint16_t *data)
+	{
+		uint32_t sum = 0;
+		for(uint8_t i = 0; i < CFG_BlockSize; ++i)
+		{
+			sum += data[i];
+		}
+		block = sum >> CFG_BlockShift;
+		blocks++;
+
+		return;
+	}
+
+	/*
+		Запуск измерений, после InitPeripherals().
+	*/
+	inline void Setup()
+	{
+		HAL_ADCEx_Calibration_Start(&hadc1);
+		HAL_ADC_Start_DMA(&hadc1, (uint32_t *)samples, CFG_BlockSize * 2);
+		HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_2);
+
+		return;
+	}
+
+	inline void Loop(uint32_t &current_time)
+	{
+		static uint32_t last_blocks = 0;
+		if(blocks != last_blocks)
+		{
+			last_blocks = blocks;
+
+			uint32_t value = filter.Process(block);
+			millivolts = (uint64_t)value * CFG_VrefMv * Config::values.supply_gain / (CFG_GainScale * CFG_FullScale);
+		}
+
+		static uint32_t can_time = 0;
+		if(current_time - can_time > CFG_CANPeriod && last_blocks != 0)
+		{
+			can_time = current_time;
+
+			CANLib::obj_supply_voltage().SetValue(0, millivolts, CAN_TIMER_TYPE_NORMAL);
+		}
+
+		return;
+	}
+}
@@ -0,0 +1,236 @@
+/*
+	Двоичная трассировка в отладочный UART.
+
+	Каждое событие - кадр COBS с разделителем 0x00:
+		{ type[0] source[1] time[2..5] data[6..N-2] crc8[N-1] }, time - мс, little-endian,
+		crc8 (полином 0x07) по всем байтам до него.
+	Типы 0x01..0x7F совпадают с FlightRecorder::event_t (все события самописца дублируются в трассу),
+		0x80 и выше - собственные типы трассы.
+
+	Трасса делит USART1 с AsyncLog. Каждая порция DMA начинается с 0x00, поэтому текстовые строки
+		между порциями декодер видит как отдельный кадр с неверной CRC и пропускает.
+	Декодер: tools/trace_decode.py, пишет CSV.
+
+	Запись приёма от контроллеров (TRACE_UART_RX) - для воспроизведения на хосте: каждая порция
+		HAL_UARTEx_RxEventCallback режется на куски по CFG_DataSize - 1 байт со сквозным номером
+		куска на контроллер, по разрыву номеров видно потерю. Время - то же, что получил парсер.
+		Преобразование в файл записи: tools/uart_capture.py, воспроизведение: native/uart_replay.
+
+	По умолчанию выключена, включается через BlockCfg (BLOCK_CFG_TRACE), запись приёма -
+		через BLOCK_CFG_CAPTURE, она включает и трассу.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <stm32f1xx_hal.h>
+
+namespace Trace
+{
+	static constexpr uint8_t CFG_RingSize = 32;			// Количество записей, степень двойки.
+	static constexpr uint8_t CFG_DataSize = 14;			// Максимум данных записи.
+	static constexpr uint16_t CFG_TXBufferSize = 256;	// Буфер передачи DMA.
+
+	static_assert((CFG_RingSize & (CFG_RingSize - 1)) == 0, "CFG_RingSize must be a power of two!");
+
+	enum type_t : uint8_t
+	{
+		TRACE_PROFILER = 0x80,		// data: Profiler::Pack()[7].
+		TRACE_DROPPED = 0x81,		// data: количество потерянных записей[4].
+		TRACE_UART_RX = 0x82,		// data: { seq[0] bytes[1..] }, source - номер контроллера.
+	};
+
+	static constexpr uint8_t HeaderSize = 6;
+	static constexpr uint8_t FrameMax = HeaderSize + CFG_DataSize + 1;
+	static constexpr uint8_t EncodedMax = FrameMax + 1 + 1;		// + байт COBS + разделитель.
+
+	struct entry_t
+	{
+		uint8_t frame[FrameMax - 1];	// Кадр без crc8.
+		uint8_t length;
+		volatile bool ready;
+	};
+
+	entry_t ring[CFG_RingSize];
+	volatile uint32_t head = 0;
+	volatile uint32_t tail = 0;
+	volatile uint32_t drops = 0;
+
+	uint8_t tx_buffer[CFG_TXBufferSize];
+
+	volatile bool enabled = false;
+	volatile bool capture = false;
+	uint8_t capture_seq[3];			// Номер следующего куска по контроллерам 1 и 2.
+
+	inline uint8_t CRC8(const uint8_t *data, uint8_t length)
+	{
+		uint8_t crc = 0x00;
+		while(length--)
+		{
+			crc ^= *data++;
+			for(uint8_t i = 0; i < 8; ++i)
+			{
+				crc = (crc & 0x80) ? ((crc << 1) ^ 0x07) : (crc << 1);
+			}
+		}
+
+		return crc;
+	}
+
+	/*
+		Кодирует src в COBS с завершающим 0x00, возвращает длину.
+	*/
+	inline uint16_t COBSEncode(const uint8_t *src, uint8_t length, uint8_t *dst)
+	{
+		uint16_t code_idx = 0;
+		uint16_t out = 1;
+		uint8_t code = 1;
+
+		for(uint8_t i = 0; i < length; ++i)
+		{
+			if(src[i] != 0x00)
+			{
+				dst[out++] = src[i];
+				code++;
+			}
+			if(src[i] == 0x00 || code == 0xFF)
+			{
+				dst[code_idx] = code;
+				code_idx = out++;
+				code = 1;
+			}
+		}
+		dst[code_idx] = code;
+		dst[out++] = 0x00;
+
+		return out;
+	}
+
+	/*
+		(Interrupt) Добавляет событие в трассу.
+	*/
+	inline void Record(uint8_t type, uint8_t source, const void *data, uint8_t length, uint32_t time = HAL_GetTick())
+	{
+		if(enabled == false) return;
+
+		uint32_t idx;
+		do
+		{
+			idx = __LDREXW(&head);
+			if(idx - tail >= CFG_RingSize)
+			{
+				__CLREX();
+				AsyncLog::_AtomicIncrement(&drops);
+				return;
+			}
+		}
+		while(__STREXW(idx + 1, &head) != 0);
+
+		if(length > CFG_DataSize) length = CFG_DataSize;
+
+		entry_t &entry = ring[idx & (CFG_RingSize - 1)];
+		entry.frame[0] = type;
+		entry.frame[1] = source;
+		memcpy(&entry.frame[2], &time, sizeof(time));
+		memcpy(&entry.frame[HeaderSize], data, length);
+		entry.length = HeaderSize + length;
+		__DMB();
+		entry.ready = true;
+
+		return;
+	}
+
+	/*
+		(Interrupt) Записывает порцию приёма от контроллера source (1 или 2), time - время, переданное парсеру.
+	*/
+	inline void RecordUART(uint8_t source, const uint8_t *data, uint16_t length, uint32_t time)
+	{
+		if(capture == false) return;
+
+		uint8_t piece[CFG_DataSize];
+		while(length > 0)
+		{
+			uint8_t count = (length > CFG_DataSize - 1) ? (CFG_DataSize - 1) : length;
+			piece[0] = capture_seq[source]++;
+			memcpy(&piece[1], data, count);
+			Record(TRACE_UART_RX, source, piece, count + 1, time);
+
+			data += count;
+			length -= count;
+		}
+
+		return;
+	}
+
+	inline void SetEnabled(bool state)
+	{
+		enabled = state;
+		if(state == false) capture = false;
+
+		return;
+	}
+
+	inline void SetCapture(bool state)
+	{
+		capture = state;
+		if(state == true) enabled = true;
+
+		return;
+	}
+
+	/*
+		Кодирует готовые записи в буфер передачи, возвращает длину.
+	*/
+	inline uint16_t _Encode()
+	{
+		uint8_t frame[FrameMax];
+		uint16_t length = 0;
+
+		tx_buffer[length++] = 0x00;
+
+		static uint32_t drops_reported = 0;
+		uint32_t drops_now = drops;
+		if(drops_now != drops_reported)
+		{
+			uint32_t lost = drops_now - drops_reported;
+			uint32_t time = HAL_GetTick();
+			frame[0] = TRACE_DROPPED;
+			frame[1] = 0;
+			memcpy(&frame[2], &time, sizeof(time));
+			memcpy(&frame[HeaderSize], &lost, sizeof(lost));
+			frame[HeaderSize + 4] = CRC8(frame, HeaderSize + 4);
+			length += COBSEncode(frame, HeaderSize + 5, &tx_buffer[length]);
+			drops_reported = drops_now;
+		}
+
+		while(tail != head && CFG_TXBufferSize - length >= EncodedMax)
+		{
+			entry_t &entry = ring[tail & (CFG_RingSize - 1)];
+			if(entry.ready == false) break;
+
+			memcpy(frame, entry.frame, entry.length);
+			frame[entry.length] = CRC8(frame, entry.length);
+			length += COBSEncode(frame, entry.length + 1, &tx_buffer[length]);
+
+			entry.ready = false;
+			__DMB();
+			tail = tail + 1;
+		}
+
+		return (length > 1) ? length : 0;
+	}
+
+	inline void Loop(uint32_t &current_time)
+	{
+		if(AsyncLog::IsBusy() == true) return;
+
+		uint16_t length = _Encode();
+		if(length == 0) return;
+
+		HAL_UART_Transmit_DMA(&hDebugUart, tx_buffer, length);
+		current_time = HAL_GetTick();
+
+		return;
+	}
+}
@@ -0,0 +1,225 @@
+/*
+	Независимый сторожевой таймер (IWDG) с контролем задач основного цикла.
+
+	Задачи - модули цикла LoopMonitor: каждый завершённый Run() отмечает время и длительность
+		модуля (LoopMonitor::heartbeats, durations). IWDG перезапускается в конце итерации, только
+		если каждая контролируемая задача уложилась в свой срок CFG_Deadlines и отметилась не
+		раньше, чем могла пройти одна итерация (CFG_IterationDeadline). Зависание в модуле
+		(ожидание ящика в HAL_CAN_Send, HAL_UART_Transmit) или в прерывании оставляет IWDG без
+		перезапуска, и через ~200 мс он сбрасывает процессор; задача, превышающая срок каждую
+		итерацию, - тоже.
+
+	Причина сброса пишется в секцию .noinit, которая переживает сброс:
+		- из SysTick (Tick()), как только выполняемый модуль превысил срок, - он и будет
+		  причиной, если IWDG сработает;
+		- из Error_Handler() перед программным сбросом.
+	После загрузки причина сопоставляется с флагами RCC->CSR и публикуется событием
+		в BlockError 0x0103 { cause[0] task[1] count[2] uptime[3..6] }:
+		cause - cause_t, task - LoopMonitor::module_t, count - сбросов подряд с включения
+		питания, uptime - время работы до сброса, мс.
+
+	Watchdog::Setup() вызывается до FlightRecorder::Setup(), который очищает флаги сброса.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <stm32f1xx_hal.h>
+
+namespace Watchdog
+{
+	static constexpr uint32_t CFG_Magic = 0x57444F47;			// 'WDOG'
+	static constexpr uint32_t CFG_Prescaler = IWDG_PRESCALER_16;	// LSI ~40 кГц / 16 = 2.5 кГц.
+	static constexpr uint32_t CFG_Reload = 500;					// Срабатывание через ~200 мс (LSI 30..60 кГц: 133..320 мс).
+
+	// Срок задачи, мс, 0 - не контролируется: худший случай Loop() модуля (LoopMonitor, stall max)
+	// с запасом. Модули без ожиданий укладываются в порог зависания LoopMonitor::CFG_StallThreshold.
+	// Отладочный UART 500000 бод - 50 байт/мс, UART контроллеров 19200 бод - ~1.9 байта/мс.
+	static constexpr uint16_t CFG_Deadlines[LoopMonitor::MODULE_COUNT] =
+	{
+		0,		// None
+		5,		// About
+		5,		// Leds
+		10,		// CAN: до 25 объектов в одном Process(), ~0.27 мс на кадр 500 кбит/с с ожиданием ящика - 6.8 мс.
+		30,		// Motors: авторизация 14 байт и запрос 8 байт обоим контроллерам в HAL_UART_Transmit - 23 мс.
+		50,		// Storage: стирание страницы до 40 мс (tERASE), программирование записи при PVD - 2.3 мс.
+		5,		// Profiler: таблица уходит через AsyncLog.
+		5,		// Log
+		5,		// Trace
+		20,		// Memory: AsyncLog::Sync() до 10 мс и отчёт ~300 байт - 6 мс.
+		5,		// Freshness
+		5,		// Supply
+		50,		// Config: стирание страницы до 40 мс.
+		5,		// Recorder
+	};
+	static_assert(LoopMonitor::MODULE_COUNT == 14, "CFG_Deadlines must list every LoopMonitor module!");
+
+	constexpr uint32_t _Sum(const uint16_t *values, uint8_t count)
+	{
+		return (count == 0) ? 0 : values[0] + _Sum(values + 1, count - 1);
+	}
+
+	// Отметка задачи не старше итерации, в которой каждая задача дошла до своего срока.
+	static constexpr uint32_t CFG_IterationDeadline = _Sum(CFG_Deadlines, LoopMonitor::MODULE_COUNT);
+
+	enum cause_t : uint8_t
+	{
+		CAUSE_NONE = 0,			// Включение питания или внешний сброс.
+		CAUSE_TASK = 1,			// IWDG: задача task не отметилась в срок.
+		CAUSE_WATCHDOG = 2,		// IWDG: без зависшей задачи (прерывание, HardFault, между модулями).
+		CAUSE_ERROR = 3,		// Error_Handler().
+		CAUSE_SOFTWARE = 4,		// Программный сброс без записанной причины.
+	};
+
+	struct record_t
+	{
+		uint32_t magic;
+		uint32_t magic_inv;
+		uint32_t uptime;		// Время мс записи причины.
+		cause_t cause;
+		uint8_t task;
+		uint8_t count;			// Сбросов подряд с включения питания.
+	};
+
+	__attribute__((section(".noinit"))) record_t record;
+
+	IWDG_HandleTypeDef hiwdg;
+	record_t report = {};		// Причина последнего сброса, для BlockError.
+	bool started = false;
+
+	/*
+		(Interrupt) Вызывается из SysTick, запоминает модуль, превысивший срок.
+	*/
+	inline void Tick()
+	{
+		LoopMonitor::module_t module = LoopMonitor::module;
+		if(record.cause != CAUSE_NONE || module == LoopMonitor::MODULE_NONE || CFG_Deadlines[module] == 0) return;
+
+		uint32_t now = HAL_GetTick();
+		if(now - LoopMonitor::module_start > CFG_Deadlines[module])
+		{
+			record.uptime = now;
+			record.task = module;
+			record.cause = CAUSE_TASK;
+		}
+
+		return;
+	}
+
+	/*
+		Фатальная ошибка: запись причины и программный сброс вместо вечного цикла.
+	*/
+	inline void OnError()
+	{
+		// Ошибка может случиться и до Setup(), при настройке тактирования.
+		record.magic = CFG_Magic;
+		record.magic_inv = ~CFG_Magic;
+		record.uptime = HAL_GetTick();
+		record.task = LoopMonitor::module;
+		record.cause = CAUSE_ERROR;
+
+		NVIC_SystemReset();
+	}
+
+	/*
+		Разбор причины прошлого сброса, до FlightRecorder::Setup().
+	*/
+	inline void Setup()
+	{
+		uint32_t csr = RCC->CSR;
+
+		if(record.magic != CFG_Magic || record.magic_inv != ~CFG_Magic || (csr & RCC_CSR_PORRSTF) != 0)
+		{
+			memset(&record, 0x00, sizeof(record));
+			record.magic = CFG_Magic;
+			record.magic_inv = ~CFG_Magic;
+		}
+
+		cause_t cause = CAUSE_NONE;
+		if((csr & RCC_CSR_IWDGRSTF) != 0)
+		{
+			cause = (record.cause == CAUSE_TASK) ? CAUSE_TASK : CAUSE_WATCHDOG;
+		}
+		else if((csr & RCC_CSR_SFTRSTF) != 0)
+		{
+			cause = (record.cause == CAUSE_ERROR) ? CAUSE_ERROR : CAUSE_SOFTWARE;
+		}
+
+		if(cause != CAUSE_NONE)
+		{
+			record.count = (record.count < UINT8_MAX) ? record.count + 1 : UINT8_MAX;
+			report = record;
+			report.cause = cause;
+			if(cause == CAUSE_WATCHDOG || cause == CAUSE_SOFTWARE)
+			{
+				report.task = LoopMonitor::MODULE_NONE;
+				report.uptime = 0;
+			}
+		}
+		record.cause = CAUSE_NONE;
+
+		return;
+	}
+
+	/*
+		Публикация причины сброса, после CANLib::Setup().
+	*/
+	inline void Publish()
+	{
+		if(report.cause == CAUSE_NONE) return;
+
+		uint8_t data[7] = { report.cause, report.task, report.count,
+			(uint8_t)report.uptime, (uint8_t)(report.uptime >> 8), (uint8_t)(report.uptime >> 16), (uint8_t)(report.uptime >> 24) };
+		for(uint8_t i = 0; i < sizeof(data); ++i)
+		{
+			CANLib::obj_block_error.SetValue(i, data[i], CAN_TIMER_TYPE_NONE, (i == sizeof(data) - 1) ? CAN_EVENT_TYPE_NORMAL : CAN_EVENT_TYPE_NONE);
+		}
+
+		return;
+	}
+
+	/*
+		Запуск IWDG, перед основным циклом.
+	*/
+	inline void Start()
+	{
+		// Отладчик останавливает ядро, IWDG при этом тоже стоит.
+		__HAL_DBGMCU_FREEZE_IWDG();
+
+		hiwdg.Instance = IWDG;
+		hiwdg.Init.Prescaler = CFG_Prescaler;
+		hiwdg.Init.Reload = CFG_Reload;
+		if(HAL_IWDG_Init(&hiwdg) != HAL_OK) return;
+
+		uint32_t now = HAL_GetTick();
+		for(uint8_t i = 0; i < LoopMonitor::MODULE_COUNT; ++i)
+		{
+			LoopMonitor::heartbeats[i] = now;
+		}
+		started = true;
+
+		return;
+	}
+
+	/*
+		Конец итерации: перезапуск IWDG, если все задачи отметились в срок.
+	*/
+	inline void Loop(uint32_t &current_time)
+	{
+		if(started == false) return;
+
+		uint32_t now = HAL_GetTick();
+		for(uint8_t i = 0; i < LoopMonitor::MODULE_COUNT; ++i)
+		{
+			if(CFG_Deadlines[i] == 0) continue;
+			if(LoopMonitor::durations[i] > CFG_Deadlines[i] || now - LoopMonitor::heartbeats[i] > CFG_IterationDeadline) return;
+		}
+		HAL_IWDG_Refresh(&hiwdg);
+
+		// Задача, отмеченная в Tick(), всё же завершилась - причиной следующего сброса она не будет.
+		if(record.cause == CAUSE_TASK) record.cause = CAUSE_NONE;
+
+		return;
+	}
+}
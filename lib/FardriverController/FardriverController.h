@@ -19,6 +19,30 @@ using event_error_callback_t = void (*)(const uint8_t motor_idx, const motor_err
 using error_callback_t = void (*)(const uint8_t motor_idx, const uint8_t code);
 using tx_callback_t = void (*)(const uint8_t motor_idx, const uint8_t *raw, const uint8_t raw_len);
 
+/*
+	Накопительные счётчики качества связи с контроллером.
+*/
+struct motor_link_stats_t
+{
+	enum counter_t : uint8_t
+	{
+		FRAMES = 0,			// Принято валидных пакетов.
+		CRC = 1,			// Ошибок CRC.
+		FORMAT = 2,			// Ошибок формата пакета.
+		TIMEOUT = 3,		// Пакетов, оборванных по таймауту между байтами.
+		LOST = 4,			// Потерь связи.
+		UART = 5,			// Ошибок UART (HAL_UART_ErrorCallback).
+		AUTH = 6,			// Запросов авторизации.
+		DROPPED = 7,		// Отброшенных байт.
+		COUNT
+	};
+
+	static const uint8_t addr_count = 0x40;	// Количество адресов пакетов, для которых ведётся счёт.
+
+	uint32_t counters[COUNT];
+	uint16_t frames_by_addr[addr_count];	// Валидных пакетов по адресу, с переполнением.
+};
+
 /*************************************************************************************
  *
  * FardriverControllerInterface: It is used for pointer operations with controllers.
@@ -33,6 +57,10 @@ public:
 	virtual void SetTXCallback(tx_callback_t callback) = 0;
 	virtual void RXByte(uint8_t data, uint32_t time) = 0;
 	virtual bool IsActive() = 0;
+	virtual uint32_t GetPacketTime() = 0;
+	virtual void SetTiming(uint16_t request_time, uint16_t unactive_timeout) = 0;
+	virtual void RXError() = 0;
+	virtual const motor_link_stats_t &GetStats() = 0;
 	virtual void Processing(uint32_t time) = 0;
 };
 
@@ -46,8 +74,6 @@ class FardriverController : public FardriverControllerInterface
 {
 	static const uint16_t _rx_buffer_timeout = 10; // Время мс до сброса принимаемого пакета.
 	static const uint8_t _rx_buffer_size = 16;	   // Общий размер пакета.
-	static const uint16_t _request_time = 550;	   // Интервал отправки запраса данных в контроллер.
-	static const uint16_t _unactive_timeout = 500; // Время мс бездейтсвия, после которого считается что связи с контроллером нет.
 
 public:
 
@@ -101,25 +127,35 @@ public:
 	*/
 	virtual void RXByte(uint8_t data, uint32_t time) override
 	{
-		if(lock_interrupt == true) return;
+		if(lock_interrupt == true)
+		{
+			_stats.counters[motor_link_stats_t::DROPPED]++;
+			return;
+		}
 		
 		// Если с момента последнего байта прошло более _packet_timeout мс.
 		if (time - _rx_buffer_last_time > _rx_buffer_timeout)
 		{
+			// Был принят неполный пакет.
+			if(_rx_buffer_idx < _rx_buffer_size)
+			{
+				_stats.counters[motor_link_stats_t::TIMEOUT]++;
+				_stats.counters[motor_link_stats_t::DROPPED] += _rx_buffer_size - _rx_buffer_idx;
+			}
 			_ClearBuff();
 		}
 
-		// Если есть место для нового байта.
-		if (_rx_buffer_idx > 0)
-		{
-			_rx_buffer_last_time = time;
-			_rx_buffer[--_rx_buffer_idx] = data;
-		}
+		// После проверки пакета индекс сразу возвращается в начало, поэтому место для байта есть всегда.
+		_rx_buffer_last_time = time;
+		_rx_buffer[--_rx_buffer_idx] = data;
 
 		// Если приняли весь пакет
 		if (_rx_buffer_idx == 0)
 		{
 			_ValidateBuffer();
+
+			// Буфер перезаписывается следующим пакетом целиком, очищать его не нужно.
+			_rx_buffer_idx = _rx_buffer_size;
 		}
 	}
 
@@ -131,6 +167,39 @@ public:
 		return _isActive;
 	}
 
+	/*
+		Время мс приёма последнего байта пакета, переданного в колбек события.
+	*/
+	virtual uint32_t GetPacketTime() override
+	{
+		return _work_buffer_time;
+	}
+
+	/*
+		Интервал мс запроса данных у контроллера и время мс бездействия до потери связи.
+	*/
+	virtual void SetTiming(uint16_t request_time, uint16_t unactive_timeout) override
+	{
+		_request_time = request_time;
+		_unactive_timeout = unactive_timeout;
+	}
+
+	/*
+		(Interrupt) Учёт ошибки UART.
+	*/
+	virtual void RXError() override
+	{
+		_stats.counters[motor_link_stats_t::UART]++;
+	}
+
+	/*
+		Счётчики качества связи.
+	*/
+	virtual const motor_link_stats_t &GetStats() override
+	{
+		return _stats;
+	}
+
 	/*
 		Обработка принытых данных.
 		Вызываться должна с интервалом, не более 30 мс!
@@ -185,6 +254,10 @@ public:
 		// Время последнего байта больше _unactive_timeout.
 		if (time - _rx_buffer_last_time > _unactive_timeout)
 		{
+			if(_isActive == true)
+			{
+				_stats.counters[motor_link_stats_t::LOST]++;
+			}
 			_isActive = false;
 			_error = ERROR_LOST;
 			
@@ -258,23 +331,35 @@ private:
 			if(_GetBuffCRC() == obj->_CRC)
 			{
 				memcpy(&_work_buffer, _rx_buffer, _rx_buffer_size);
+				_work_buffer_time = _rx_buffer_last_time;
 				_work_buffer_ready = true;
 				_isActive = true;
+
+				_stats.counters[motor_link_stats_t::FRAMES]++;
+				if(obj->_A1 < motor_link_stats_t::addr_count)
+				{
+					_stats.frames_by_addr[obj->_A1]++;
+				}
 			}
 			else
 			{
 				_error = ERROR_CRC;
+				_stats.counters[motor_link_stats_t::CRC]++;
+				_stats.counters[motor_link_stats_t::DROPPED] += _rx_buffer_size;
 			}
 		}
 		// Если приняли пакет авторизации.
 		else if(memcmp(&motor_packet_init_rx, &_rx_buffer, _rx_buffer_size) == 0)
 		{
 			_need_init_tx = true;
+			_stats.counters[motor_link_stats_t::AUTH]++;
 		}
 		// Если приняли непойми что
 		else
 		{
 			_error = ERROR_FORMAT;
+			_stats.counters[motor_link_stats_t::FORMAT]++;
+			_stats.counters[motor_link_stats_t::DROPPED] += _rx_buffer_size;
 		}
 		
 		return;
@@ -315,19 +400,23 @@ private:
 
 	uint8_t _work_buffer[_rx_buffer_size]; // Рабочий (холодный) буфер.
 	bool _work_buffer_ready = false;	   // Готовность рабочего буфера.
+	uint32_t _work_buffer_time = 0;		   // Время мс приёма пакета в рабочем буфере.
 
 	uint16_t _lastErrorFlags = 0x0000;
 
 	bool _need_init_tx = false;
 
 	uint32_t _request_last_time = 0;
+	uint16_t _request_time = 550;	   // Интервал отправки запраса данных в контроллер.
+	uint16_t _unactive_timeout = 500; // Время мс бездейтсвия, после которого считается что связи с контроллером нет.
 
-	bool _isActive;
+	bool _isActive = false;
 
 	error_t _error = ERROR_NONE;
 	error_t _error_send = ERROR_NONE;
 
 	bool lock_interrupt = false;
+	motor_link_stats_t _stats = {};
 	uint32_t _last_processing_time = 0;
 
 	// enum state_t : uint8_t {STATE_IDLE, STATE_AUTH, STATE_WORK, STATE_LOST} _state = STATE_IDLE;
@@ -0,0 +1,67 @@
+/*
+	Сборка пакетов контроллера Fardriver в том виде, в каком они идут по UART:
+		симулятор (native/sim) и замер парсера (include/ParserBench.h).
+
+	Пакет заполняется как структура motor_packet_*_t (порядок буфера FardriverController),
+		Encode() дописывает 0xAA и контрольную сумму и разворачивает байты в порядок линии:
+		{ 0xAA A1 D0..D11 CRC[1] CRC[0] }.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <MotorErrors.h>
+#include <MotorPackets.h>
+
+namespace FardriverPacket
+{
+	static constexpr uint8_t Size = sizeof(motor_packet_raw_t);
+
+	/*
+		Аддитивная сумма, которую проверяет FardriverController::_GetBuffCRC().
+	*/
+	inline uint16_t Checksum(const uint8_t *buffer)
+	{
+		uint16_t result = 0x0000;
+		for(uint8_t i = 2; i < Size; ++i)
+		{
+			result += buffer[i];
+		}
+
+		return result;
+	}
+
+	/*
+		buffer - пакет в порядке структуры, wire - Size байт в порядке передачи.
+	*/
+	inline void Encode(void *packet, uint8_t *wire)
+	{
+		uint8_t *buffer = (uint8_t *)packet;
+		buffer[Size - 1] = 0xAA;
+
+		uint16_t crc = Checksum(buffer);
+		buffer[0] = crc & 0xFF;
+		buffer[1] = crc >> 8;
+
+		for(uint8_t i = 0; i < Size; ++i)
+		{
+			wire[i] = buffer[Size - 1 - i];
+		}
+
+		return;
+	}
+
+	/*
+		Пакет авторизации в порядке передачи (в MotorPackets.h он хранится развёрнутым).
+	*/
+	inline void InitRX(uint8_t *wire)
+	{
+		for(uint8_t i = 0; i < sizeof(motor_packet_init_rx); ++i)
+		{
+			wire[i] = motor_packet_init_rx[sizeof(motor_packet_init_rx) - 1 - i];
+		}
+
+		return;
+	}
+}
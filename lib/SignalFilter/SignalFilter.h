@@ -0,0 +1,145 @@
+/*
+	Класс целочисленной фильтрации сигналов.
+
+	Цепочка обработки одного отсчёта: медиана (3 или 5 отсчётов) -> IIR -> ограничение скорости.
+		Каждая ступень отключается нулевым параметром, состояние фильтра фиксированного размера,
+		обработка отсчёта - O(1) без деления.
+
+	IIR первого порядка с коэффициентом alpha = 1 / 2^shift:
+		acc += x - acc / 2^shift; y = acc / 2^shift
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+class SignalFilter
+{
+	static const uint8_t _median_max = 5;	// Максимальное окно медианы.
+	static const uint8_t _shift_max = 8;	// Максимальный сдвиг IIR, входные значения в пределах ±2^22.
+
+public:
+
+	SignalFilter(uint8_t median = 0, uint8_t shift = 0, uint16_t rate = 0)
+	{
+		Configure(median, shift, rate);
+	}
+
+	/*
+		Настраивает фильтр и сбрасывает его состояние.
+			median - окно медианы: 0 (выкл), 3 или 5;
+			shift - сдвиг IIR: 0 (выкл) .. 8;
+			rate - максимальное изменение выхода за отсчёт: 0 (выкл).
+	*/
+	void Configure(uint8_t median, uint8_t shift, uint16_t rate)
+	{
+		_median = (median >= 5) ? 5 : ((median >= 3) ? 3 : 0);
+		_shift = (shift > _shift_max) ? _shift_max : shift;
+		_rate = rate;
+
+		Reset();
+	}
+
+	/*
+		Сбрасывает состояние, следующий отсчёт проходит без сглаживания.
+	*/
+	void Reset()
+	{
+		_init = false;
+		_window_idx = 0;
+	}
+
+	/*
+		Обрабатывает отсчёт и возвращает отфильтрованное значение.
+	*/
+	int32_t Process(int32_t value)
+	{
+		if(_init == false)
+		{
+			for(uint8_t i = 0; i < _median_max; ++i)
+			{
+				_window[i] = value;
+			}
+			_acc = value * (1L << _shift);
+			_out = value;
+			_init = true;
+
+			return _out;
+		}
+
+		// Медиана.
+		if(_median != 0)
+		{
+			_window[_window_idx] = value;
+			if(++_window_idx >= _median) _window_idx = 0;
+
+			value = (_median == 3) ? _Median3(_window[0], _window[1], _window[2]) : _Median5();
+		}
+
+		// IIR.
+		if(_shift != 0)
+		{
+			// Округление в обратной связи убирает статическую ошибку в 1 МЗР.
+			int32_t half = (1L << (_shift - 1));
+			_acc += value - ((_acc + half) >> _shift);
+			value = (_acc + half) >> _shift;
+		}
+
+		// Ограничение скорости изменения.
+		if(_rate != 0)
+		{
+			int32_t delta = value - _out;
+			if(delta > _rate) value = _out + _rate;
+			else if(delta < -_rate) value = _out - _rate;
+		}
+
+		_out = value;
+
+		return _out;
+	}
+
+	/*
+		Последнее отфильтрованное значение.
+	*/
+	int32_t Get() const
+	{
+		return _out;
+	}
+
+private:
+
+	static inline int32_t _Median3(int32_t a, int32_t b, int32_t c)
+	{
+		int32_t hi = (a > b) ? a : b;
+		int32_t lo = (a > b) ? b : a;
+
+		return (c > hi) ? hi : ((c < lo) ? lo : c);
+	}
+
+	/*
+		Медиана 5 отсчётов сетью из 7 сравнений.
+	*/
+	inline int32_t _Median5() const
+	{
+		int32_t a = _window[0], b = _window[1], c = _window[2], d = _window[3], e = _window[4], t;
+
+		if(a > b) { t = a; a = b; b = t; }
+		if(c > d) { t = c; c = d; d = t; }
+		if(a > c) { t = a; a = c; c = t; t = b; b = d; d = t; }
+		// a - минимум из четырёх, исключаем его.
+		if(e > b) { t = e; e = b; b = t; }
+		if(e > c) { t = e; e = c; c = t; t = b; b = d; d = t; }
+		// e - второй по величине минимум, медиана - меньшее из b и c.
+		return (b < c) ? b : c;
+	}
+
+	int32_t _window[_median_max];	// Окно медианы.
+	uint8_t _window_idx = 0;		// Индекс записи в окно.
+	int32_t _acc = 0;				// Аккумулятор IIR, Q(_shift).
+	int32_t _out = 0;				// Последнее выходное значение.
+	bool _init = false;				// Был принят первый отсчёт.
+
+	uint8_t _median = 0;
+	uint8_t _shift = 0;
+	uint16_t _rate = 0;
+};
@@ -0,0 +1,179 @@
+/*
+	Единица трансляции хоста: те же заголовки модулей и в том же порядке, что в src/main.cpp,
+		плюс то, что в прошивке определено в main.cpp (дескрипторы, HAL_CAN_Send, OnMotorTX).
+*/
+
+#include "MotorStack.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stm32f1xx_hal.h>
+#include <ConstantLibrary.h>
+#include <LoggerLibrary.h>
+#include <CANLibrary.h>
+#include <AsyncLog.h>
+#include <About.h>
+#include <Trace.h>
+#include <Profiler.h>
+#include <FlightRecorder.h>
+#include <Speed.h>
+#include <Odometer.h>
+#include <Energy.h>
+#include <Filters.h>
+#include <FlashErase.h>
+#include <FlashJournal.h>
+#include <Storage.h>
+#include <Config.h>
+#include <CANLogic.h>
+#include <Freshness.h>
+#include <MotorLogic.h>
+#include <MotorEvents.h>
+
+CAN_HandleTypeDef hcan = { CAN1, 0 };
+UART_HandleTypeDef hDebugUart = { USART1, { 500000 }, HAL_UART_STATE_READY, 0 };
+UART_HandleTypeDef huart2 = { USART2, { 19200 }, HAL_UART_STATE_READY, 0 };
+UART_HandleTypeDef huart3 = { USART3, { 19200 }, HAL_UART_STATE_READY, 0 };
+
+void HAL_CAN_Send(can_object_id_t id, uint8_t *data, uint8_t length)
+{
+	CAN_TxHeaderTypeDef TxHeader = {};
+	uint8_t TxData[8] = {0};
+	uint32_t TxMailbox = 0;
+
+	TxHeader.StdId = id;
+	TxHeader.IDE = CAN_ID_STD;
+	TxHeader.RTR = CAN_RTR_DATA;
+	TxHeader.DLC = length;
+	memcpy(TxData, data, length);
+
+	// Как в прошивке: ожидание свободного почтового ящика. На виртуальной шине опрос продвигает её время.
+	while(HAL_CAN_GetTxMailboxesFreeLevel(&hcan) == 0);
+
+	if(HAL_CAN_AddTxMessage(&hcan, &TxHeader, TxData, &TxMailbox) == HAL_OK)
+	{
+		uint32_t time = HAL_GetTick();
+		About::OnTransmit(time);
+		Freshness::OnTransmit(id, time);
+	}
+
+	return;
+}
+
+void OnMotorTX(const uint8_t motor_idx, const uint8_t *raw, const uint8_t raw_len)
+{
+	UART_HandleTypeDef *motor_huart = (motor_idx == 1) ? &huart2 : (motor_idx == 2) ? &huart3 : nullptr;
+	if(motor_huart == nullptr) return;
+
+	HAL_UART_Transmit(motor_huart, (uint8_t *)raw, raw_len, 100);
+
+	return;
+}
+
+// Приём на хосте синхронный: остановка и запуск приёма UART на время стирания не нужны.
+void FlashErase_UARTPause(uint8_t /* port */)
+{
+	return;
+}
+
+void FlashErase_UARTResume(uint8_t /* port */)
+{
+	return;
+}
+
+void FlashErase_UARTData(uint8_t port, uint8_t *data, uint8_t length, uint32_t time)
+{
+	Motors::RXEventProcessing(port + 1, data, length, time);
+
+	return;
+}
+
+void FlashErase_CANFrame(uint16_t id, uint8_t *data, uint8_t length)
+{
+	CANLib::can_manager.IncomingCANFrame(id, data, length);
+
+	return;
+}
+
+namespace MotorStack
+{
+	void Setup()
+	{
+		Speed::Setup();
+		CANLib::Setup();
+		Motors::Setup();
+		CANLib::Announce();
+
+		return;
+	}
+
+	void Receive(uint8_t motor_idx, const uint8_t *data, uint16_t length)
+	{
+		uint8_t buffer[256];
+		uint32_t time = HAL_GetTick();
+
+		// На целевой платформе порция ограничена Config::values.uart_rx_chunk, а длина в RXEventProcessing - uint8_t.
+		while(length > 0)
+		{
+			uint8_t chunk = (length > Config::values.uart_rx_chunk) ? Config::values.uart_rx_chunk : length;
+			memcpy(buffer, data, chunk);
+			Motors::RXEventProcessing(motor_idx, buffer, chunk, time);
+			data += chunk;
+			length -= chunk;
+		}
+
+		return;
+	}
+
+	void ReceiveError(uint8_t motor_idx)
+	{
+		Motors::RXErrorProcessing(motor_idx);
+
+		return;
+	}
+
+	void ReceiveCAN(uint16_t id, uint8_t *data, uint8_t length)
+	{
+		CANLib::can_manager.IncomingCANFrame(id, data, length);
+
+		return;
+	}
+
+	void Loop()
+	{
+		uint32_t current_time = HAL_GetTick();
+		Motors::Loop(current_time);
+		CANLib::Loop(current_time);
+		Config::Loop(current_time);
+		Freshness::Loop(current_time);
+
+		return;
+	}
+
+	uint8_t MotorIndex(const void *huart)
+	{
+		if(huart == &huart2) return 1;
+		if(huart == &huart3) return 2;
+
+		return 0;
+	}
+
+	const motor_link_stats_t &Stats(uint8_t motor_idx)
+	{
+		return (motor_idx == 2) ? Motors::motor2.GetStats() : Motors::motor1.GetStats();
+	}
+
+	void PrintFreshness(FILE *file)
+	{
+		for(uint8_t i = 0; i < Freshness::OBJ_COUNT; ++i)
+		{
+			Freshness::report_t report = Freshness::Report((Freshness::object_t)i);
+			if(report.samples == 0) continue;
+
+			fprintf(file, "object=%s id=0x%04X samples=%u p50_ms=%u p99_ms=%u max_ms=%u\n", Freshness::object_names[i],
+				Freshness::CFG_FirstId + i, report.samples, report.p50, report.p99, report.max);
+		}
+
+		return;
+	}
+}
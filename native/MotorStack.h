@@ -0,0 +1,39 @@
+/*
+	Стек двигателей прошивки, собранный на хосте: FardriverController, декодирование
+		пакетов (MotorEvents.h) и CANObjects (CANLogic.h) поверх HalShim.
+
+	Передача контроллерам и кадры CAN перехватываются через HalShim::on_uart_tx / on_can_tx.
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <FardriverController.h>
+
+namespace MotorStack
+{
+	void Setup();
+
+	// Приём порции байт от контроллера motor_idx (1 или 2), как прерывание UART Idle.
+	void Receive(uint8_t motor_idx, const uint8_t *data, uint16_t length);
+
+	// Ошибка UART контроллера motor_idx, как HAL_UART_ErrorCallback.
+	void ReceiveError(uint8_t motor_idx);
+
+	// Кадр CAN, как HAL_CAN_RxFifo0MsgPendingCallback.
+	void ReceiveCAN(uint16_t id, uint8_t *data, uint8_t length);
+
+	// Одна итерация основного цикла: Motors::Loop, CANLib::Loop, Config::Loop и Freshness::Loop.
+	void Loop();
+
+	// Номер контроллера по дескриптору UART, 0 - не контроллер.
+	uint8_t MotorIndex(const void *huart);
+
+	// Счётчики связи контроллера motor_idx (1 или 2).
+	const motor_link_stats_t &Stats(uint8_t motor_idx);
+
+	// Возраст данных контроллеров в момент передачи в CAN по объектам (include/Freshness.h), строками key=value.
+	void PrintFreshness(FILE *file);
+}
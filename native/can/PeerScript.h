@@ -0,0 +1,128 @@
+/*
+	Сценарий узла-собеседника на виртуальной шине CAN.
+
+	Текстовый формат, один кадр на строку, '#' - комментарий:
+		<время, мс> <id> <данные в hex>                      - однократный кадр
+		every <период, мс> <id> <данные в hex> [<фаза, мс>]  - периодический кадр
+	id - десятичный или 0x..., данные - до 8 байт, "-" - кадр без данных.
+
+	Пример: запрос к BlockCfg (байт функции, BLOCK_CFG_WHEEL_DIAMETER, 600 мм) и соседний блок
+		с кадром раз в 10 мс:
+		1000 0x0102 01015802
+		every 10 0x0080 0011223344556677
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "VirtualCAN.h"
+
+class PeerScript
+{
+	public:
+		/*
+			Загрузка сценария, false - ошибка, текст ошибки в error.
+		*/
+		bool Load(const char *path, std::string &error)
+		{
+			FILE *file = fopen(path, "r");
+			if(file == nullptr)
+			{
+				error = std::string(path) + ": cannot open";
+				return false;
+			}
+
+			char line[256];
+			uint32_t number = 0;
+			bool result = true;
+			while(fgets(line, sizeof(line), file) != nullptr)
+			{
+				number++;
+				char *comment = strchr(line, '#');
+				if(comment != nullptr) *comment = '\0';
+
+				char first[32], id[32], data[64];
+				unsigned long phase = 0;
+				int fields = sscanf(line, "%31s %31s %63s %lu", first, id, data, &phase);
+				if(fields <= 0) continue;
+
+				item_t item = {};
+				if(strcmp(first, "every") == 0)
+				{
+					fields = sscanf(line, "%*s %31s %31s %63s %lu", first, id, data, &phase);
+					item.period = strtoul(first, nullptr, 10);
+					item.time = phase;
+					result = (fields >= 3 && item.period > 0);
+				}
+				else
+				{
+					item.time = strtoul(first, nullptr, 10);
+					result = (fields == 3);
+				}
+				item.frame.id = strtoul(id, nullptr, 0);
+				result = result && item.frame.id <= 0x7FF && _Hex(data, item.frame);
+
+				if(result == false)
+				{
+					error = std::string(path) + ":" + std::to_string(number) + ": bad line";
+					break;
+				}
+				_items.push_back(item);
+			}
+			fclose(file);
+
+			return result;
+		}
+
+		/*
+			Кадры, время которых наступило к now, мс.
+		*/
+		void Collect(uint32_t now, std::vector<VirtualCAN::frame_t> &out)
+		{
+			for(item_t &item : _items)
+			{
+				while(item.done == false && item.time <= now)
+				{
+					out.push_back(item.frame);
+					if(item.period == 0) item.done = true;
+					else item.time += item.period;
+				}
+			}
+
+			return;
+		}
+
+	private:
+		struct item_t
+		{
+			uint32_t time;
+			uint32_t period;
+			VirtualCAN::frame_t frame;
+			bool done;
+		};
+
+		static bool _Hex(const char *text, VirtualCAN::frame_t &frame)
+		{
+			if(strcmp(text, "-") == 0) return true;
+
+			size_t length = strlen(text);
+			if(length == 0 || (length % 2) != 0 || length > 16) return false;
+
+			for(size_t i = 0; i < length; i += 2)
+			{
+				char byte[3] = { text[i], text[i + 1], '\0' };
+				char *end;
+				frame.data[frame.dlc++] = (uint8_t)strtoul(byte, &end, 16);
+				if(*end != '\0') return false;
+			}
+
+			return true;
+		}
+
+		std::vector<item_t> _items;
+};
@@ -0,0 +1,425 @@
+/*
+	Виртуальная шина CAN для интеграционных прогонов на хосте.
+
+	Время - наносекунды. Длительность кадра считается по его битам: стандартный кадр данных
+		с CRC-15 и реальным числом вставленных битов (bit stuffing), плюс разделители, ACK,
+		EOF и межкадровый интервал (3 бита).
+	Арбитраж: когда шина свободна, все узлы с ожидающими кадрами начинают передачу, выигрывает
+		меньший ID. Каждый узел выставляет один кадр из своих почтовых ящиков: по приоритету ID
+		или, как bxCAN с TXFP=1, в порядке постановки.
+	Без автоматического повтора (bxCAN NART=1, так настроена прошивка) кадр, проигравший
+		арбитраж или испорченный ошибкой, теряется, а почтовый ящик освобождается.
+	Ошибки: с вероятностью error_rate передача кадра обрывается на случайном бите флагом
+		ошибки (17 бит с разделителем и интервалом). Счётчик TEC: +8 за ошибку, -1 за успех,
+		с 256 узел отключается от шины (bus-off) и, если разрешено, возвращается через
+		128 x 11 битовых интервалов, как bxCAN с ABOM=1.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+class VirtualCAN
+{
+	public:
+		struct frame_t
+		{
+			uint16_t id;
+			uint8_t dlc;
+			uint8_t data[8];
+		};
+
+		using rx_t = std::function<void(const frame_t &frame)>;
+
+		struct node_config_t
+		{
+			std::string name;
+			uint8_t mailboxes = 3;
+			bool auto_retransmit = true;		// false - bxCAN NART=1.
+			bool fifo_priority = false;			// true - bxCAN TXFP=1.
+			bool auto_bus_off = true;			// bxCAN ABOM=1.
+		};
+
+		struct node_stats_t
+		{
+			uint32_t sent = 0;					// Успешно переданных кадров.
+			uint32_t received = 0;
+			uint32_t rejected = 0;				// Submit при занятых почтовых ящиках.
+			uint32_t lost_arbitration = 0;		// Проигранных арбитражей.
+			uint32_t dropped = 0;				// Кадров, потерянных без повтора.
+			uint32_t errors = 0;				// Оборванных ошибкой передач.
+			uint32_t bus_off = 0;
+			uint16_t tec_max = 0;
+		};
+
+		struct id_stats_t
+		{
+			uint32_t frames = 0;
+			uint64_t latency_sum = 0;			// От постановки в почтовый ящик до конца кадра, нс.
+			uint64_t latency_max = 0;
+		};
+
+		VirtualCAN(uint32_t bitrate, double error_rate = 0.0, uint32_t seed = 1) : _bit_ns(1000000000ULL / bitrate), _error_rate(error_rate), _rng(seed)
+		{
+		}
+
+		uint8_t AddNode(const node_config_t &config, rx_t rx)
+		{
+			node_t node = {};
+			node.config = config;
+			node.rx = rx;
+			_nodes.push_back(node);
+
+			return _nodes.size() - 1;
+		}
+
+		/*
+			Кладёт кадр в свободный почтовый ящик узла в момент Now(), false - свободных нет.
+		*/
+		bool Submit(uint8_t node, const frame_t &frame)
+		{
+			node_t &obj = _nodes[node];
+			if(obj.pending.size() >= obj.config.mailboxes)
+			{
+				obj.stats.rejected++;
+				return false;
+			}
+			obj.pending.push_back({ frame, _now, _sequence++ });
+
+			return true;
+		}
+
+		uint8_t FreeMailboxes(uint8_t node) const
+		{
+			const node_t &obj = _nodes[node];
+
+			return obj.config.mailboxes - obj.pending.size();
+		}
+
+		/*
+			Продвигает шину до момента time.
+		*/
+		void RunUntil(uint64_t time)
+		{
+			while(_Step(time) == true);
+			if(time > _now) _now = time;
+
+			return;
+		}
+
+		/*
+			Продвигает шину до ближайшего события (конец кадра или выход из bus-off) не позже limit.
+			false - событий до limit нет.
+		*/
+		bool RunNextEvent(uint64_t limit)
+		{
+			uint64_t next = _NextEvent();
+			if(next > limit)
+			{
+				_now = limit;
+				return false;
+			}
+			RunUntil(next);
+
+			return true;
+		}
+
+		uint64_t Now() const
+		{
+			return _now;
+		}
+
+		uint64_t BusyTime() const
+		{
+			return _busy_ns;
+		}
+
+		uint64_t BitTime() const
+		{
+			return _bit_ns;
+		}
+
+		const node_stats_t &NodeStats(uint8_t node) const
+		{
+			return _nodes[node].stats;
+		}
+
+		const std::string &NodeName(uint8_t node) const
+		{
+			return _nodes[node].config.name;
+		}
+
+		uint8_t NodeCount() const
+		{
+			return _nodes.size();
+		}
+
+		const std::map<uint16_t, id_stats_t> &IdStats(uint8_t node) const
+		{
+			return _nodes[node].ids;
+		}
+
+		/*
+			Колбек каждого кадра на шине: узел-отправитель, кадр, время конца, true - передан.
+		*/
+		std::function<void(uint8_t node, const frame_t &frame, uint64_t time, bool ok)> on_frame;
+
+		/*
+			Битов в кадре данных со стандартным ID, вместе с межкадровым интервалом.
+		*/
+		static uint16_t FrameBits(const frame_t &frame)
+		{
+			// SOF, ID, RTR, IDE, r0, DLC, данные - биты, к которым добавляется CRC и stuffing.
+			uint8_t bits[19 + 64 + 15];
+			uint8_t count = 0;
+			auto put = [&](uint32_t value, uint8_t width)
+			{
+				for(int8_t i = width - 1; i >= 0; --i) bits[count++] = (value >> i) & 1;
+			};
+			put(0, 1);
+			put(frame.id, 11);
+			put(0, 3);
+			put(frame.dlc, 4);
+			for(uint8_t i = 0; i < frame.dlc; ++i) put(frame.data[i], 8);
+
+			uint16_t crc = 0;
+			for(uint8_t i = 0; i < count; ++i)
+			{
+				bool next = bits[i] ^ ((crc >> 14) & 1);
+				crc = (crc << 1) & 0x7FFF;
+				if(next) crc ^= 0x4599;
+			}
+			put(crc, 15);
+
+			// После пяти одинаковых битов вставляется противоположный, он начинает новую серию.
+			uint8_t stuffed = 0;
+			uint8_t run = 0;
+			uint8_t last = 2;
+			for(uint8_t i = 0; i < count; ++i)
+			{
+				run = (bits[i] == last) ? run + 1 : 1;
+				last = bits[i];
+				if(run == 5)
+				{
+					stuffed++;
+					last ^= 1;
+					run = 1;
+				}
+			}
+
+			// Разделитель CRC, ACK с разделителем, EOF, межкадровый интервал.
+			return count + stuffed + 1 + 2 + 7 + 3;
+		}
+
+	private:
+		static constexpr uint16_t ErrorFrameBits = 6 + 8 + 3;
+		static constexpr uint16_t BusOffRecoveryBits = 128 * 11;
+
+		struct mailbox_t
+		{
+			frame_t frame;
+			uint64_t submitted;
+			uint64_t sequence;
+		};
+
+		struct node_t
+		{
+			node_config_t config;
+			rx_t rx;
+			std::vector<mailbox_t> pending;
+			node_stats_t stats;
+			std::map<uint16_t, id_stats_t> ids;
+			uint16_t tec = 0;
+			bool bus_off = false;
+			uint64_t bus_off_until = 0;
+		};
+
+		int _Head(const node_t &node) const
+		{
+			int head = -1;
+			for(size_t i = 0; i < node.pending.size(); ++i)
+			{
+				const mailbox_t &box = node.pending[i];
+				if(head < 0) { head = i; continue; }
+
+				const mailbox_t &best = node.pending[head];
+				bool better = node.config.fifo_priority ? (box.sequence < best.sequence) :
+					(box.frame.id < best.frame.id || (box.frame.id == best.frame.id && box.sequence < best.sequence));
+				if(better) head = i;
+			}
+
+			return head;
+		}
+
+		uint64_t _NextEvent() const
+		{
+			uint64_t next = UINT64_MAX;
+			if(_busy == true) return _busy_end;
+
+			for(const node_t &node : _nodes)
+			{
+				if(node.bus_off == true && node.config.auto_bus_off == true && node.bus_off_until < next) next = node.bus_off_until;
+				if(node.bus_off == false && node.pending.empty() == false) next = _now;
+			}
+
+			return next;
+		}
+
+		/*
+			Одно событие шины не позже limit, false - до limit событий больше нет.
+		*/
+		bool _Step(uint64_t limit)
+		{
+			if(_busy == true)
+			{
+				if(_busy_end > limit) return false;
+
+				_now = _busy_end;
+				_busy = false;
+				_Complete();
+
+				return true;
+			}
+
+			for(node_t &node : _nodes)
+			{
+				if(node.bus_off == true && node.config.auto_bus_off == true && node.bus_off_until <= limit && node.bus_off_until <= _now)
+				{
+					node.bus_off = false;
+					node.tec = 0;
+				}
+			}
+
+			// Арбитраж между выставленными кадрами.
+			int winner = -1;
+			int winner_box = -1;
+			for(size_t n = 0; n < _nodes.size(); ++n)
+			{
+				node_t &node = _nodes[n];
+				if(node.bus_off == true) continue;
+
+				int box = _Head(node);
+				if(box < 0) continue;
+				if(winner < 0 || node.pending[box].frame.id < _nodes[winner].pending[winner_box].frame.id)
+				{
+					winner = n;
+					winner_box = box;
+				}
+			}
+			if(winner < 0)
+			{
+				// Ждём выхода узла из bus-off, если он раньше limit.
+				uint64_t next = _NextEvent();
+				if(next <= limit && next > _now)
+				{
+					_now = next;
+					return true;
+				}
+				return false;
+			}
+			if(_now > limit) return false;
+
+			for(size_t n = 0; n < _nodes.size(); ++n)
+			{
+				node_t &node = _nodes[n];
+				if((int)n == winner || node.bus_off == true) continue;
+
+				int box = _Head(node);
+				if(box < 0) continue;
+				node.stats.lost_arbitration++;
+				if(node.config.auto_retransmit == false)
+				{
+					node.stats.dropped++;
+					node.pending.erase(node.pending.begin() + box);
+				}
+			}
+
+			const frame_t &frame = _nodes[winner].pending[winner_box].frame;
+			uint16_t bits = FrameBits(frame);
+			_current_error = (_error_rate > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(_rng) < _error_rate);
+			if(_current_error == true)
+			{
+				bits = 1 + _rng() % (bits - 3) + ErrorFrameBits;
+			}
+
+			_current_node = winner;
+			_current_sequence = _nodes[winner].pending[winner_box].sequence;
+			_busy = true;
+			_busy_end = _now + bits * _bit_ns;
+			_busy_ns += bits * _bit_ns;
+
+			return true;
+		}
+
+		void _Complete()
+		{
+			node_t &node = _nodes[_current_node];
+			size_t box = 0;
+			while(box < node.pending.size() && node.pending[box].sequence != _current_sequence) box++;
+			if(box == node.pending.size()) return;
+
+			mailbox_t mailbox = node.pending[box];
+			if(_current_error == true)
+			{
+				node.stats.errors++;
+				node.tec += 8;
+				if(node.tec > node.stats.tec_max) node.stats.tec_max = node.tec;
+				if(node.tec >= 256)
+				{
+					node.bus_off = true;
+					node.bus_off_until = _now + BusOffRecoveryBits * _bit_ns;
+					node.stats.bus_off++;
+				}
+				if(node.config.auto_retransmit == false)
+				{
+					node.stats.dropped++;
+					node.pending.erase(node.pending.begin() + box);
+				}
+				if(on_frame) on_frame(_current_node, mailbox.frame, _now, false);
+
+				return;
+			}
+
+			node.pending.erase(node.pending.begin() + box);
+			node.stats.sent++;
+			if(node.tec > 0) node.tec--;
+
+			id_stats_t &ids = node.ids[mailbox.frame.id];
+			uint64_t latency = _now - mailbox.submitted;
+			ids.frames++;
+			ids.latency_sum += latency;
+			if(latency > ids.latency_max) ids.latency_max = latency;
+
+			if(on_frame) on_frame(_current_node, mailbox.frame, _now, true);
+
+			for(size_t n = 0; n < _nodes.size(); ++n)
+			{
+				if(n == _current_node || _nodes[n].bus_off == true) continue;
+
+				_nodes[n].stats.received++;
+				if(_nodes[n].rx) _nodes[n].rx(mailbox.frame);
+			}
+
+			return;
+		}
+
+		uint64_t _bit_ns;
+		double _error_rate;
+		std::mt19937 _rng;
+		std::vector<node_t> _nodes;
+
+		uint64_t _now = 0;
+		uint64_t _sequence = 0;
+		uint64_t _busy_ns = 0;
+		bool _busy = false;
+		uint64_t _busy_end = 0;
+		size_t _current_node = 0;
+		uint64_t _current_sequence = 0;
+		bool _current_error = false;
+};
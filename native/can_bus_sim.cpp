@@ -0,0 +1,245 @@
+/*
+	can_bus_sim: стек прошивки на виртуальной шине CAN (can/VirtualCAN.h) с контроллерами
+		Fardriver (sim/FardriverSim.h) и узлами-собеседниками по сценариям (can/PeerScript.h).
+
+	can_bus_sim [опции]
+		--bitrate B          скорость шины, бит/с: 500000 или 1000000 (500000)
+		--duration S         длительность, с (10)
+		--peer FILE          узел-собеседник по сценарию, можно несколько раз
+		--error P            вероятность ошибки при передаче кадра
+		--mailboxes N        почтовых ящиков блока (3, как у bxCAN)
+		--retransmit         автоматический повтор у блока (в прошивке выключен, NART=1)
+		--motors N           количество контроллеров Fardriver, 0..2 (2)
+		--profile FILE       сценарий контроллеров (sim/Profile.h)
+		--seed N             зерно генераторов ошибок
+		--log                все кадры шины в stdout: time_us,node,id,data,status
+
+	Блок настроен как прошивка: TXFP=1 (ящики по порядку постановки), без повтора, ABOM=1.
+		HAL_CAN_Send ждёт свободный ящик так же, как в прошивке, ожидание продвигает шину;
+		больше CFG_StuckTimeout без свободного ящика - блок считается зависшим.
+
+	Итог пишется в stderr строками key=value: загрузка шины, счётчики узлов, время ожидания
+		в HAL_CAN_Send, задержка от постановки в ящик до конца кадра по ID блока и возраст данных
+		контроллеров в момент постановки в ящик (include/Freshness.h); полный возраст на шине -
+		их сумма.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <HalShim.h>
+#include <MotorStack.h>
+#include <can/PeerScript.h>
+#include <can/VirtualCAN.h>
+#include <sim/FardriverSim.h>
+
+static constexpr uint64_t CFG_StuckTimeout = 1000000000ULL;		// нс.
+
+static VirtualCAN *bus = nullptr;
+static uint8_t ecu_node = 0;
+static FardriverSim *sims[2] = {};
+static bool print_log = false;
+
+// Ожидание свободного почтового ящика в HAL_CAN_Send.
+static uint64_t wait_start = 0;
+static bool waiting = false;
+static uint64_t wait_total = 0;
+static uint64_t wait_max = 0;
+static uint32_t wait_count = 0;
+
+static void SyncTick()
+{
+	HalShim::SetTick(bus->Now() / 1000000);
+}
+
+static uint32_t OnCANFree()
+{
+	uint8_t free = bus->FreeMailboxes(ecu_node);
+	if(free > 0)
+	{
+		if(waiting == true)
+		{
+			uint64_t wait = bus->Now() - wait_start;
+			wait_total += wait;
+			if(wait > wait_max) wait_max = wait;
+			waiting = false;
+		}
+		return free;
+	}
+
+	// Блок крутится в цикле ожидания, шина тем временем работает.
+	if(waiting == false)
+	{
+		waiting = true;
+		wait_start = bus->Now();
+		wait_count++;
+	}
+	if(bus->RunNextEvent(wait_start + CFG_StuckTimeout) == false)
+	{
+		fprintf(stderr, "stuck=1 time_ms=%llu reason=no free mailbox for %llu ms\n",
+			(unsigned long long)(bus->Now() / 1000000), (unsigned long long)(CFG_StuckTimeout / 1000000));
+		exit(1);
+	}
+	SyncTick();
+
+	return bus->FreeMailboxes(ecu_node);
+}
+
+static void OnCANTX(uint16_t id, const uint8_t *data, uint8_t length)
+{
+	VirtualCAN::frame_t frame = { id, length, {} };
+	memcpy(frame.data, data, length);
+	bus->Submit(ecu_node, frame);
+}
+
+static void OnUARTTX(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t length)
+{
+	uint8_t motor_idx = MotorStack::MotorIndex(huart);
+	if(motor_idx != 0 && sims[motor_idx - 1] != nullptr)
+	{
+		sims[motor_idx - 1]->HostTX(data, length, bus->Now() / 1000);
+	}
+}
+
+static void OnFrame(uint8_t node, const VirtualCAN::frame_t &frame, uint64_t time, bool ok)
+{
+	if(print_log == false) return;
+
+	printf("%llu,%s,0x%04X,", (unsigned long long)(time / 1000), bus->NodeName(node).c_str(), frame.id);
+	for(uint8_t i = 0; i < frame.dlc; ++i) printf("%02X", frame.data[i]);
+	printf(",%s\n", ok ? "ok" : "error");
+}
+
+static void Usage()
+{
+	fprintf(stderr, "usage: can_bus_sim [--bitrate B] [--duration S] [--peer FILE]... [--error P] [--mailboxes N]\n"
+		"                   [--retransmit] [--motors N] [--profile FILE] [--seed N] [--log]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t bitrate = 500000;
+	double duration = 10.0;
+	double error_rate = 0.0;
+	uint32_t seed = 1;
+	uint8_t motors = 2;
+	VirtualCAN::node_config_t ecu_config = { "ecu", 3, false, true, true };
+	std::vector<std::unique_ptr<PeerScript>> peers;
+	Profile profile;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if(arg == "--log") { print_log = true; continue; }
+		if(arg == "--retransmit") { ecu_config.auto_retransmit = true; continue; }
+
+		const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+		if(value == nullptr) Usage();
+		++i;
+
+		std::string error;
+		if(arg == "--bitrate") bitrate = atoi(value);
+		else if(arg == "--duration") duration = atof(value);
+		else if(arg == "--error") error_rate = atof(value);
+		else if(arg == "--mailboxes") ecu_config.mailboxes = atoi(value);
+		else if(arg == "--motors") motors = atoi(value);
+		else if(arg == "--seed") seed = atoi(value);
+		else if(arg == "--profile" && profile.Load(value, error) == false) { fprintf(stderr, "profile: %s\n", error.c_str()); return 1; }
+		else if(arg == "--peer")
+		{
+			peers.emplace_back(new PeerScript());
+			if(peers.back()->Load(value, error) == false) { fprintf(stderr, "peer: %s\n", error.c_str()); return 1; }
+		}
+		else if(arg != "--profile") Usage();
+	}
+	if(bitrate == 0 || ecu_config.mailboxes == 0 || motors > 2) Usage();
+
+	VirtualCAN can(bitrate, error_rate, seed);
+	bus = &can;
+	bus->on_frame = OnFrame;
+	ecu_node = bus->AddNode(ecu_config, [](const VirtualCAN::frame_t &frame)
+	{
+		VirtualCAN::frame_t copy = frame;
+		SyncTick();
+		MotorStack::ReceiveCAN(copy.id, copy.data, copy.dlc);
+	});
+
+	std::vector<uint8_t> peer_nodes;
+	for(size_t i = 0; i < peers.size(); ++i)
+	{
+		peer_nodes.push_back(bus->AddNode({ "peer" + std::to_string(i + 1), 3, true, false, true }, nullptr));
+	}
+
+	FardriverSim::config_t config;
+	config.seed = seed;
+	FardriverSim::config_t config2 = config;
+	config2.seed = seed + 1;
+	FardriverSim sim1(config, profile);
+	FardriverSim sim2(config2, profile);
+	sims[0] = (motors >= 1) ? &sim1 : nullptr;
+	sims[1] = (motors >= 2) ? &sim2 : nullptr;
+
+	HalShim::on_can_tx = OnCANTX;
+	HalShim::on_can_free = OnCANFree;
+	HalShim::on_uart_tx = OnUARTTX;
+	HalShim::SetTick(0);
+	MotorStack::Setup();
+
+	uint64_t end = (uint64_t)(duration * 1000000000.0);
+	std::vector<FardriverSim::chunk_t> chunks;
+	std::vector<VirtualCAN::frame_t> frames;
+
+	for(uint64_t now = 0; now < end; now += 1000000)
+	{
+		// Ожидание в HAL_CAN_Send могло увести шину вперёд основного цикла.
+		if(bus->Now() < now) bus->RunUntil(now);
+		SyncTick();
+		uint32_t tick = HAL_GetTick();
+
+		for(size_t i = 0; i < peers.size(); ++i)
+		{
+			frames.clear();
+			peers[i]->Collect(tick, frames);
+			for(const VirtualCAN::frame_t &frame : frames) bus->Submit(peer_nodes[i], frame);
+		}
+
+		for(uint8_t m = 0; m < 2; ++m)
+		{
+			if(sims[m] == nullptr) continue;
+
+			chunks.clear();
+			sims[m]->Step(bus->Now() / 1000, chunks);
+			for(const FardriverSim::chunk_t &chunk : chunks)
+			{
+				MotorStack::Receive(m + 1, chunk.bytes.data(), chunk.bytes.size());
+			}
+		}
+
+		MotorStack::Loop();
+	}
+	bus->RunUntil(end);
+
+	fprintf(stderr, "bitrate=%u duration_s=%.3f utilisation=%.2f%%\n", bitrate, duration, 100.0 * bus->BusyTime() / end);
+	for(uint8_t n = 0; n < bus->NodeCount(); ++n)
+	{
+		const VirtualCAN::node_stats_t &stats = bus->NodeStats(n);
+		fprintf(stderr, "node=%s sent=%u received=%u rejected=%u lost_arbitration=%u dropped=%u errors=%u bus_off=%u tec_max=%u\n",
+			bus->NodeName(n).c_str(), stats.sent, stats.received, stats.rejected, stats.lost_arbitration, stats.dropped,
+			stats.errors, stats.bus_off, stats.tec_max);
+	}
+	fprintf(stderr, "ecu_send_waits=%u ecu_send_wait_total_us=%llu ecu_send_wait_max_us=%llu\n", wait_count,
+		(unsigned long long)(wait_total / 1000), (unsigned long long)(wait_max / 1000));
+	for(const auto &item : bus->IdStats(ecu_node))
+	{
+		const VirtualCAN::id_stats_t &ids = item.second;
+		fprintf(stderr, "id=0x%04X frames=%u latency_mean_us=%llu latency_max_us=%llu\n", item.first, ids.frames,
+			(unsigned long long)(ids.latency_sum / ids.frames / 1000), (unsigned long long)(ids.latency_max / 1000));
+	}
+	MotorStack::PrintFreshness(stderr);
+
+	return 0;
+}
@@ -0,0 +1,132 @@
+/*
+	Сценарий прогона прошивки в эмуляторе (native/emu_bridge.cpp).
+
+	Текстовый формат, одна настройка на строку, '#' - комментарий:
+		duration <с>                       длительность прогона (10)
+		motors <N>                         контроллеров Fardriver, 0..2 (2)
+		profile <файл>                     сигналы контроллеров (sim/Profile.h)
+		peer <файл>                        узел-собеседник на шине (can/PeerScript.h), можно несколько
+		drop|flip|gap|baud_drift <value>   искажения линии UART (sim/FardriverSim.h)
+		burst <N>, packet_gap <мс>         пачка пакетов контроллера
+		expect <метрика> <оп> <значение>   проверка итога, оп: < <= > >= ==
+	Пути файлов - относительно файла сценария.
+
+	Метрики (см. emu_bridge.cpp):
+		can.<id>.frames, can.<id>.rate     кадров блока с ID за прогон и в секунду
+		can.<id>.gap_max                   наибольший интервал между кадрами ID, мс (время хоста)
+		link.<N>.<counter>                 последний счётчик связи из 0x0113: frames, crc, format,
+		                                   timeout, lost, uart, auth, dropped
+		link.<N>.ratio                     доля принятых прошивкой пакетов от отправленных к моменту
+		                                   публикации счётчика (полный обход 0x0113 - около 25 с)
+		fresh.<id>.p50|p99|max             возраст данных объекта из 0x0116, мс (время прошивки)
+		boot.first_can_ms                  от запуска эмуляции до первого кадра блока, мс (время хоста)
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+class Scenario
+{
+	public:
+		struct expect_t
+		{
+			std::string metric;
+			std::string op;
+			double value;
+		};
+
+		double duration = 10.0;
+		unsigned motors = 2;
+		std::string profile;
+		std::vector<std::string> peers;
+		double drop = 0.0;
+		double flip = 0.0;
+		double gap = 0.0;
+		double baud_drift = 0.0;
+		unsigned burst = 38;
+		unsigned packet_gap = 15;
+		std::vector<expect_t> expects;
+
+		/*
+			Загрузка сценария, false - ошибка, текст ошибки в error.
+		*/
+		bool Load(const char *path, std::string &error)
+		{
+			FILE *file = fopen(path, "r");
+			if(file == nullptr)
+			{
+				error = std::string(path) + ": cannot open";
+				return false;
+			}
+
+			std::string dir = path;
+			size_t slash = dir.rfind('/');
+			dir = (slash == std::string::npos) ? "" : dir.substr(0, slash + 1);
+
+			char line[256];
+			uint32_t number = 0;
+			bool result = true;
+			while(fgets(line, sizeof(line), file) != nullptr)
+			{
+				number++;
+				char *comment = strchr(line, '#');
+				if(comment != nullptr) *comment = '\0';
+
+				char key[32], arg1[128], arg2[16];
+				double value = 0.0;
+				int fields = sscanf(line, "%31s %127s %15s %lf", key, arg1, arg2, &value);
+				if(fields <= 0) continue;
+
+				std::string name = key;
+				if(name == "expect")
+				{
+					std::string op = arg2;
+					result = (fields == 4 && (op == "<" || op == "<=" || op == ">" || op == ">=" || op == "=="));
+					expects.push_back({ arg1, op, value });
+				}
+				else if(fields != 2) result = false;
+				else if(name == "profile") profile = _Path(dir, arg1);
+				else if(name == "peer") peers.push_back(_Path(dir, arg1));
+				else if(name == "duration") duration = atof(arg1);
+				else if(name == "motors") motors = atoi(arg1);
+				else if(name == "drop") drop = atof(arg1);
+				else if(name == "flip") flip = atof(arg1);
+				else if(name == "gap") gap = atof(arg1);
+				else if(name == "baud_drift") baud_drift = atof(arg1);
+				else if(name == "burst") burst = atoi(arg1);
+				else if(name == "packet_gap") packet_gap = atoi(arg1);
+				else result = false;
+
+				if(result == false || motors > 2 || duration <= 0.0)
+				{
+					error = std::string(path) + ":" + std::to_string(number) + ": bad line";
+					result = false;
+					break;
+				}
+			}
+			fclose(file);
+
+			return result;
+		}
+
+		static bool Check(double actual, const expect_t &expect)
+		{
+			if(expect.op == "<") return actual < expect.value;
+			if(expect.op == "<=") return actual <= expect.value;
+			if(expect.op == ">") return actual > expect.value;
+			if(expect.op == ">=") return actual >= expect.value;
+
+			return actual == expect.value;
+		}
+
+	private:
+		static std::string _Path(const std::string &dir, const char *path)
+		{
+			return (path[0] == '/') ? std::string(path) : dir + path;
+		}
+};
@@ -0,0 +1,359 @@
+/*
+	emu_bridge: окружение прошивки, запущенной в эмуляторе STM32F103 (Renode, tools/emulator/).
+
+	USART2/USART3 эмулятора выведены в TCP-терминалы, к ним подключаются симуляторы
+		контроллеров Fardriver (sim/FardriverSim.h); CAN эмулятора - в интерфейс SocketCAN
+		(vcan), на нём же работают узлы-собеседники сценария (can/PeerScript.h).
+	Прогон задаётся сценарием (emu/Scenario.h): нагрузка, искажения линии и проверки итога.
+
+	emu_bridge --scenario FILE [опции]
+		--host ADDR          адрес эмулятора (127.0.0.1)
+		--uart2 PORT         TCP-терминал USART2, контроллер №1 (3402)
+		--uart3 PORT         TCP-терминал USART3, контроллер №2 (3403)
+		--can IFACE          интерфейс SocketCAN шины эмулятора (vcan0)
+		--monitor PORT       монитор Renode: эмуляция запускается командой start после
+		                     подключения симуляторов, 0 - эмуляция уже запущена (0)
+		--connect-timeout S  ожидание запуска эмулятора, с (30)
+		--seed N             зерно генераторов искажений
+		--log                кадры блока в stdout: time_us,id,data
+
+	Время симуляторов и сценариев - часы хоста. Renode не пускает виртуальное время вперёд
+		реального, но может отставать от него, поэтому метрики времени прошивки (счётчики
+		0x0113, возраст данных 0x0116) надёжнее интервалов, измеренных на хосте.
+
+	Итог пишется в stderr строками key=value, затем результаты проверок сценария.
+		Код возврата 1, если хотя бы одна проверка не прошла.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <FardriverController.h>
+#include <emu/Scenario.h>
+#include <can/PeerScript.h>
+#include <sim/FardriverSim.h>
+
+static constexpr uint16_t CFG_LinkStatsId = 0x0113;
+static constexpr uint16_t CFG_FreshnessId = 0x0116;
+static constexpr const char *counter_names[motor_link_stats_t::COUNT] =
+{
+	"frames", "crc", "format", "timeout", "lost", "uart", "auth", "dropped"
+};
+
+struct id_stats_t
+{
+	uint32_t frames;
+	uint64_t last_us;
+	uint64_t gap_max_us;
+};
+
+static std::unique_ptr<FardriverSim> sims[2];
+static uint32_t packets_at_frames[2] = {};		// Отправлено пакетов на момент счётчика frames из 0x0113.
+static std::map<uint16_t, id_stats_t> ids;
+static std::map<std::string, double> metrics;
+static uint64_t first_can_us = 0;
+static bool print_log = false;
+
+static std::string IdName(uint16_t id)
+{
+	char text[8];
+	snprintf(text, sizeof(text), "0x%04X", id);
+
+	return text;
+}
+
+static int ConnectTCP(const char *host, uint16_t port, double timeout)
+{
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if(inet_pton(AF_INET, host, &addr.sin_addr) != 1) return -1;
+
+	// Терминалы появляются, когда эмулятор загрузит скрипт.
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+	while(std::chrono::steady_clock::now() < deadline)
+	{
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+		if(fd >= 0 && connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0) return fd;
+		if(fd >= 0) close(fd);
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+
+	return -1;
+}
+
+static int OpenCAN(const char *iface)
+{
+	int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+	if(fd < 0) return -1;
+
+	ifreq ifr = {};
+	strncpy(ifr.ifr_name, iface, IFNAMSIZ - 1);
+	sockaddr_can addr = {};
+	addr.can_family = AF_CAN;
+	if(ioctl(fd, SIOCGIFINDEX, &ifr) < 0 || (addr.can_ifindex = ifr.ifr_ifindex, bind(fd, (sockaddr *)&addr, sizeof(addr))) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/*
+	Кадр блока с шины: счёт по ID и разбор диагностических объектов.
+		data[0] - байт функции CAN, данные объекта с data[1].
+*/
+static void OnECUFrame(const can_frame &frame, uint64_t now_us)
+{
+	uint16_t id = frame.can_id & CAN_SFF_MASK;
+	if(first_can_us == 0) first_can_us = now_us;
+
+	id_stats_t &stats = ids[id];
+	if(stats.frames > 0 && now_us - stats.last_us > stats.gap_max_us) stats.gap_max_us = now_us - stats.last_us;
+	stats.last_us = now_us;
+	stats.frames++;
+
+	const uint8_t *data = frame.data;
+	if(id == CFG_LinkStatsId && frame.can_dlc >= 7 && (data[1] == 1 || data[1] == 2) && data[2] < motor_link_stats_t::COUNT)
+	{
+		uint32_t value = data[3] | (data[4] << 8) | (data[5] << 16) | ((uint32_t)data[6] << 24);
+		metrics["link." + std::to_string(data[1]) + "." + counter_names[data[2]]] = value;
+
+		// Счётчики публикуются по очереди и отстают от линии, доля считается на момент публикации.
+		if(data[2] == motor_link_stats_t::FRAMES && sims[data[1] - 1] != nullptr)
+		{
+			packets_at_frames[data[1] - 1] = sims[data[1] - 1]->GetStats().packets;
+		}
+	}
+	if(id == CFG_FreshnessId && frame.can_dlc >= 8)
+	{
+		std::string prefix = "fresh." + IdName(0x0100 | data[1]) + ".";
+		metrics[prefix + "p50"] = data[2] | (data[3] << 8);
+		metrics[prefix + "p99"] = data[4] | (data[5] << 8);
+		metrics[prefix + "max"] = data[6] | (data[7] << 8);
+	}
+
+	if(print_log == true)
+	{
+		printf("%llu,0x%04X,", (unsigned long long)now_us, id);
+		for(uint8_t i = 0; i < frame.can_dlc; ++i) printf("%02X", data[i]);
+		printf("\n");
+	}
+
+	return;
+}
+
+static void Usage()
+{
+	fprintf(stderr, "usage: emu_bridge --scenario FILE [--host ADDR] [--uart2 PORT] [--uart3 PORT] [--can IFACE]\n"
+		"                  [--monitor PORT] [--connect-timeout S] [--seed N] [--log]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *scenario_path = nullptr;
+	const char *host = "127.0.0.1";
+	const char *can_iface = "vcan0";
+	uint16_t ports[2] = { 3402, 3403 };
+	uint16_t monitor_port = 0;
+	double connect_timeout = 30.0;
+	uint32_t seed = 1;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if(arg == "--log") { print_log = true; continue; }
+
+		const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+		if(value == nullptr) Usage();
+		++i;
+
+		if(arg == "--scenario") scenario_path = value;
+		else if(arg == "--host") host = value;
+		else if(arg == "--uart2") ports[0] = atoi(value);
+		else if(arg == "--uart3") ports[1] = atoi(value);
+		else if(arg == "--can") can_iface = value;
+		else if(arg == "--monitor") monitor_port = atoi(value);
+		else if(arg == "--connect-timeout") connect_timeout = atof(value);
+		else if(arg == "--seed") seed = atoi(value);
+		else Usage();
+	}
+	if(scenario_path == nullptr) Usage();
+
+	std::string error;
+	Scenario scenario;
+	Profile profile;
+	std::vector<std::unique_ptr<PeerScript>> peers;
+	if(scenario.Load(scenario_path, error) == false || (scenario.profile.empty() == false && profile.Load(scenario.profile.c_str(), error) == false))
+	{
+		fprintf(stderr, "scenario: %s\n", error.c_str());
+		return 1;
+	}
+	for(const std::string &path : scenario.peers)
+	{
+		peers.emplace_back(new PeerScript());
+		if(peers.back()->Load(path.c_str(), error) == false)
+		{
+			fprintf(stderr, "peer: %s\n", error.c_str());
+			return 1;
+		}
+	}
+
+	int can_fd = OpenCAN(can_iface);
+	if(can_fd < 0)
+	{
+		fprintf(stderr, "%s: cannot open SocketCAN interface\n", can_iface);
+		return 1;
+	}
+
+	FardriverSim::config_t config;
+	config.drop = scenario.drop;
+	config.flip = scenario.flip;
+	config.gap = scenario.gap;
+	config.baud_drift = scenario.baud_drift;
+	config.burst = scenario.burst;
+	config.packet_gap_ms = scenario.packet_gap;
+	int uart_fd[2] = { -1, -1 };
+	for(uint8_t m = 0; m < scenario.motors; ++m)
+	{
+		config.seed = seed + m;
+		sims[m].reset(new FardriverSim(config, profile));
+		if((uart_fd[m] = ConnectTCP(host, ports[m], connect_timeout)) < 0)
+		{
+			fprintf(stderr, "%s:%u: cannot connect to the emulator terminal\n", host, ports[m]);
+			return 1;
+		}
+	}
+
+	// Запуск с подключёнными симуляторами: первые пакеты авторизации не теряются, а boot.first_can_ms
+	// отсчитывается от сброса процессора.
+	int monitor_fd = -1;
+	if(monitor_port != 0)
+	{
+		static constexpr char command[] = "start\n";
+		monitor_fd = ConnectTCP(host, monitor_port, connect_timeout);
+		if(monitor_fd < 0 || write(monitor_fd, command, sizeof(command) - 1) < 0)
+		{
+			fprintf(stderr, "%s:%u: cannot start the emulation\n", host, monitor_port);
+			return 1;
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	uint64_t end_us = (uint64_t)(scenario.duration * 1000000.0);
+	uint64_t now_us = 0;
+	std::vector<FardriverSim::chunk_t> chunks;
+	std::vector<VirtualCAN::frame_t> frames;
+
+	while(now_us < end_us)
+	{
+		pollfd fds[3] = { { can_fd, POLLIN, 0 }, { uart_fd[0], POLLIN, 0 }, { uart_fd[1], POLLIN, 0 } };
+		poll(fds, 3, 1);
+		now_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+		if(fds[0].revents & POLLIN)
+		{
+			can_frame frame;
+			if(read(can_fd, &frame, sizeof(frame)) == sizeof(frame) && (frame.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG)) == 0)
+			{
+				OnECUFrame(frame, now_us);
+			}
+		}
+
+		for(uint8_t m = 0; m < 2; ++m)
+		{
+			if(sims[m] == nullptr) continue;
+
+			uint8_t buffer[256];
+			if(fds[m + 1].revents & POLLIN)
+			{
+				ssize_t length = read(uart_fd[m], buffer, sizeof(buffer));
+				if(length <= 0)
+				{
+					fprintf(stderr, "uart%u: emulator closed the terminal\n", m + 2);
+					return 1;
+				}
+				sims[m]->HostTX(buffer, length, now_us);
+			}
+
+			// Порция уходит одной записью: пауза после неё даёт в эмуляторе событие Idle.
+			chunks.clear();
+			sims[m]->Step(now_us, chunks);
+			for(const FardriverSim::chunk_t &chunk : chunks)
+			{
+				if(write(uart_fd[m], chunk.bytes.data(), chunk.bytes.size()) < 0) return 1;
+			}
+		}
+
+		for(std::unique_ptr<PeerScript> &peer : peers)
+		{
+			frames.clear();
+			peer->Collect(now_us / 1000, frames);
+			for(const VirtualCAN::frame_t &item : frames)
+			{
+				can_frame frame = {};
+				frame.can_id = item.id;
+				frame.can_dlc = item.dlc;
+				memcpy(frame.data, item.data, item.dlc);
+				if(write(can_fd, &frame, sizeof(frame)) < 0) return 1;
+			}
+		}
+	}
+
+	for(const auto &item : ids)
+	{
+		std::string prefix = "can." + IdName(item.first) + ".";
+		metrics[prefix + "frames"] = item.second.frames;
+		metrics[prefix + "rate"] = item.second.frames / scenario.duration;
+		metrics[prefix + "gap_max"] = item.second.gap_max_us / 1000.0;
+	}
+	for(uint8_t m = 0; m < 2; ++m)
+	{
+		if(sims[m] == nullptr) continue;
+
+		std::string prefix = "link." + std::to_string(m + 1) + ".";
+		const FardriverSim::stats_t &sim = sims[m]->GetStats();
+		metrics["sim." + std::to_string(m + 1) + ".packets"] = sim.packets;
+		if(packets_at_frames[m] > 0)
+		{
+			metrics[prefix + "ratio"] = metrics[prefix + "frames"] / packets_at_frames[m];
+		}
+	}
+	if(first_can_us != 0) metrics["boot.first_can_ms"] = first_can_us / 1000.0;
+
+	for(const auto &item : metrics)
+	{
+		fprintf(stderr, "%s=%g\n", item.first.c_str(), item.second);
+	}
+
+	uint32_t failed = 0;
+	for(const Scenario::expect_t &expect : scenario.expects)
+	{
+		auto item = metrics.find(expect.metric);
+		bool ok = (item != metrics.end() && Scenario::Check(item->second, expect));
+		if(ok == false) failed++;
+
+		fprintf(stderr, "expect %s %s %g actual=%s %s\n", expect.metric.c_str(), expect.op.c_str(), expect.value,
+			(item != metrics.end()) ? std::to_string(item->second).c_str() : "none", ok ? "ok" : "FAIL");
+	}
+	fprintf(stderr, "scenario=%s expects=%zu failed=%u\n", scenario_path, scenario.expects.size(), failed);
+
+	return (failed > 0) ? 1 : 0;
+}
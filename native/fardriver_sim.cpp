@@ -0,0 +1,184 @@
+/*
+	fardriver_sim: нагрузочный прогон стека двигателей от симулятора контроллеров Fardriver.
+
+	fardriver_sim [опции]
+		--profile FILE       сценарий сигналов (sim/Profile.h), по умолчанию постоянные значения
+		--duration S         длительность, с (по умолчанию длительность сценария, минимум 10)
+		--speed X            темп относительно реального времени: 1, 1000, 0 - без ограничения
+		--motors N           количество контроллеров, 1 или 2 (2)
+		--checksum MODE      additive | crc16
+		--drop P --flip P    вероятность потери байта и инверсии бита
+		--gap P --gap-ms MS  вероятность и длительность паузы после байта
+		--baud-drift F       отклонение скорости передатчика, доля (0.03 = 3%)
+		--burst N            пакетов в ответ на запрос (38)
+		--packet-gap MS      пауза между пакетами пачки (15)
+		--seed N             зерно генератора искажений
+		--can                печатать кадры CAN в stdout: time,can,id,data
+		--capture FILE       записать принятые порции в формате native/replay/Capture.h
+
+	Итог пишется в stderr строками key=value.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <HalShim.h>
+#include <MotorStack.h>
+#include <sim/FardriverSim.h>
+
+static FardriverSim *sims[2] = {};
+static uint64_t now_us = 0;
+static bool print_can = false;
+static uint32_t can_frames = 0;
+static std::map<uint16_t, uint32_t> can_by_id;
+static FILE *capture = nullptr;
+
+static void OnUARTTX(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t length)
+{
+	uint8_t motor_idx = MotorStack::MotorIndex(huart);
+	if(motor_idx != 0 && sims[motor_idx - 1] != nullptr)
+	{
+		sims[motor_idx - 1]->HostTX(data, length, now_us);
+	}
+}
+
+static void OnCANTX(uint16_t id, const uint8_t *data, uint8_t length)
+{
+	can_frames++;
+	can_by_id[id]++;
+	if(print_can == false) return;
+
+	printf("%u,can,0x%04X,", HAL_GetTick(), id);
+	for(uint8_t i = 0; i < length; ++i) printf("%02X", data[i]);
+	printf("\n");
+}
+
+static void Usage()
+{
+	fprintf(stderr, "usage: fardriver_sim [--profile FILE] [--duration S] [--speed X] [--motors N] [--checksum additive|crc16]\n"
+		"                     [--drop P] [--flip P] [--gap P] [--gap-ms MS] [--baud-drift F] [--burst N]\n"
+		"                     [--packet-gap MS] [--seed N] [--can] [--capture FILE]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	FardriverSim::config_t config;
+	Profile profile;
+	double duration = 0.0;
+	double speed = 0.0;
+	uint8_t motors = 2;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+		if(arg == "--can") { print_can = true; continue; }
+		if(value == nullptr) Usage();
+		++i;
+
+		if(arg == "--profile")
+		{
+			std::string error;
+			if(profile.Load(value, error) == false)
+			{
+				fprintf(stderr, "profile: %s\n", error.c_str());
+				return 1;
+			}
+		}
+		else if(arg == "--duration") duration = atof(value);
+		else if(arg == "--speed") speed = atof(value);
+		else if(arg == "--motors") motors = (atoi(value) == 1) ? 1 : 2;
+		else if(arg == "--checksum") config.checksum = (strcmp(value, "crc16") == 0) ? FardriverSim::CHECKSUM_CRC16 : FardriverSim::CHECKSUM_ADDITIVE;
+		else if(arg == "--drop") config.drop = atof(value);
+		else if(arg == "--flip") config.flip = atof(value);
+		else if(arg == "--gap") config.gap = atof(value);
+		else if(arg == "--gap-ms") config.gap_ms = atoi(value);
+		else if(arg == "--baud-drift") config.baud_drift = atof(value);
+		else if(arg == "--burst") config.burst = atoi(value);
+		else if(arg == "--packet-gap") config.packet_gap_ms = atoi(value);
+		else if(arg == "--seed") config.seed = atoi(value);
+		else if(arg == "--capture")
+		{
+			if((capture = fopen(value, "w")) == nullptr)
+			{
+				perror(value);
+				return 1;
+			}
+		}
+		else Usage();
+	}
+	if(duration <= 0.0) duration = (profile.Duration() > 10.0) ? profile.Duration() : 10.0;
+
+	FardriverSim::config_t config2 = config;
+	config2.seed = config.seed + 1;
+	FardriverSim sim1(config, profile);
+	FardriverSim sim2(config2, profile);
+	sims[0] = &sim1;
+	sims[1] = (motors == 2) ? &sim2 : nullptr;
+
+	HalShim::on_uart_tx = OnUARTTX;
+	HalShim::on_can_tx = OnCANTX;
+	HalShim::SetTick(0);
+	MotorStack::Setup();
+
+	auto wall_start = std::chrono::steady_clock::now();
+	uint64_t end_us = (uint64_t)(duration * 1000000.0);
+	std::vector<FardriverSim::chunk_t> chunks;
+
+	for(now_us = 0; now_us < end_us; now_us += 1000)
+	{
+		HalShim::SetTick(now_us / 1000);
+
+		for(uint8_t m = 0; m < 2; ++m)
+		{
+			if(sims[m] == nullptr) continue;
+
+			chunks.clear();
+			sims[m]->Step(now_us, chunks);
+			for(const FardriverSim::chunk_t &chunk : chunks)
+			{
+				MotorStack::Receive(m + 1, chunk.bytes.data(), chunk.bytes.size());
+
+				if(capture == nullptr) continue;
+				fprintf(capture, "%u %u rx ", HAL_GetTick(), m + 1);
+				for(uint8_t byte : chunk.bytes) fprintf(capture, "%02X", byte);
+				fprintf(capture, "\n");
+			}
+		}
+
+		MotorStack::Loop();
+
+		if(speed > 0.0 && (now_us % 10000) == 0)
+		{
+			std::this_thread::sleep_until(wall_start + std::chrono::microseconds((uint64_t)(now_us / speed)));
+		}
+	}
+
+	if(capture != nullptr) fclose(capture);
+
+	double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+	fprintf(stderr, "duration_s=%.3f wall_s=%.3f speedup=%.1f\n", duration, wall, duration / wall);
+	for(uint8_t m = 0; m < 2; ++m)
+	{
+		if(sims[m] == nullptr) continue;
+
+		const FardriverSim::stats_t &sim = sims[m]->GetStats();
+		const motor_link_stats_t &link = MotorStack::Stats(m + 1);
+		fprintf(stderr, "motor=%u sent_packets=%u init_packets=%u requests=%u bytes=%u dropped=%u flipped=%u gaps=%u framing=%u\n",
+			m + 1, sim.packets, sim.init_packets, sim.requests, sim.bytes, sim.dropped, sim.flipped, sim.gaps, sim.framing);
+		fprintf(stderr, "motor=%u frames=%u crc=%u format=%u timeout=%u lost=%u auth=%u dropped_bytes=%u\n",
+			m + 1, link.counters[motor_link_stats_t::FRAMES], link.counters[motor_link_stats_t::CRC],
+			link.counters[motor_link_stats_t::FORMAT], link.counters[motor_link_stats_t::TIMEOUT],
+			link.counters[motor_link_stats_t::LOST], link.counters[motor_link_stats_t::AUTH],
+			link.counters[motor_link_stats_t::DROPPED]);
+	}
+	fprintf(stderr, "can_frames=%u can_ids=%zu\n", can_frames, can_by_id.size());
+	MotorStack::PrintFreshness(stderr);
+
+	return 0;
+}
@@ -0,0 +1,87 @@
+/*
+	Цель фаззинга разбора пакетов контроллера: FardriverController (RXByte, Processing) и колбеки
+		декодирования (include/MotorEvents.h) на произвольном потоке байт и времени.
+
+	Вход:
+		{ time[0..3] } - время первой порции, мс, little-endian (в том числе около переполнения);
+		далее записи { ctrl[0] length[1] data[length] }:
+			ctrl bit7 - контроллер (0 - первый, 1 - второй), bits0..6 - пауза перед порцией, мс;
+			length длиннее остатка входа обрезается.
+		После каждой порции вызывается Processing() обоих контроллеров, как из основного цикла.
+
+	Контроллеры создаются заново на каждый вход, поэтому вход воспроизводится сам по себе.
+		CANObjects и счётчики модулей общие для всех входов.
+
+	Сборка с clang - libFuzzer, иначе отдельный драйвер FuzzMain.cpp (прогон файлов, AFL, мутации).
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <HalShim.h>
+#include <MotorStack.h>
+#include <FardriverController.h>
+
+// Определены в MotorStack.cpp (include/MotorEvents.h).
+void OnMotorEvent(const uint8_t motor_idx, motor_packet_raw_t *raw_packet);
+void OnMotorError(const uint8_t motor_idx, const motor_error_t code);
+void OnMotorHWError(const uint8_t motor_idx, const uint8_t code);
+
+static void OnTX(const uint8_t motor_idx, const uint8_t *raw, const uint8_t raw_len)
+{
+}
+
+template <uint8_t _motor_idx>
+static void Attach(FardriverController<_motor_idx> &controller)
+{
+	controller.SetEventDataCallback(OnMotorEvent);
+	controller.SetEventErrorCallback(OnMotorError);
+	controller.SetErrorCallback(OnMotorHWError);
+	controller.SetTXCallback(OnTX);
+}
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+	HalShim::SetTick(0);
+	MotorStack::Setup();
+
+	return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if(size < 4) return 0;
+
+	FardriverController<1> motor1;
+	FardriverController<2> motor2;
+	Attach(motor1);
+	Attach(motor2);
+	FardriverControllerInterface *motors[2] = { &motor1, &motor2 };
+
+	uint32_t time;
+	memcpy(&time, data, sizeof(time));
+	data += sizeof(time);
+	size -= sizeof(time);
+
+	while(size >= 2)
+	{
+		FardriverControllerInterface *motor = motors[data[0] >> 7];
+		time += data[0] & 0x7F;
+		size_t length = (data[1] < size - 2) ? data[1] : size - 2;
+		data += 2;
+		size -= 2;
+
+		HalShim::SetTick(time);
+		for(size_t i = 0; i < length; ++i)
+		{
+			motor->RXByte(data[i], time);
+		}
+		data += length;
+		size -= length;
+
+		motor1.Processing(time);
+		motor2.Processing(time);
+	}
+
+	return 0;
+}
@@ -0,0 +1,161 @@
+/*
+	Драйвер цели фаззинга без libFuzzer (сборка gcc, AFL).
+
+	fardriver_fuzz PATH...                    прогон файлов и каталогов корпуса
+	fardriver_fuzz --mutate N [--seed S] PATH...
+	                                          N случайных мутаций входов корпуса
+	afl-fuzz -i corpus -o findings -- fardriver_fuzz @@
+
+	Ошибку находит санитайзер и завершает процесс; при мутациях вход, на котором это
+		случилось, сохраняется в crash-input.bin.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv);
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static constexpr size_t CFG_MaxInput = 4096;
+
+static std::vector<uint8_t> current;
+static bool mutating = false;
+
+// Санитайзеры завершают процесс через abort(), чтобы вход можно было сохранить в обработчике SIGABRT.
+extern "C" const char *__asan_default_options() { return "abort_on_error=1"; }
+extern "C" const char *__ubsan_default_options() { return "abort_on_error=1:print_stacktrace=1"; }
+
+static void OnAbort(int signal)
+{
+	if(mutating == true)
+	{
+		FILE *file = fopen("crash-input.bin", "wb");
+		if(file != nullptr)
+		{
+			fwrite(current.data(), 1, current.size(), file);
+			fclose(file);
+			fprintf(stderr, "input saved to crash-input.bin (%zu bytes)\n", current.size());
+		}
+	}
+	_exit(1);
+}
+
+static bool ReadFile(const std::string &path, std::vector<uint8_t> &out)
+{
+	FILE *file = fopen(path.c_str(), "rb");
+	if(file == nullptr) return false;
+
+	out.clear();
+	uint8_t buffer[4096];
+	size_t length;
+	while((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		out.insert(out.end(), buffer, buffer + length);
+	}
+	fclose(file);
+
+	return true;
+}
+
+static void Collect(const std::string &path, std::vector<std::vector<uint8_t>> &corpus)
+{
+	struct stat st;
+	if(stat(path.c_str(), &st) != 0)
+	{
+		fprintf(stderr, "%s: not found\n", path.c_str());
+		exit(2);
+	}
+
+	if(S_ISDIR(st.st_mode))
+	{
+		DIR *dir = opendir(path.c_str());
+		struct dirent *entry;
+		while(dir != nullptr && (entry = readdir(dir)) != nullptr)
+		{
+			if(entry->d_name[0] == '.') continue;
+			Collect(path + "/" + entry->d_name, corpus);
+		}
+		if(dir != nullptr) closedir(dir);
+	}
+	else
+	{
+		corpus.emplace_back();
+		ReadFile(path, corpus.back());
+	}
+}
+
+static void Mutate(std::vector<uint8_t> &data, std::mt19937 &rng)
+{
+	uint8_t count = 1 + rng() % 8;
+	for(uint8_t i = 0; i < count; ++i)
+	{
+		size_t pos = data.empty() ? 0 : rng() % data.size();
+		switch(rng() % 5)
+		{
+			case 0: { if(!data.empty()) data[pos] ^= 1 << (rng() % 8); break; }
+			case 1: { if(!data.empty()) data[pos] = rng(); break; }
+			case 2: { if(data.size() < CFG_MaxInput) data.insert(data.begin() + pos, (uint8_t)rng()); break; }
+			case 3: { if(!data.empty()) data.erase(data.begin() + pos); break; }
+			case 4:
+			{
+				// Повтор куска: пакеты и порции целиком.
+				size_t length = 1 + rng() % 32;
+				if(pos + length > data.size() || data.size() + length > CFG_MaxInput) break;
+				std::vector<uint8_t> piece(data.begin() + pos, data.begin() + pos + length);
+				data.insert(data.begin() + rng() % data.size(), piece.begin(), piece.end());
+				break;
+			}
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	uint64_t mutations = 0;
+	uint32_t seed = 1;
+	std::vector<std::vector<uint8_t>> corpus;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if(arg == "--mutate" && i + 1 < argc) mutations = strtoull(argv[++i], nullptr, 10);
+		else if(arg == "--seed" && i + 1 < argc) seed = strtoul(argv[++i], nullptr, 10);
+		else Collect(arg, corpus);
+	}
+	if(corpus.empty())
+	{
+		fprintf(stderr, "usage: fardriver_fuzz [--mutate N] [--seed S] PATH...\n");
+		return 2;
+	}
+
+	LLVMFuzzerInitialize(&argc, &argv);
+	signal(SIGABRT, OnAbort);
+
+	for(const std::vector<uint8_t> &input : corpus)
+	{
+		current = input;
+		LLVMFuzzerTestOneInput(current.data(), current.size());
+	}
+
+	std::mt19937 rng(seed);
+	mutating = true;
+	for(uint64_t n = 0; n < mutations; ++n)
+	{
+		current = corpus[rng() % corpus.size()];
+		Mutate(current, rng);
+		LLVMFuzzerTestOneInput(current.data(), current.size());
+	}
+
+	fprintf(stderr, "inputs=%zu mutations=%llu ok\n", corpus.size(), (unsigned long long)mutations);
+
+	return 0;
+}
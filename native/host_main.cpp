@@ -0,0 +1,72 @@
+/*
+	motor_host: прогон стека двигателей на хосте.
+
+	Контроллер №1 проходит авторизацию и шлёт пакеты 0x00 (обороты) и 0x01 (ток, напряжение)
+		каждые 50 мс виртуального времени. Кадры CAN и передача контроллеру печатаются в stdout.
+
+	motor_host [seconds]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <HalShim.h>
+#include <MotorStack.h>
+#include <FardriverPacket.h>
+
+static void OnUARTTX(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t length)
+{
+	printf("%u,uart,%u,", HAL_GetTick(), MotorStack::MotorIndex(huart));
+	for(uint16_t i = 0; i < length; ++i) printf("%02X", data[i]);
+	printf("\n");
+}
+
+static void OnCANTX(uint16_t id, const uint8_t *data, uint8_t length)
+{
+	printf("%u,can,0x%04X,", HAL_GetTick(), id);
+	for(uint8_t i = 0; i < length; ++i) printf("%02X", data[i]);
+	printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t duration = (argc > 1) ? atoi(argv[1]) * 1000 : 2000;
+
+	HalShim::on_uart_tx = OnUARTTX;
+	HalShim::on_can_tx = OnCANTX;
+	HalShim::SetTick(1);
+
+	MotorStack::Setup();
+
+	uint8_t wire[FardriverPacket::Size];
+	FardriverPacket::InitRX(wire);
+	MotorStack::Receive(1, wire, sizeof(wire));
+
+	for(uint32_t time = 0; time < duration; ++time)
+	{
+		HalShim::Advance(1);
+
+		if(time % 50 == 0)
+		{
+			motor_packet_0_t packet0 = {};
+			packet0.RPM = (1000 + time / 10) * 4;
+			packet0.Gear = 0x01;
+			packet0.Roll = 0x03;
+			packet0._A1 = 0x00;
+			FardriverPacket::Encode(&packet0, wire);
+			MotorStack::Receive(1, wire, sizeof(wire));
+		}
+		if(time % 50 == 25)
+		{
+			motor_packet_1_t packet1 = {};
+			packet1.Current = 40 * 4;
+			packet1.Voltage = 720;
+			packet1._A1 = 0x01;
+			FardriverPacket::Encode(&packet1, wire);
+			MotorStack::Receive(1, wire, sizeof(wire));
+		}
+
+		MotorStack::Loop();
+	}
+
+	return 0;
+}
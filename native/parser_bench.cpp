@@ -0,0 +1,151 @@
+/*
+	parser_bench: замер разбора пакетов контроллера на хосте (include/ParserBench.h).
+
+	parser_bench [опции]
+		--blocks N           блоков по 16 пакетов на замер (4096)
+		--repeat N           повторов замера, берётся лучший (5)
+		--output FILE        строки JSON в файл, по умолчанию в stdout
+
+	Таблица для человека пишется в stderr: нс/пакет, нс/байт, байт/с и эталон скорости хоста,
+	см. Reference().
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <HalShim.h>
+#include <MotorStack.h>
+#include <ParserBench.h>
+
+// Определён в MotorStack.cpp (include/MotorEvents.h).
+void OnMotorEvent(const uint8_t motor_idx, motor_packet_raw_t *raw_packet);
+
+static uint32_t Nanoseconds()
+{
+	static const auto start = std::chrono::steady_clock::now();
+
+	return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void Usage()
+{
+	fprintf(stderr, "usage: parser_bench [--blocks N] [--repeat N] [--output FILE]\n");
+	exit(2);
+}
+
+/*
+	Эталон скорости хоста без кода прошивки: побайтная свёртка потока той же длины, что у замера
+	на blocks блоков. Меряется перед каждым повтором замера, в строку JSON идёт как "ref" (нс на
+	пакет); tools/budget_check.py делит на него per_packet, и бюджет "ns" не зависит от машины CI.
+*/
+static uint32_t Reference(uint32_t blocks)
+{
+	static uint8_t stream[ParserBench::CFG_BlockPackets * FardriverPacket::Size];
+	uint32_t seed = ParserBench::CFG_Seed;
+	for(uint8_t &byte : stream)
+	{
+		byte = ParserBench::_Next(seed);
+	}
+
+	volatile uint32_t sink = 0;
+	uint32_t hash = 0;
+	uint32_t start = Nanoseconds();
+	for(uint32_t b = 0; b < blocks; ++b)
+	{
+		for(uint8_t byte : stream)
+		{
+			hash = (hash ^ byte) * 0x01000193;
+		}
+	}
+	uint32_t ticks = Nanoseconds() - start;
+	sink = sink ^ hash;
+
+	return ticks;
+}
+
+struct measure_t
+{
+	ParserBench::result_t result;
+	uint32_t ref_ticks;		// Эталон за те же повторы.
+};
+
+// Лучший из repeat повторов и лучший эталон, замеренный перед каждым из них: оба - за одно и то же время.
+template <typename F>
+static measure_t Best(uint32_t repeat, uint32_t blocks, F run)
+{
+	measure_t best = {};
+	for(uint32_t i = 0; i < repeat; ++i)
+	{
+		uint32_t ref_ticks = Reference(blocks);
+		ParserBench::result_t result = run();
+		if(i == 0 || result.ticks < best.result.ticks) best.result = result;
+		if(i == 0 || ref_ticks < best.ref_ticks) best.ref_ticks = ref_ticks;
+	}
+
+	return best;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t blocks = 4096;
+	uint32_t repeat = 5;
+	const char *output = nullptr;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+		if(value == nullptr) Usage();
+		++i;
+
+		if(arg == "--blocks") blocks = atoi(value);
+		else if(arg == "--repeat") repeat = atoi(value);
+		else if(arg == "--output") output = value;
+		else Usage();
+	}
+	if(blocks == 0 || repeat == 0) Usage();
+
+	// Декодер пишет в CANObjects, им нужна инициализация стека.
+	HalShim::SetTick(0);
+	MotorStack::Setup();
+
+	std::vector<measure_t> measures;
+	for(uint16_t corruption : ParserBench::corruptions)
+	{
+		measures.push_back(Best(repeat, blocks, [&]() { return ParserBench::RunRX(Nanoseconds, corruption, blocks); }));
+	}
+	measures.push_back(Best(repeat, blocks, [&]() { return ParserBench::RunCRC(Nanoseconds, blocks); }));
+	measures.push_back(Best(repeat, blocks, [&]() { return ParserBench::RunDecode(Nanoseconds, OnMotorEvent, blocks); }));
+
+	FILE *out = stdout;
+	if(output != nullptr && (out = fopen(output, "w")) == nullptr)
+	{
+		perror(output);
+		return 1;
+	}
+
+	fprintf(stderr, "%-8s %10s %8s %10s %10s %14s %8s\n", "bench", "corruption", "frames", "ns/packet", "ns/byte", "bytes/s", "ref");
+	for(const measure_t &measure : measures)
+	{
+		const ParserBench::result_t &result = measure.result;
+		uint32_t ref = (uint64_t)measure.ref_ticks * 100 / result.packets;
+
+		char line[256];
+		int length = ParserBench::Format(result, "ns", line, sizeof(line));
+		if(length <= 0 || length >= (int)sizeof(line)) continue;
+		line[length - 1] = '\0';
+		fprintf(out, "%s,\"ref\":%u.%02u}\n", line, ref / 100, ref % 100);
+
+		uint32_t bytes = result.packets * FardriverPacket::Size;
+		fprintf(stderr, "%-8s %9.1f%% %8u %10.2f %10.2f %14.0f %8.2f\n", ParserBench::bench_names[result.bench], result.corruption / 10.0,
+			result.frames, (double)result.ticks / result.packets, (double)result.ticks / bytes, bytes * 1e9 / result.ticks,
+			(double)measure.ref_ticks / result.packets);
+	}
+
+	if(out != stdout) fclose(out);
+
+	return 0;
+}
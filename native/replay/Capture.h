@@ -0,0 +1,119 @@
+/*
+	Запись приёма от контроллеров для воспроизведения (tools/uart_capture.py).
+
+	Текстовый формат, одна порция на строку, '#' - комментарий:
+		<время, мс> <uart> rx <байты в hex>
+		<время, мс> <uart> error <код HAL>
+	uart - номер контроллера (1 - USART2, 2 - USART3). Строки упорядочиваются по времени
+		с сохранением порядка строк одного времени.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+class Capture
+{
+	public:
+		enum kind_t : uint8_t
+		{
+			KIND_RX = 0,
+			KIND_ERROR = 1,
+		};
+
+		struct chunk_t
+		{
+			uint32_t time;
+			uint8_t uart;
+			kind_t kind;
+			uint32_t code;
+			std::vector<uint8_t> bytes;
+		};
+
+		/*
+			Загрузка записи, false - ошибка, текст ошибки в error.
+		*/
+		bool Load(const char *path, std::string &error)
+		{
+			FILE *file = fopen(path, "r");
+			if(file == nullptr)
+			{
+				error = std::string(path) + ": cannot open";
+				return false;
+			}
+
+			char line[4096];
+			uint32_t number = 0;
+			bool result = true;
+			while(result == true && fgets(line, sizeof(line), file) != nullptr)
+			{
+				number++;
+				char *comment = strchr(line, '#');
+				if(comment != nullptr) *comment = '\0';
+
+				char kind[16];
+				char data[sizeof(line)];
+				unsigned long time;
+				unsigned uart;
+				int fields = sscanf(line, "%lu %u %15s %s", &time, &uart, kind, data);
+				if(fields <= 0) continue;
+
+				chunk_t chunk = { (uint32_t)time, (uint8_t)uart, KIND_RX, 0, {} };
+				if(fields == 4 && (uart == 1 || uart == 2) && strcmp(kind, "rx") == 0)
+				{
+					result = _Hex(data, chunk.bytes);
+				}
+				else if(fields == 4 && (uart == 1 || uart == 2) && strcmp(kind, "error") == 0)
+				{
+					chunk.kind = KIND_ERROR;
+					chunk.code = strtoul(data, nullptr, 10);
+				}
+				else
+				{
+					result = false;
+				}
+
+				if(result == false)
+				{
+					error = std::string(path) + ":" + std::to_string(number) + ": bad line";
+					break;
+				}
+				_chunks.push_back(std::move(chunk));
+			}
+			fclose(file);
+
+			std::stable_sort(_chunks.begin(), _chunks.end(), [](const chunk_t &a, const chunk_t &b) { return a.time < b.time; });
+
+			return result;
+		}
+
+		const std::vector<chunk_t> &Chunks() const
+		{
+			return _chunks;
+		}
+
+	private:
+		static bool _Hex(const char *text, std::vector<uint8_t> &out)
+		{
+			size_t length = strlen(text);
+			if(length == 0 || (length % 2) != 0) return false;
+
+			for(size_t i = 0; i < length; i += 2)
+			{
+				char byte[3] = { text[i], text[i + 1], '\0' };
+				char *end;
+				out.push_back((uint8_t)strtoul(byte, &end, 16));
+				if(*end != '\0') return false;
+			}
+
+			return true;
+		}
+
+		std::vector<chunk_t> _chunks;
+};
@@ -0,0 +1,171 @@
+#include "HalShim.h"
+#include <string.h>
+#if defined(__linux__)
+	#include <sys/mman.h>
+#endif
+
+namespace HalShim
+{
+	uart_tx_t on_uart_tx = nullptr;
+	can_tx_t on_can_tx = nullptr;
+	uint8_t can_free_mailboxes = 3;
+	can_free_t on_can_free = nullptr;
+
+	static uint32_t tick = 0;
+
+	void SetTick(uint32_t time)
+	{
+		tick = time;
+
+		return;
+	}
+
+	void Advance(uint32_t ms)
+	{
+		tick += ms;
+
+		return;
+	}
+}
+
+static DWT_Type dwt_regs;
+static CoreDebug_Type core_debug_regs;
+static RCC_TypeDef rcc_regs = { RCC_CSR_PORRSTF };
+static USART_TypeDef usart_regs[3];
+static CAN_TypeDef can_regs;
+static uint32_t primask = 0;
+
+DWT_Type *DWT = &dwt_regs;
+CoreDebug_Type *CoreDebug = &core_debug_regs;
+RCC_TypeDef *RCC = &rcc_regs;
+USART_TypeDef *USART1 = &usart_regs[0];
+USART_TypeDef *USART2 = &usart_regs[1];
+USART_TypeDef *USART3 = &usart_regs[2];
+CAN_TypeDef *CAN1 = &can_regs;
+
+uint32_t __get_PRIMASK(void) { return primask; }
+void __set_PRIMASK(uint32_t value) { primask = value; }
+void __disable_irq(void) { primask = 1; }
+void __enable_irq(void) { primask = 0; }
+uint32_t __get_MSP(void) { return 0; }
+
+void HAL_NVIC_SetPriority(IRQn_Type /* IRQn */, uint32_t /* PreemptPriority */, uint32_t /* SubPriority */) {}
+void HAL_NVIC_EnableIRQ(IRQn_Type /* IRQn */) {}
+
+uint32_t HAL_GetTick(void)
+{
+	return HalShim::tick;
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+	HalShim::Advance(Delay);
+
+	return;
+}
+
+// Flash: 64 КБ по адресу FLASH_BASE, чтобы журналы Storage.h и Config.h читали её напрямую, как на
+// целевой платформе. Стирание заполняет страницу 0xFF, программирование полуслова - только в стёртое.
+#if defined(__linux__)
+static uint8_t *flash = []() -> uint8_t *
+{
+	void *ptr = mmap((void *)FLASH_BASE, HalShim::CFG_FlashSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+	if(ptr != (void *)FLASH_BASE)
+	{
+		if(ptr != MAP_FAILED) munmap(ptr, HalShim::CFG_FlashSize);
+		return nullptr;
+	}
+	memset(ptr, 0xFF, HalShim::CFG_FlashSize);
+
+	return (uint8_t *)ptr;
+}();
+#else
+static uint8_t *flash = nullptr;
+#endif
+
+namespace HalShim
+{
+	uint32_t flash_erases = 0;
+	uint32_t flash_programs = 0;
+	flash_erase_t on_flash_erase = nullptr;
+
+	bool FlashAvailable()
+	{
+		return flash != nullptr;
+	}
+}
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void) { return HAL_OK; }
+HAL_StatusTypeDef HAL_FLASH_Lock(void) { return HAL_OK; }
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError)
+{
+	*PageError = 0xFFFFFFFF;
+	if(flash == nullptr) return HAL_OK;
+
+	uint32_t offset = pEraseInit->PageAddress - FLASH_BASE;
+	if(offset % FLASH_PAGE_SIZE != 0 || offset + pEraseInit->NbPages * FLASH_PAGE_SIZE > HalShim::CFG_FlashSize)
+	{
+		*PageError = pEraseInit->PageAddress;
+		return HAL_ERROR;
+	}
+	memset(flash + offset, 0xFF, pEraseInit->NbPages * FLASH_PAGE_SIZE);
+	HalShim::flash_erases += pEraseInit->NbPages;
+	if(HalShim::on_flash_erase != nullptr) HalShim::on_flash_erase(pEraseInit->PageAddress);
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+	if(flash == nullptr) return HAL_OK;
+
+	uint32_t offset = Address - FLASH_BASE;
+	if(TypeProgram != FLASH_TYPEPROGRAM_HALFWORD || offset % 2 != 0 || offset + 2 > HalShim::CFG_FlashSize) return HAL_ERROR;
+
+	// Как на STM32F1 (PGERR): непустое полуслово не перезаписывается, кроме записи нуля.
+	uint16_t *cell = (uint16_t *)(flash + offset);
+	if(*cell != 0xFFFF && (uint16_t)Data != 0x0000) return HAL_ERROR;
+	*cell = (uint16_t)Data;
+	HalShim::flash_programs++;
+
+	return HAL_OK;
+}
+
+void HAL_PWR_ConfigPVD(PWR_PVDTypeDef * /* sConfigPVD */) {}
+void HAL_PWR_EnablePVD(void) {}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size, uint32_t /* Timeout */)
+{
+	if(HalShim::on_uart_tx != nullptr) HalShim::on_uart_tx(huart, pData, Size);
+
+	return HAL_OK;
+}
+
+// Передача завершается мгновенно, UART сразу снова свободен.
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+	if(HalShim::on_uart_tx != nullptr) HalShim::on_uart_tx(huart, pData, Size);
+
+	return HAL_OK;
+}
+
+uint32_t HAL_CAN_GetTxMailboxesFreeLevel(CAN_HandleTypeDef * /* hcan */)
+{
+	return (HalShim::on_can_free != nullptr) ? HalShim::on_can_free() : HalShim::can_free_mailboxes;
+}
+
+HAL_StatusTypeDef HAL_CAN_AddTxMessage(CAN_HandleTypeDef *hcan, CAN_TxHeaderTypeDef *pHeader, uint8_t aData[], uint32_t *pTxMailbox)
+{
+	if(HAL_CAN_GetTxMailboxesFreeLevel(hcan) == 0) return HAL_ERROR;
+
+	if(HalShim::on_can_tx != nullptr) HalShim::on_can_tx(pHeader->StdId, aData, pHeader->DLC);
+	*pTxMailbox = 1;
+
+	return HAL_OK;
+}
+
+uint32_t HAL_CAN_GetError(CAN_HandleTypeDef *hcan)
+{
+	return hcan->ErrorCode;
+}
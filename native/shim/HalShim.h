@@ -0,0 +1,34 @@
+/*
+	Управление заменой HAL на хосте: виртуальное время, перехват передачи в UART и CAN, flash.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include "stm32f1xx_hal.h"
+
+namespace HalShim
+{
+	using uart_tx_t = void (*)(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t length);
+	using can_tx_t = void (*)(uint16_t id, const uint8_t *data, uint8_t length);
+	using can_free_t = uint32_t (*)();
+	using flash_erase_t = void (*)(uint32_t address);
+
+	extern uart_tx_t on_uart_tx;		// Передача в UART, блокирующая и по DMA.
+	extern can_tx_t on_can_tx;			// Кадр, положенный в почтовый ящик CAN.
+
+	extern uint8_t can_free_mailboxes;	// Значение HAL_CAN_GetTxMailboxesFreeLevel().
+	extern can_free_t on_can_free;		// Если задан, заменяет can_free_mailboxes (виртуальная шина).
+
+	static constexpr uint32_t CFG_FlashSize = 0x10000;	// STM32F103C8, 64 КБ.
+
+	extern uint32_t flash_erases;		// Стёрто страниц.
+	extern uint32_t flash_programs;		// Записано полуслов.
+	extern flash_erase_t on_flash_erase;	// Во время стирания страницы (приём, пока flash стоит).
+
+	// Flash эмулируется по адресу FLASH_BASE (только Linux), иначе стирание и запись ничего не делают.
+	bool FlashAvailable();
+
+	void SetTick(uint32_t time);
+	void Advance(uint32_t ms);
+}
@@ -0,0 +1,47 @@
+/*
+	Замена PixelLoggerLibrary на хосте: вывод в stderr.
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <stdarg.h>
+
+class HostLogger
+{
+	public:
+		HostLogger &PrintTopic(const char *topic)
+		{
+			fprintf(stderr, "[%s] ", topic);
+			return *this;
+		}
+
+		HostLogger &Printf(const char *format, ...)
+		{
+			va_list args;
+			va_start(args, format);
+			vfprintf(stderr, format, args);
+			va_end(args);
+			return *this;
+		}
+
+		HostLogger &Print(const char *text)
+		{
+			fputs(text, stderr);
+			return *this;
+		}
+
+		HostLogger &PrintNewLine()
+		{
+			fputs("\n", stderr);
+			return *this;
+		}
+};
+
+inline HostLogger Logger;
+
+#if defined(DEBUG)
+	#define DEBUG_LOG_TOPIC(topic, ...) Logger.PrintTopic(topic).Printf(__VA_ARGS__)
+#else
+	#define DEBUG_LOG_TOPIC(topic, ...)
+#endif
@@ -0,0 +1,151 @@
+/*
+	Минимальная замена STM32 HAL для сборки на хосте (native/).
+
+	Содержит только то, что используют модули из include/ и lib/: типы дескрипторов,
+		регистры-заглушки и функции HAL. Реализация - HalShim.cpp, управление - HalShim.h.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Сборка на хосте: модули, работающие с регистрами напрямую, берут вариант для хоста.
+#define HAL_SHIM 1
+
+typedef enum
+{
+	HAL_OK = 0x00,
+	HAL_ERROR = 0x01,
+	HAL_BUSY = 0x02,
+	HAL_TIMEOUT = 0x03
+} HAL_StatusTypeDef;
+
+#define ENABLE 1
+#define DISABLE 0
+#define __IO volatile
+
+/* Ядро */
+typedef enum
+{
+	PVD_IRQn = 1,
+	DMA1_Channel1_IRQn = 11,
+	DMA1_Channel4_IRQn = 14,
+	USB_LP_CAN1_RX0_IRQn = 20,
+	USART1_IRQn = 37,
+	USART2_IRQn = 38,
+	USART3_IRQn = 39
+} IRQn_Type;
+
+typedef struct { volatile uint32_t CTRL; volatile uint32_t CYCCNT; } DWT_Type;
+typedef struct { volatile uint32_t DEMCR; } CoreDebug_Type;
+extern DWT_Type *DWT;
+extern CoreDebug_Type *CoreDebug;
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+void __disable_irq(void);
+void __enable_irq(void);
+uint32_t __get_MSP(void);
+
+// Хост однопоточный: эксклюзивный доступ всегда успешен.
+inline uint32_t __LDREXW(volatile uint32_t *addr) { return *addr; }
+inline uint32_t __STREXW(uint32_t value, volatile uint32_t *addr) { *addr = value; return 0; }
+inline void __CLREX(void) {}
+inline void __DMB(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+
+/* RCC */
+typedef struct { volatile uint32_t CSR; } RCC_TypeDef;
+extern RCC_TypeDef *RCC;
+#define RCC_CSR_RMVF (1UL << 24)
+#define RCC_CSR_PINRSTF (1UL << 26)
+#define RCC_CSR_PORRSTF (1UL << 27)
+#define RCC_CSR_SFTRSTF (1UL << 28)
+#define RCC_CSR_IWDGRSTF (1UL << 29)
+#define RCC_CSR_WWDGRSTF (1UL << 30)
+#define RCC_CSR_LPWRRSTF (1UL << 31)
+#define __HAL_RCC_CLEAR_RESET_FLAGS() (RCC->CSR = 0)
+
+/* Tick */
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+
+/* FLASH */
+#define FLASH_BASE 0x08000000UL
+#define FLASH_PAGE_SIZE 0x400U
+#define FLASH_TYPEERASE_PAGES 0x00U
+#define FLASH_BANK_1 1U
+#define FLASH_TYPEPROGRAM_HALFWORD 0x01U
+
+typedef struct
+{
+	uint32_t TypeErase;
+	uint32_t Banks;
+	uint32_t PageAddress;
+	uint32_t NbPages;
+} FLASH_EraseInitTypeDef;
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef HAL_FLASH_Lock(void);
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError);
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data);
+
+/* PWR */
+typedef struct { uint32_t PVDLevel; uint32_t Mode; } PWR_PVDTypeDef;
+#define PWR_PVDLEVEL_7 0x000000E0U
+#define PWR_PVD_MODE_IT_RISING 0x00010001U
+void HAL_PWR_ConfigPVD(PWR_PVDTypeDef *sConfigPVD);
+void HAL_PWR_EnablePVD(void);
+
+/* UART */
+typedef struct { uint32_t x; } USART_TypeDef;
+extern USART_TypeDef *USART1, *USART2, *USART3;
+
+typedef struct { uint32_t BaudRate; } UART_InitTypeDef;
+
+#define HAL_UART_STATE_READY 0x20U
+#define HAL_UART_STATE_BUSY_TX 0x21U
+
+typedef struct __UART_HandleTypeDef
+{
+	USART_TypeDef *Instance;
+	UART_InitTypeDef Init;
+	volatile uint32_t gState;
+	volatile uint32_t ErrorCode;
+} UART_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+
+/* CAN */
+typedef struct { uint32_t x; } CAN_TypeDef;
+extern CAN_TypeDef *CAN1;
+
+typedef struct
+{
+	CAN_TypeDef *Instance;
+	volatile uint32_t ErrorCode;
+} CAN_HandleTypeDef;
+
+typedef struct
+{
+	uint32_t StdId;
+	uint32_t ExtId;
+	uint32_t IDE;
+	uint32_t RTR;
+	uint32_t DLC;
+	uint32_t TransmitGlobalTime;
+} CAN_TxHeaderTypeDef;
+
+#define CAN_ID_STD 0x00000000U
+#define CAN_RTR_DATA 0x00000000U
+
+uint32_t HAL_CAN_GetTxMailboxesFreeLevel(CAN_HandleTypeDef *hcan);
+HAL_StatusTypeDef HAL_CAN_AddTxMessage(CAN_HandleTypeDef *hcan, CAN_TxHeaderTypeDef *pHeader, uint8_t aData[], uint32_t *pTxMailbox);
+uint32_t HAL_CAN_GetError(CAN_HandleTypeDef *hcan);
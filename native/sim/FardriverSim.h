@@ -0,0 +1,309 @@
+/*
+	Симулятор контроллера Fardriver: сторона контроллера в протоколе UART.
+
+	До авторизации контроллер раз в init_period_ms шлёт motor_packet_init_rx. Получив
+		motor_packet_init_tx, он считается авторизованным и на каждый motor_packet_request_tx
+		отвечает пачкой из burst пакетов с адресами 0x00, 0x01, ... и паузой packet_gap_ms
+		между ними. Без запросов дольше auth_timeout_ms авторизация сбрасывается.
+	Данные пакетов 0x00 (обороты, передача, ошибки), 0x01 (ток, напряжение), 0x04 и 0x0D
+		(температуры) берутся из сценария Profile, остальные адреса - нули.
+
+	Контрольная сумма: аддитивная (её проверяет FardriverController) или CRC-16 нового
+		протокола (FardriverCRC::PutRX_new), которую текущий парсер считает ошибкой CRC.
+
+	Искажения линии, независимо для каждого байта:
+		drop - вероятность потери байта;
+		flip - вероятность инверсии одного случайного бита;
+		gap - вероятность паузы gap_ms после байта;
+		baud_drift - относительное отклонение скорости передатчика: меняет длительность
+			байта, а начиная с 2% даёт ошибки кадра, растущие до 100% при 5%.
+
+	Время - микросекунды. Байты уходят порциями так же, как их отдаёт
+		HAL_UARTEx_ReceiveToIdle_IT: по паузе в линии длиной в один байт или по заполнению
+		буфера приёма.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include <deque>
+#include <random>
+#include <vector>
+#include <FardriverCRC.h>
+#include <FardriverPacket.h>
+#include "Profile.h"
+
+class FardriverSim
+{
+	public:
+		enum checksum_t : uint8_t
+		{
+			CHECKSUM_ADDITIVE = 0,
+			CHECKSUM_CRC16 = 1,
+		};
+
+		struct config_t
+		{
+			checksum_t checksum = CHECKSUM_ADDITIVE;
+			uint32_t baud = 19200;
+			double baud_drift = 0.0;
+			double drop = 0.0;
+			double flip = 0.0;
+			double gap = 0.0;
+			uint32_t gap_ms = 20;
+			uint32_t init_period_ms = 50;
+			uint32_t packet_gap_ms = 15;
+			uint32_t auth_timeout_ms = 2000;
+			uint8_t burst = 38;
+			uint16_t rx_buffer_size = 128;		// UART_BUFFER_SIZE прошивки.
+			uint32_t seed = 1;
+		};
+
+		struct stats_t
+		{
+			uint32_t packets = 0;			// Пакетов данных.
+			uint32_t init_packets = 0;		// Пакетов авторизации.
+			uint32_t requests = 0;			// Принятых запросов.
+			uint32_t bytes = 0;				// Байт в линию.
+			uint32_t dropped = 0;
+			uint32_t flipped = 0;
+			uint32_t gaps = 0;
+			uint32_t framing = 0;			// Искажено из-за расхождения скорости.
+		};
+
+		struct chunk_t
+		{
+			uint64_t time_us;				// Момент прерывания Idle.
+			std::vector<uint8_t> bytes;
+		};
+
+		FardriverSim(const config_t &config, const Profile &profile) : _config(config), _profile(profile), _rng(config.seed)
+		{
+			_byte_us = 10.0 * 1000000.0 / (config.baud * (1.0 + config.baud_drift));
+
+			double drift = fabs(config.baud_drift);
+			_framing = (drift <= 0.02) ? 0.0 : (drift >= 0.05) ? 1.0 : (drift - 0.02) / 0.03;
+		}
+
+		/*
+			Данные от прошивки контроллеру (OnMotorTX).
+		*/
+		void HostTX(const uint8_t *data, uint16_t length, uint64_t now_us)
+		{
+			if(length == sizeof(motor_packet_init_tx) && memcmp(data, motor_packet_init_tx, length) == 0)
+			{
+				_authorized = true;
+				_last_request_us = now_us;
+			}
+			else if(length == sizeof(motor_packet_request_tx) && memcmp(data, motor_packet_request_tx, length) == 0)
+			{
+				_stats.requests++;
+				if(_authorized == true)
+				{
+					_last_request_us = now_us;
+					if(_burst_left == 0)
+					{
+						_burst_left = _config.burst;
+						_burst_addr = 0;
+						_next_packet_us = now_us;
+					}
+				}
+			}
+
+			return;
+		}
+
+		/*
+			Продвигает симуляцию до now_us и забирает готовые порции.
+		*/
+		void Step(uint64_t now_us, std::vector<chunk_t> &out)
+		{
+			if(_authorized == true && now_us - _last_request_us > (uint64_t)_config.auth_timeout_ms * 1000)
+			{
+				_authorized = false;
+				_burst_left = 0;
+			}
+
+			uint8_t wire[FardriverPacket::Size];
+			if(_authorized == false)
+			{
+				if(now_us >= _next_init_us)
+				{
+					_next_init_us = now_us + (uint64_t)_config.init_period_ms * 1000;
+					FardriverPacket::InitRX(wire);
+					_Send(wire, sizeof(wire), now_us);
+					_stats.init_packets++;
+				}
+			}
+			else if(_burst_left > 0 && now_us >= _next_packet_us && now_us >= _line_free_us)
+			{
+				_BuildPacket(_burst_addr, now_us, wire);
+				_Send(wire, sizeof(wire), now_us);
+				_stats.packets++;
+
+				_burst_addr++;
+				_burst_left--;
+				_next_packet_us = _line_free_us + (uint64_t)_config.packet_gap_ms * 1000;
+			}
+
+			// Порция отдаётся после паузы в линии длиной в один байт.
+			while(_chunks.empty() == false && now_us >= _chunks.front().time_us)
+			{
+				out.push_back(std::move(_chunks.front()));
+				_chunks.pop_front();
+			}
+
+			return;
+		}
+
+		const stats_t &GetStats() const
+		{
+			return _stats;
+		}
+
+		bool IsAuthorized() const
+		{
+			return _authorized;
+		}
+
+		double ByteTimeUs() const
+		{
+			return _byte_us;
+		}
+
+	private:
+		void _BuildPacket(uint8_t addr, uint64_t now_us, uint8_t *wire)
+		{
+			double time = now_us / 1000000.0;
+			uint8_t buffer[FardriverPacket::Size] = {};
+
+			switch(addr)
+			{
+				case 0x00:
+				{
+					motor_packet_0_t *packet0 = (motor_packet_0_t *)buffer;
+					double rpm = _profile.Get("rpm", time);
+					packet0->RPM = (uint16_t)lround(fabs(rpm) * 4.0);
+					packet0->Gear = (uint8_t)lround(_profile.Get("gear", time));
+					packet0->Roll = (rpm > 0.5) ? 0x03 : (rpm < -0.5) ? 0x01 : 0x00;
+					packet0->ErrorFlags = (motor_error_t)(uint16_t)lround(_profile.Get("errors", time));
+					break;
+				}
+				case 0x01:
+				{
+					motor_packet_1_t *packet1 = (motor_packet_1_t *)buffer;
+					packet1->Current = (int16_t)lround(_profile.Get("current", time) * 4.0);
+					packet1->Voltage = (uint16_t)lround(_profile.Get("voltage", time) * 10.0);
+					break;
+				}
+				case 0x04:
+				{
+					((motor_packet_raw_t *)buffer)->D2 = (uint8_t)lround(_profile.Get("temp_ctrl", time));
+					break;
+				}
+				case 0x0D:
+				{
+					((motor_packet_raw_t *)buffer)->D0 = (uint8_t)lround(_profile.Get("temp_motor", time));
+					break;
+				}
+			}
+			((motor_packet_raw_t *)buffer)->_A1 = addr;
+
+			FardriverPacket::Encode(buffer, wire);
+			if(_config.checksum == CHECKSUM_CRC16)
+			{
+				_crc.PutRX_new(wire);
+			}
+
+			return;
+		}
+
+		/*
+			Передаёт байты в линию с искажениями, начиная не раньше now_us.
+		*/
+		void _Send(const uint8_t *data, uint16_t length, uint64_t now_us)
+		{
+			double time = (double)((now_us > _line_free_us) ? now_us : _line_free_us);
+
+			for(uint16_t i = 0; i < length; ++i)
+			{
+				if(_Chance(_config.drop) == true)
+				{
+					_stats.dropped++;
+					continue;
+				}
+
+				uint8_t byte = data[i];
+				if(_Chance(_config.flip) == true)
+				{
+					byte ^= 1 << (_rng() % 8);
+					_stats.flipped++;
+				}
+				if(_framing > 0.0 && _Chance(_framing) == true)
+				{
+					byte ^= 0x80;
+					_stats.framing++;
+				}
+
+				time += _byte_us;
+				_Append(byte, time);
+				_stats.bytes++;
+
+				if(_Chance(_config.gap) == true)
+				{
+					time += _config.gap_ms * 1000.0;
+					_stats.gaps++;
+				}
+			}
+			_line_free_us = (uint64_t)time;
+
+			return;
+		}
+
+		/*
+			Добавляет байт, закончившийся в момент end_us, в порцию приёма.
+		*/
+		void _Append(uint8_t byte, double end_us)
+		{
+			bool idle = _chunks.empty() || end_us - _last_byte_us > 2.0 * _byte_us;
+			bool full = !_chunks.empty() && _chunks.back().bytes.size() >= _config.rx_buffer_size;
+			if(idle == true || full == true)
+			{
+				_chunks.push_back({});
+			}
+
+			chunk_t &chunk = _chunks.back();
+			chunk.bytes.push_back(byte);
+			chunk.time_us = (uint64_t)(end_us + ((chunk.bytes.size() >= _config.rx_buffer_size) ? 0.0 : _byte_us));
+			_last_byte_us = end_us;
+
+			return;
+		}
+
+		bool _Chance(double probability)
+		{
+			if(probability <= 0.0) return false;
+
+			return std::uniform_real_distribution<double>(0.0, 1.0)(_rng) < probability;
+		}
+
+		config_t _config;
+		const Profile &_profile;
+		std::mt19937 _rng;
+		FardriverCRC _crc;
+		stats_t _stats;
+
+		double _byte_us;					// Длительность байта с учётом расхождения скорости.
+		double _framing;					// Вероятность ошибки кадра.
+		bool _authorized = false;
+		uint64_t _last_request_us = 0;
+		uint64_t _next_init_us = 0;
+		uint64_t _next_packet_us = 0;
+		uint64_t _line_free_us = 0;
+		double _last_byte_us = 0.0;
+		uint8_t _burst_left = 0;
+		uint8_t _burst_addr = 0;
+		std::deque<chunk_t> _chunks;
+};
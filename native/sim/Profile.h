@@ -0,0 +1,146 @@
+/*
+	Сценарий сигналов контроллера для симулятора: ключевые точки с линейной интерполяцией.
+
+	Текстовый формат, одна ключевая точка на строку, '#' - комментарий:
+		<время, с> <сигнал>=<значение> [<сигнал>=<значение> ...]
+	Сигналы: rpm, current (А), voltage (В), temp_ctrl, temp_motor (°C), gear, errors.
+	Каждый сигнал интерполируется между своими точками независимо, до первой
+		и после последней точки значение постоянное.
+
+	Пример:
+		0   rpm=0 voltage=72 current=0
+		5   rpm=3000 current=120
+		20  rpm=3000 current=40
+		25  rpm=0 current=-30
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+class Profile
+{
+	public:
+		struct point_t
+		{
+			double time;
+			double value;
+		};
+
+		Profile()
+		{
+			_Default("voltage", 72.0);
+			_Default("gear", 1.0);
+			_Default("temp_ctrl", 35.0);
+			_Default("temp_motor", 30.0);
+		}
+
+		/*
+			Добавляет ключевую точку, первая точка сигнала заменяет значение по умолчанию.
+		*/
+		void Set(const std::string &signal, double time, double value)
+		{
+			if(_defaults.erase(signal) != 0)
+			{
+				_signals[signal].clear();
+			}
+			_signals[signal].push_back({ time, value });
+
+			return;
+		}
+
+		/*
+			Загрузка сценария, false - ошибка, текст ошибки в error.
+		*/
+		bool Load(const char *path, std::string &error)
+		{
+			FILE *file = fopen(path, "r");
+			if(file == nullptr)
+			{
+				error = std::string("cannot open ") + path;
+				return false;
+			}
+
+			char line[512];
+			uint32_t line_no = 0;
+			while(fgets(line, sizeof(line), file) != nullptr)
+			{
+				line_no++;
+				char *comment = strchr(line, '#');
+				if(comment != nullptr) *comment = '\0';
+
+				char *token = strtok(line, " \t\r\n");
+				if(token == nullptr) continue;
+
+				double time = atof(token);
+				while((token = strtok(nullptr, " \t\r\n")) != nullptr)
+				{
+					char *eq = strchr(token, '=');
+					if(eq == nullptr)
+					{
+						error = "line " + std::to_string(line_no) + ": expected signal=value";
+						fclose(file);
+						return false;
+					}
+					*eq = '\0';
+					Set(token, time, atof(eq + 1));
+				}
+			}
+			fclose(file);
+
+			return true;
+		}
+
+		double Get(const std::string &signal, double time) const
+		{
+			auto it = _signals.find(signal);
+			if(it == _signals.end() || it->second.empty()) return 0.0;
+
+			const std::vector<point_t> &points = it->second;
+			if(time <= points.front().time) return points.front().value;
+			if(time >= points.back().time) return points.back().value;
+
+			for(size_t i = 1; i < points.size(); ++i)
+			{
+				if(time <= points[i].time)
+				{
+					const point_t &a = points[i - 1];
+					const point_t &b = points[i];
+					if(b.time == a.time) return b.value;
+					return a.value + (b.value - a.value) * (time - a.time) / (b.time - a.time);
+				}
+			}
+
+			return points.back().value;
+		}
+
+		double Duration() const
+		{
+			double result = 0.0;
+			for(const auto &signal : _signals)
+			{
+				if(!signal.second.empty() && signal.second.back().time > result) result = signal.second.back().time;
+			}
+
+			return result;
+		}
+
+	private:
+		void _Default(const std::string &signal, double value)
+		{
+			_signals[signal] = { { 0.0, value } };
+			_defaults.insert(signal);
+
+			return;
+		}
+
+		std::map<std::string, std::vector<point_t>> _signals;
+		std::set<std::string> _defaults;
+};
@@ -0,0 +1,52 @@
+/*
+	Проверки тестов хоста (ctest): CHECK() не прерывает тест, а печатает условие и место
+		и считает провал. Итог Check::Result() - код возврата main().
+
+	Тест включает MotorStack.cpp целиком (см. CMakeLists.txt), поэтому видит состояние
+		модулей прошивки так же, как main.cpp: Speed::, Odometer::, CANLib:: и т.д.
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define CHECK(expr) Check::That((expr), #expr, __FILE__, __LINE__)
+#define CHECK_EQ(actual, expected) Check::Equal((int64_t)(actual), (int64_t)(expected), #actual, __FILE__, __LINE__)
+
+namespace Check
+{
+	inline uint32_t checks = 0;
+	inline uint32_t failures = 0;
+
+	inline bool That(bool ok, const char *expr, const char *file, int line)
+	{
+		checks++;
+		if(ok == false)
+		{
+			failures++;
+			fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expr);
+		}
+
+		return ok;
+	}
+
+	inline bool Equal(int64_t actual, int64_t expected, const char *expr, const char *file, int line)
+	{
+		checks++;
+		if(actual != expected)
+		{
+			failures++;
+			fprintf(stderr, "%s:%d: %s == %lld, expected %lld\n", file, line, expr, (long long)actual, (long long)expected);
+		}
+
+		return actual == expected;
+	}
+
+	inline int Result(const char *name)
+	{
+		fprintf(stderr, "%s: %u checks, %u failed\n", name, checks, failures);
+
+		return (failures == 0) ? 0 : 1;
+	}
+}
@@ -0,0 +1,159 @@
+/*
+	can_test: слой CANObjects (include/CANLogic.h) - периодическая передача значений
+		и обработчик BlockCfg SET, поверх CANManager и HAL_CAN_Send() хоста.
+*/
+
+#include "../MotorStack.cpp"
+#include <HalShim.h>
+#include <vector>
+#include "Check.h"
+
+struct frame_t
+{
+	uint16_t id;
+	uint8_t length;
+	uint8_t data[8];
+};
+
+static std::vector<frame_t> frames;
+
+static void OnCANTX(uint16_t id, const uint8_t *data, uint8_t length)
+{
+	frame_t frame = { id, length, {} };
+	memcpy(frame.data, data, length);
+	frames.push_back(frame);
+
+	return;
+}
+
+// Последний переданный кадр объекта id, nullptr - не передавался.
+static const frame_t *Last(uint16_t id)
+{
+	for(auto it = frames.rbegin(); it != frames.rend(); ++it)
+	{
+		if(it->id == id) return &*it;
+	}
+
+	return nullptr;
+}
+
+// Кадр BlockCfg SET { SET_IN param value.. } и итерация основного цикла.
+static void BlockCfg(const std::vector<uint8_t> &payload)
+{
+	uint8_t data[8] = { CAN_FUNC_SET_IN };
+	memcpy(&data[1], payload.data(), payload.size());
+
+	frames.clear();
+	MotorStack::ReceiveCAN(0x0102, data, 1 + payload.size());
+	HalShim::Advance(1);
+	MotorStack::Loop();
+
+	return;
+}
+
+static void TestTimer()
+{
+	// 0x0105 ControllerRPM: uint16_t x2, период can_period_fast.
+	CANLib::obj_controller_rpm().SetValue(0, 1234, CAN_TIMER_TYPE_NORMAL);
+	CANLib::obj_controller_rpm().SetValue(1, 4321, CAN_TIMER_TYPE_NORMAL);
+
+	frames.clear();
+	for(uint32_t time = 0; time <= 2u * Config::values.can_period_fast; time += 10)
+	{
+		HalShim::Advance(10);
+		MotorStack::Loop();
+	}
+
+	// Период взят из Config, загруженного до CANLib::Setup().
+	uint32_t count = 0;
+	for(const frame_t &item : frames)
+	{
+		if(item.id == 0x0105) count++;
+	}
+	CHECK(count >= 2 && count <= 3);
+
+	const frame_t *frame = Last(0x0105);
+	if(CHECK(frame != nullptr) == false) return;
+	CHECK_EQ(frame->length, 1 + 2 * sizeof(uint16_t));
+	CHECK_EQ(frame->data[0], CAN_FUNC_TIMER_NORMAL);
+	CHECK_EQ(frame->data[1] | (frame->data[2] << 8), 1234);
+	CHECK_EQ(frame->data[3] | (frame->data[4] << 8), 4321);
+
+	return;
+}
+
+static void TestBlockCfg()
+{
+	// Диаметр колеса 700 мм: ответ SET_OUT_OK с тем же параметром, Speed пересчитан.
+	BlockCfg({ Config::KEY_WHEEL_DIAMETER, 700 & 0xFF, 700 >> 8 });
+	const frame_t *frame = Last(0x0102);
+	if(CHECK(frame != nullptr) == true)
+	{
+		CHECK_EQ(frame->data[0], CAN_FUNC_SET_OUT_OK);
+		CHECK_EQ(frame->length, 4);
+		CHECK_EQ(frame->data[1], Config::KEY_WHEEL_DIAMETER);
+	}
+	CHECK_EQ(Config::values.wheel_diameter, 700);
+	CHECK_EQ(Speed::wheel_diameter, 700);
+
+	// Период CAN: ключ сохраняется, ответ с байтом 0x01 - нужен перезапуск.
+	BlockCfg({ Config::KEY_CAN_PERIOD_FAST, 200 & 0xFF, 200 >> 8 });
+	frame = Last(0x0102);
+	if(CHECK(frame != nullptr) == true)
+	{
+		CHECK_EQ(frame->length, 5);
+		CHECK_EQ(frame->data[1], Config::KEY_CAN_PERIOD_FAST);
+		CHECK_EQ(frame->data[4], 0x01);
+	}
+	CHECK_EQ(Config::values.can_period_fast, 200);
+
+	// Из прерывания ключ только ставится в очередь, Speed меняется в Config::Loop().
+	uint8_t data[4] = { CAN_FUNC_SET_IN, Config::KEY_WHEEL_DIAMETER, 650 & 0xFF, 650 >> 8 };
+	MotorStack::ReceiveCAN(0x0102, data, sizeof(data));
+	CHECK_EQ(Speed::wheel_diameter, 700);
+	uint32_t time = HAL_GetTick();
+	Config::Loop(time);
+	CHECK_EQ(Speed::wheel_diameter, 650);
+
+	// Вне диапазона: без ответа, значение прежнее.
+	BlockCfg({ Config::KEY_WHEEL_DIAMETER, 0x05, 0x00 });
+	CHECK(Last(0x0102) == nullptr);
+	CHECK_EQ(Speed::wheel_diameter, 650);
+
+	// Чтение ключа: { CONFIG_GET key value[2] }.
+	BlockCfg({ CANLib::BLOCK_CFG_CONFIG_GET, Config::KEY_WHEEL_DIAMETER });
+	frame = Last(0x0102);
+	if(CHECK(frame != nullptr) == true)
+	{
+		CHECK_EQ(frame->length, 5);
+		CHECK_EQ(frame->data[0], CAN_FUNC_SET_OUT_OK);
+		CHECK_EQ(frame->data[1], CANLib::BLOCK_CFG_CONFIG_GET);
+		CHECK_EQ(frame->data[2], Config::KEY_WHEEL_DIAMETER);
+		CHECK_EQ(frame->data[3] | (frame->data[4] << 8), 650);
+	}
+
+	// Незнакомый параметр игнорируется.
+	BlockCfg({ 0x7F, 0x01 });
+	CHECK(Last(0x0102) == nullptr);
+
+	// Сброс настроек: значения по умолчанию применяются к модулям.
+	BlockCfg({ CANLib::BLOCK_CFG_CONFIG_RESET });
+	CHECK(Last(0x0102) != nullptr);
+	CHECK_EQ(Speed::wheel_diameter, Speed::CFG_WheelDiameter);
+
+	return;
+}
+
+int main()
+{
+	HalShim::on_can_tx = OnCANTX;
+	HalShim::SetTick(1);
+	// Как после Config::Setup() с сохранённым периодом: объект строится с ним в CANLib::Setup().
+	Config::values.can_period_fast = 100;
+	MotorStack::Setup();
+
+	TestTimer();
+	TestBlockCfg();
+
+	return Check::Result("can_test");
+}
@@ -0,0 +1,97 @@
+/*
+	config_test: журнал настроек Config.h на эмулированной flash. Сбой питания на каждом шаге
+		записи, в том числе на стирании страниц при переходе между ними, оставляет либо
+		старое, либо новое значение, но не значения по умолчанию.
+*/
+
+#include "../MotorStack.cpp"
+#include <HalShim.h>
+#include "Check.h"
+
+using journal_t = decltype(Config::journal);
+
+static uint32_t now = 1;
+
+// Сбой питания: состояние в RAM теряется, во flash остаётся то, что успели записать.
+static void Reboot()
+{
+	Config::values = Config::defaults;
+	Config::journal = {};
+	Config::dirty = false;
+	Config::Setup();
+
+	return;
+}
+
+static bool Busy()
+{
+	return Config::dirty == true || Config::journal.Busy() == true;
+}
+
+// Изменение ключа и шаги Loop() до окончания записи, но не больше steps.
+static void Save(uint16_t value, uint32_t steps)
+{
+	HalShim::SetTick(now);
+	CHECK(Config::Set(Config::KEY_REQUEST_TIME, value));
+
+	now += Config::CFG_SaveDelay + 1;
+	HalShim::SetTick(now);
+	uint32_t time = now;
+	Config::Loop(time);
+
+	for(uint32_t i = 0; i < steps && Busy() == true; ++i)
+	{
+		Config::Loop(time);
+	}
+
+	return;
+}
+
+int main()
+{
+	if(HalShim::FlashAvailable() == false)
+	{
+		printf("config_test: no emulated flash, skipped\n");
+		return 0;
+	}
+
+	Reboot();
+	CHECK_EQ(Config::values.request_time, Config::defaults.request_time);
+
+	// Сбой на каждом шаге: стирание новой страницы, HalfWords полуслов, стирание старой.
+	static constexpr uint32_t steps_max = journal_t::HalfWords + 2;
+	uint16_t value = Config::defaults.request_time;
+	for(uint32_t i = 0; i < journal_t::SlotCount * 4; ++i)
+	{
+		uint16_t next = 100 + (i + 1) * 7;
+		uint32_t cut = i % steps_max;
+
+		Save(next, cut);
+		bool done = (Busy() == false);
+		Reboot();
+		if(done == true) CHECK_EQ(Config::values.request_time, next);
+		else CHECK(Config::values.request_time == value || Config::values.request_time == next);
+
+		// После перезапуска запись доводится до конца.
+		Save(next, UINT32_MAX);
+		CHECK(Busy() == false);
+		Reboot();
+		CHECK_EQ(Config::values.request_time, next);
+		value = next;
+	}
+
+	// Журнал обошёл обе страницы несколько раз.
+	CHECK(HalShim::flash_erases >= 6);
+
+	// После обхода записи идут подряд, без лишних стираний.
+	uint32_t erases = HalShim::flash_erases;
+	for(uint32_t i = 0; i < journal_t::SlotsPerPage; ++i)
+	{
+		Save(2000 + i, UINT32_MAX);
+	}
+	CHECK_EQ(HalShim::flash_erases - erases, 1);
+	Reboot();
+	CHECK_EQ(Config::values.request_time, 2000 + journal_t::SlotsPerPage - 1);
+
+	return Check::Result("config_test");
+}
@@ -0,0 +1,81 @@
+/*
+	erase_test: стирание страницы через FlashErase.h - байты контроллеров и кадры CAN,
+		принятые во время стирания, после него доходят до парсера и CANManager по порядку.
+*/
+
+#include "../MotorStack.cpp"
+#include <HalShim.h>
+#include <FardriverPacket.h>
+#include "Check.h"
+
+static uint8_t wire[FardriverPacket::Size];
+static uint16_t overflow = 0;
+
+// Пока страница стирается: пакет контроллеру 1 в две порции по 10 мс и лишние байты контроллеру 2.
+static void OnErase(uint32_t /* address */)
+{
+	uint32_t time = HAL_GetTick();
+	for(uint8_t i = 0; i < sizeof(wire); ++i)
+	{
+		if(i == sizeof(wire) / 2) time += 10;
+		FlashErase::_CaptureUART(0, wire[i], time);
+	}
+	for(uint16_t i = 0; i < overflow; ++i)
+	{
+		FlashErase::_CaptureUART(1, 0x00, time);
+	}
+	HalShim::Advance(30);
+
+	return;
+}
+
+static uint32_t Frames(uint8_t motor_idx)
+{
+	return MotorStack::Stats(motor_idx).counters[motor_link_stats_t::FRAMES];
+}
+
+static void Erase(uint16_t value)
+{
+	motor_packet_0_t packet = {};
+	packet.RPM = value * 4;
+	packet._A1 = 0x00;
+	FardriverPacket::Encode(&packet, wire);
+
+	FlashErase::Page(Storage::CFG_Start);
+	HalShim::Advance(20);
+	MotorStack::Loop();
+
+	return;
+}
+
+int main()
+{
+	if(HalShim::FlashAvailable() == false)
+	{
+		printf("erase_test: no emulated flash, skipped\n");
+		return 0;
+	}
+
+	HalShim::SetTick(1);
+	MotorStack::Setup();
+	HalShim::on_flash_erase = OnErase;
+
+	// Пакет, принятый во время стирания, разобран после него.
+	uint32_t frames = Frames(1);
+	uint32_t erases = HalShim::flash_erases;
+	Erase(1500);
+	CHECK_EQ(HalShim::flash_erases, erases + 1);
+	CHECK_EQ(Frames(1), frames + 1);
+	CHECK_EQ(CANLib::obj_controller_rpm().GetValue(0), 1500);
+	CHECK_EQ(FlashErase::capture.uart[0].chunks, 2);
+	CHECK_EQ(FlashErase::lost, 0);
+
+	// Переполнение буфера считается, приём другого порта не страдает.
+	overflow = FlashErase::CFG_UartSize + 5;
+	Erase(1700);
+	CHECK_EQ(Frames(1), frames + 2);
+	CHECK_EQ(CANLib::obj_controller_rpm().GetValue(0), 1700);
+	CHECK_EQ(FlashErase::lost, 5);
+
+	return Check::Result("erase_test");
+}
@@ -0,0 +1,152 @@
+/*
+	odometer_test: пробег по оборотам двух двигателей (include/Odometer.h) против аналитического.
+
+	Профиль RPM кусочно-линейный: разгон, крейсерский участок, торможение; второй двигатель
+		крутится на 4% медленнее (проскальзывание) и на время теряет связь. Пакеты 0x00 - раз
+		в 550 мс, на постоянных участках со сдвигом до +-20 мс. Изломы профиля совпадают с
+		пакетами, поэтому трапеция по пакетам совпадает с интегралом профиля, и расхождение -
+		только ошибка целочисленного накопления: не больше 1 мкм на пакет.
+
+	Аналитический путь - в long double по той же геометрии, что Speed (Pi = 355/113).
+*/
+
+#include "../MotorStack.cpp"
+#include <HalShim.h>
+#include <math.h>
+#include "Check.h"
+
+struct segment_t
+{
+	uint32_t packets;		// Интервалов по 550 мс.
+	uint16_t rpm_from;		// RPM двигателя 1 в начале и в конце, двигатель 2 - 96% от них.
+	uint16_t rpm_to;
+	bool motor2_lost;		// Двигатель 2 не на связи.
+};
+
+static constexpr uint32_t Cadence = 550;
+
+static long double MicrometresPerRPMms()
+{
+	return (long double)Speed::wheel_diameter * Speed::PiNum * 100000.0L / (Speed::PiDen * 60000.0L * Speed::gear_ratio);
+}
+
+static uint16_t Motor2(uint16_t rpm)
+{
+	return rpm * 24 / 25;
+}
+
+/*
+	Прогон профиля, возвращает число пакетов. Пути двигателей и общий - в distance[].
+*/
+static uint32_t Run(const segment_t *segments, uint8_t count, long double distance[3])
+{
+	uint32_t time = 1000;
+	uint32_t packets = 0;
+	bool motor2_prev = true;
+
+	// Пакеты двигателя 2 приходят на 3 мс позже пакетов двигателя 1.
+	Odometer::Integrate(0, segments[0].rpm_from, time, true);
+	Odometer::Integrate(1, Motor2(segments[0].rpm_from), time + 3, true);
+	packets += 2;
+
+	for(uint8_t s = 0; s < count; ++s)
+	{
+		const segment_t &segment = segments[s];
+
+		for(uint32_t k = 1; k <= segment.packets; ++k)
+		{
+			// Сдвиг времени пакета - только на постоянном участке, где трапеция точна при любом шаге.
+			int32_t jitter = (segment.rpm_from == segment.rpm_to && k != segment.packets) ? (int32_t)(k * 37 % 41) - 20 : 0;
+			uint32_t dt = Cadence + jitter;
+			uint16_t rpm1_prev = segment.rpm_from + (int32_t)(segment.rpm_to - segment.rpm_from) * (int32_t)(k - 1) / (int32_t)segment.packets;
+			uint16_t rpm1 = segment.rpm_from + (int32_t)(segment.rpm_to - segment.rpm_from) * (int32_t)k / (int32_t)segment.packets;
+			time += dt;
+
+			// Интеграл линейного участка между пакетами.
+			long double d1 = (rpm1_prev + rpm1) / 2.0L * dt * MicrometresPerRPMms();
+			long double d2 = (Motor2(rpm1_prev) + Motor2(rpm1)) / 2.0L * dt * MicrometresPerRPMms();
+
+			bool motor2 = (segment.motor2_lost == false);
+			bool shared = (motor2 == true && motor2_prev == true);
+
+			Odometer::Integrate(0, rpm1, time, shared);
+			packets++;
+			distance[0] += d1;
+			if(motor2 == true)
+			{
+				Odometer::Integrate(1, Motor2(rpm1), time + 3, shared);
+				packets++;
+				if(motor2_prev == true) distance[1] += d2;
+			}
+			distance[2] += (shared == true) ? (d1 + d2) / 2 : d1;
+
+			motor2_prev = motor2;
+		}
+	}
+
+	return packets;
+}
+
+static void TestProfile()
+{
+	// Ступени ускорения кратны 550 мс и дают целые RPM во всех пакетах.
+	static constexpr segment_t profile[] =
+	{
+		{ 120, 0, 3000, false },		// Разгон 66 с.
+		{ 600, 3000, 3000, false },		// Крейсерский участок 5.5 мин.
+		{ 50, 3000, 3000, true },		// Двигатель 2 без связи.
+		{ 600, 3000, 3000, false },
+		{ 100, 3000, 5500, true },		// Разгон на одном двигателе.
+		{ 200, 5500, 5500, false },
+		{ 250, 5500, 0, false },		// Торможение до остановки.
+	};
+
+	long double distance[3] = {};
+	uint64_t start_total = Odometer::total;
+	uint64_t start_motor[2] = { Odometer::motors[0].distance, Odometer::motors[1].distance };
+
+	uint32_t packets = Run(profile, sizeof(profile) / sizeof(profile[0]), distance);
+
+	long double error[3] =
+	{
+		fabsl((long double)(Odometer::motors[0].distance - start_motor[0]) - distance[0]),
+		fabsl((long double)(Odometer::motors[1].distance - start_motor[1]) - distance[1]),
+		fabsl((long double)(Odometer::total - start_total) - distance[2]),
+	};
+	fprintf(stderr, "packets %u, total %.3Lf m, error motor1 %.3Lf um, motor2 %.3Lf um, total %.3Lf um\n",
+		packets, distance[2] / 1e6L, error[0], error[1], error[2]);
+
+	CHECK(distance[2] > 1e9L);
+	CHECK(error[0] <= packets);
+	CHECK(error[1] <= packets);
+	CHECK(error[2] <= packets);
+
+	return;
+}
+
+static void TestGap()
+{
+	// После разрыва больше CFG_MaxGap путь не добавляется.
+	uint64_t total = Odometer::total;
+	Odometer::Integrate(0, 3000, 1000000, false);
+	Odometer::Integrate(0, 3000, 1000000 + Odometer::CFG_MaxGap + 1, false);
+	CHECK_EQ(Odometer::total, total);
+
+	return;
+}
+
+int main()
+{
+	HalShim::SetTick(1);
+	Speed::Setup();
+
+	TestProfile();
+	TestGap();
+
+	// Другая геометрия: колесо 540 мм, редуктор 7.31.
+	Speed::SetWheelDiameter(540);
+	Speed::SetGearRatio(731);
+	TestProfile();
+
+	return Check::Result("odometer_test");
+}
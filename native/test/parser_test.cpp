@@ -0,0 +1,161 @@
+/*
+	parser_test: разбор потока контроллера (FardriverController) и декодирование пакетов
+		в CANObjects (OnMotorEvent, include/MotorEvents.h).
+*/
+
+#include "../MotorStack.cpp"
+#include <HalShim.h>
+#include <FardriverPacket.h>
+#include "Check.h"
+
+static uint8_t wire[FardriverPacket::Size];
+
+// Приём и обработка в основном цикле. Пакеты разделяет пауза больше 10 мс, по ней парсер
+// отбрасывает неполный пакет; Processing() работает не чаще раза в 2 мс.
+static void Deliver(uint8_t motor_idx, const uint8_t *data, uint16_t length)
+{
+	MotorStack::Receive(motor_idx, data, length);
+	HalShim::Advance(20);
+	MotorStack::Loop();
+
+	return;
+}
+
+static void SendRPM(uint8_t motor_idx, uint16_t rpm, uint8_t gear, uint8_t roll)
+{
+	motor_packet_0_t packet = {};
+	packet.RPM = rpm * 4;
+	packet.Gear = gear;
+	packet.Roll = roll;
+	packet._A1 = 0x00;
+	FardriverPacket::Encode(&packet, wire);
+	Deliver(motor_idx, wire, sizeof(wire));
+
+	return;
+}
+
+static void SendPower(uint8_t motor_idx, int16_t current, uint16_t voltage)
+{
+	motor_packet_1_t packet = {};
+	packet.Current = current;
+	packet.Voltage = voltage;
+	packet._A1 = 0x01;
+	FardriverPacket::Encode(&packet, wire);
+	Deliver(motor_idx, wire, sizeof(wire));
+
+	return;
+}
+
+static uint32_t Counter(uint8_t motor_idx, motor_link_stats_t::counter_t counter)
+{
+	return MotorStack::Stats(motor_idx).counters[counter];
+}
+
+static void TestFrames()
+{
+	uint32_t frames = Counter(1, motor_link_stats_t::FRAMES);
+
+	SendRPM(1, 1200, 0x01, 0x03);
+	CHECK_EQ(Counter(1, motor_link_stats_t::FRAMES), frames + 1);
+	CHECK_EQ(CANLib::obj_controller_rpm().GetValue(0), 1200);
+	CHECK_EQ(CANLib::obj_controller_speed().GetValue(0), Speed::Calc(1200));
+	CHECK_EQ(CANLib::obj_controller_gear_n_roll().GetValue(0), FardriverController<>::FixGear(0x01));
+	CHECK_EQ(CANLib::obj_controller_gear_n_roll().GetValue(1), FardriverController<>::FixRoll(0x03));
+
+	// Второй контроллер пишет в свои элементы объектов.
+	SendRPM(2, 800, 0x01, 0x03);
+	CHECK_EQ(CANLib::obj_controller_rpm().GetValue(1), 800);
+	CHECK_EQ(CANLib::obj_controller_rpm().GetValue(0), 1200);
+
+	return;
+}
+
+static void TestSplit()
+{
+	// Пакет по одному байту, как при мелких порциях UART Idle.
+	uint32_t frames = Counter(1, motor_link_stats_t::FRAMES);
+
+	motor_packet_0_t packet = {};
+	packet.RPM = 1500 * 4;
+	packet._A1 = 0x00;
+	FardriverPacket::Encode(&packet, wire);
+	for(uint8_t i = 0; i < sizeof(wire); ++i)
+	{
+		MotorStack::Receive(1, &wire[i], 1);
+	}
+	HalShim::Advance(20);
+	MotorStack::Loop();
+	CHECK_EQ(Counter(1, motor_link_stats_t::FRAMES), frames + 1);
+	CHECK_EQ(CANLib::obj_controller_rpm().GetValue(0), 1500);
+
+	return;
+}
+
+static void TestCorrupted()
+{
+	uint32_t frames = Counter(1, motor_link_stats_t::FRAMES);
+	uint32_t crc = Counter(1, motor_link_stats_t::CRC);
+
+	// Испорченная сумма: пакет отбрасывается, значения не меняются.
+	motor_packet_0_t packet = {};
+	packet.RPM = 3000 * 4;
+	packet._A1 = 0x00;
+	FardriverPacket::Encode(&packet, wire);
+	wire[sizeof(wire) - 1] ^= 0x5A;
+	Deliver(1, wire, sizeof(wire));
+	CHECK_EQ(Counter(1, motor_link_stats_t::FRAMES), frames);
+	CHECK_EQ(Counter(1, motor_link_stats_t::CRC), crc + 1);
+	CHECK_EQ(CANLib::obj_controller_rpm().GetValue(0), 1500);
+
+	// Обрывок пакета отбрасывается по паузе, следующий целый пакет принимается.
+	uint32_t dropped = Counter(1, motor_link_stats_t::DROPPED);
+	uint32_t timeouts = Counter(1, motor_link_stats_t::TIMEOUT);
+	const uint8_t garbage[] = { 0x01, 0x02, 0x03 };
+	Deliver(1, garbage, sizeof(garbage));
+	SendRPM(1, 1000, 0x01, 0x03);
+	CHECK_EQ(Counter(1, motor_link_stats_t::TIMEOUT), timeouts + 1);
+	CHECK_EQ(Counter(1, motor_link_stats_t::DROPPED), dropped + sizeof(garbage));
+	CHECK_EQ(Counter(1, motor_link_stats_t::FRAMES), frames + 1);
+	CHECK_EQ(CANLib::obj_controller_rpm().GetValue(0), 1000);
+
+	return;
+}
+
+static void TestPower()
+{
+	// Постоянный сигнал: медиана и IIR за 32 отсчёта сходятся к нему.
+	for(uint8_t i = 0; i < 32; ++i)
+	{
+		SendPower(1, 40 * 4, 720);
+	}
+	CHECK_EQ(CANLib::obj_controller_voltage().GetValue(0), 720);
+	CHECK_EQ(CANLib::obj_controller_current().GetValue(0), 40 * 4 * 10 / 4);
+	CHECK_EQ(CANLib::obj_controller_power().GetValue(0), 40 * 4 * 720 / 40);
+
+	// Рекуперация: отрицательные ток и мощность.
+	for(uint8_t i = 0; i < 32; ++i)
+	{
+		SendPower(1, -20 * 4, 700);
+	}
+	CHECK_EQ(CANLib::obj_controller_current().GetValue(0), -20 * 4 * 10 / 4);
+	CHECK_EQ(CANLib::obj_controller_power().GetValue(0), -(20 * 4 * 700 / 40));
+
+	return;
+}
+
+int main()
+{
+	HalShim::SetTick(1);
+	MotorStack::Setup();
+
+	FardriverPacket::InitRX(wire);
+	Deliver(1, wire, sizeof(wire));
+	Deliver(2, wire, sizeof(wire));
+
+	TestFrames();
+	TestSplit();
+	TestCorrupted();
+	TestPower();
+
+	return Check::Result("parser_test");
+}
@@ -0,0 +1,106 @@
+/*
+	recorder_test: бортовой самописец FlightRecorder.h - события не вытесняются потоком пакетов
+		контроллеров, пакеты одного двигателя записываются не чаще CFG_FramePeriod, выгрузка
+		видит кольца на момент запроса.
+*/
+
+#include "../MotorStack.cpp"
+#include <HalShim.h>
+#include <vector>
+#include "Check.h"
+
+using namespace FlightRecorder;
+
+static uint32_t Head(ring_t ring)
+{
+	return storage.rings[ring].head;
+}
+
+static void TestRings()
+{
+	uint8_t error = 0x42;
+	Record(EVENT_MOTOR_ERROR, 1, &error, sizeof(error));
+
+	// Два контроллера по 38 пакетов каждые 550 мс, 5 секунд.
+	uint8_t packet[CFG_DataSize - 1] = {};
+	uint32_t frames = Head(RING_FRAMES);
+	for(uint32_t time = 0; time < 5000; time += 550)
+	{
+		for(uint8_t n = 0; n < 38; ++n)
+		{
+			HalShim::Advance(14);
+			packet[12] = n;
+			Record(EVENT_FRAME, 1, packet, sizeof(packet));
+			Record(EVENT_FRAME, 2, packet, sizeof(packet));
+		}
+		HalShim::Advance(550 - 38 * 14);
+	}
+
+	// Событие на месте, пакетов - не больше двух на CFG_FramePeriod.
+	uint32_t heads[RING_COUNT];
+	_Snapshot(heads);
+	CHECK_EQ(Count(heads[RING_EVENTS]), 1);
+	CHECK_EQ(Get(heads, 0).type, EVENT_MOTOR_ERROR);
+	CHECK_EQ(Get(heads, 0).data[0], error);
+	CHECK(Head(RING_FRAMES) - frames <= 2 * (5500 / CFG_FramePeriod + 1));
+	CHECK_EQ(Count(heads[RING_FRAMES]), CFG_Size);
+	CHECK_EQ(Get(heads, 1).type, EVENT_FRAME);
+
+	// Пакеты в кольце покрывают больше секунды истории.
+	const record_t &oldest = Get(heads, 1);
+	const record_t &newest = Get(heads, Count(heads) - 1);
+	CHECK(newest.time - oldest.time >= 1000);
+
+	return;
+}
+
+static void TestDump()
+{
+	uint8_t error = 0x17;
+	Record(EVENT_LINK_ERROR, 2, &error, sizeof(error));
+
+	RequestDump(DUMP_CAN);
+	uint32_t heads[RING_COUNT] = { Head(RING_EVENTS), Head(RING_FRAMES) };
+	uint8_t count = Count(heads);
+	const record_t last = Get(heads, Count(heads[RING_EVENTS]) - 1);
+
+	// Пока идёт выгрузка, новые события не перезаписывают кольца.
+	std::vector<uint8_t> dump;
+	uint8_t packet[CFG_DataSize - 1] = {};
+	uint8_t data[7];
+	while(PackNext(data) == true)
+	{
+		dump.insert(dump.end(), &data[2], &data[7]);
+		HalShim::Advance(CFG_DumpPeriod);
+		Record(EVENT_FRAME, 1, packet, sizeof(packet));
+		Record(EVENT_MOTOR_ERROR, 2, &error, sizeof(error));
+	}
+	CHECK_EQ(dump.size(), count * PartsPerRecord * CFG_PartSize);
+	CHECK_EQ(Head(RING_EVENTS), heads[RING_EVENTS]);
+	CHECK_EQ(Head(RING_FRAMES), heads[RING_FRAMES]);
+	CHECK(lost > 0);
+
+	record_t dumped;
+	memcpy(&dumped, &dump[(Count(heads[RING_EVENTS]) - 1) * PartsPerRecord * CFG_PartSize], sizeof(dumped));
+	CHECK(memcmp(&dumped, &last, sizeof(dumped)) == 0);
+	CHECK_EQ(dumped.type, EVENT_LINK_ERROR);
+
+	// После выгрузки запись возобновляется.
+	Record(EVENT_MOTOR_ERROR, 2, &error, sizeof(error));
+	CHECK_EQ(Head(RING_EVENTS), heads[RING_EVENTS] + 1);
+
+	return;
+}
+
+int main()
+{
+	HalShim::SetTick(1);
+	memset(&storage, 0x00, sizeof(storage));
+	storage.magic = CFG_Magic;
+	storage.magic_inv = ~CFG_Magic;
+
+	TestRings();
+	TestDump();
+
+	return Check::Result("recorder_test");
+}
@@ -0,0 +1,49 @@
+/*
+	speed_test: коэффициенты Speed.h на всём допустимом диапазоне геометрии без переполнения
+		и скорость против расчёта в long double.
+*/
+
+#include "../MotorStack.cpp"
+#include <HalShim.h>
+#include <math.h>
+#include "Check.h"
+
+static void TestGeometry(uint16_t diameter, uint16_t ratio)
+{
+	CHECK(Speed::SetWheelDiameter(diameter));
+	CHECK(Speed::SetGearRatio(ratio));
+
+	long double coef = (long double)diameter * 6 * Speed::PiNum * 65536 / (100.0L * Speed::PiDen * ratio);
+	CHECK(fabsl(Speed::speed_coef - coef) <= 0.5L);
+
+	long double distance = (long double)diameter * Speed::PiNum * 100000 / (60000.0L * Speed::PiDen * ratio);
+	CHECK(fabsl((long double)Speed::distance_num / Speed::distance_den - distance) <= distance * 1e-15L);
+
+	for(uint32_t rpm = 0; rpm <= 0xFFFF; rpm += 4369)
+	{
+		long double speed = fminl(rpm * coef / 65536, Speed::CFG_SpeedMax);
+		CHECK(fabsl(Speed::Calc(rpm) - speed) <= 1.0L);
+	}
+
+	return;
+}
+
+int main()
+{
+	HalShim::SetTick(1);
+	Speed::Setup();
+
+	TestGeometry(Speed::CFG_WheelDiameter, Speed::CFG_GearRatio);
+	TestGeometry(Speed::CFG_WheelDiameterMax, Speed::CFG_GearRatioMin);
+	TestGeometry(Speed::CFG_WheelDiameterMin, Speed::CFG_GearRatioMax);
+	TestGeometry(Speed::CFG_WheelDiameterMax, Speed::CFG_GearRatioMax);
+
+	// Вне диапазона геометрия не меняется.
+	CHECK(Speed::SetWheelDiameter(Speed::CFG_WheelDiameterMax + 1) == false);
+	CHECK(Speed::SetGearRatio(Speed::CFG_GearRatioMin - 1) == false);
+	CHECK(Speed::SetWheelDiameter(0) == false);
+	CHECK_EQ(Speed::wheel_diameter, Speed::CFG_WheelDiameterMax);
+	CHECK_EQ(Speed::gear_ratio, Speed::CFG_GearRatioMax);
+
+	return Check::Result("speed_test");
+}
@@ -0,0 +1,92 @@
+/*
+	storage_test: журнал пробега Storage.h на эмулированной flash. Сбой питания на каждом шаге
+		записи, в том числе на заблаговременном стирании следующей страницы, оставляет либо
+		старый, либо новый пробег; запись по PVD дописывается без стирания.
+*/
+
+#include "../MotorStack.cpp"
+#include <HalShim.h>
+#include "Check.h"
+
+using journal_t = decltype(Storage::journal);
+
+// Сбой питания: состояние в RAM теряется, во flash остаётся то, что успели записать.
+static void Reboot()
+{
+	Storage::journal = {};
+	Storage::saved_odometer = 0;
+	Storage::requested = false;
+	Odometer::Restore(0);
+	Storage::Setup();
+
+	return;
+}
+
+static bool Busy()
+{
+	return Storage::requested == true || Storage::journal.Busy() == true;
+}
+
+// Запрос записи пробега distance и шаги Loop() до окончания записи, но не больше steps.
+static void Save(uint64_t distance, uint32_t steps)
+{
+	Odometer::Restore(distance);
+	Storage::Request();
+
+	uint32_t time = HAL_GetTick();
+	Storage::Loop(time);
+	for(uint32_t i = 0; i < steps && Busy() == true; ++i)
+	{
+		Storage::Loop(time);
+	}
+
+	return;
+}
+
+int main()
+{
+	if(HalShim::FlashAvailable() == false)
+	{
+		printf("storage_test: no emulated flash, skipped\n");
+		return 0;
+	}
+
+	HalShim::SetTick(1);
+	Reboot();
+	CHECK_EQ(Odometer::total, 0);
+
+	// Сбой на каждом шаге: HalfWords полуслов и стирание следующей страницы.
+	static constexpr uint32_t steps_max = journal_t::HalfWords + 2;
+	uint64_t distance = 0;
+	for(uint32_t i = 0; i < journal_t::SlotCount * 2; ++i)
+	{
+		uint64_t next = (i + 1) * 1000000ULL;
+
+		Save(next, i % steps_max);
+		bool done = (Busy() == false);
+		Reboot();
+		if(done == true) CHECK_EQ(Odometer::total, next);
+		else CHECK(Odometer::total == distance || Odometer::total == next);
+
+		// После перезапуска запись доводится до конца.
+		Save(next, UINT32_MAX);
+		CHECK(Busy() == false);
+		Reboot();
+		CHECK_EQ(Odometer::total, next);
+		distance = next;
+	}
+
+	// Журнал обошёл все страницы дважды, каждая стиралась заранее.
+	CHECK(HalShim::flash_erases >= Storage::CFG_PageCount * 2);
+
+	// По PVD запись целиком дописывается за один вызов Loop().
+	Odometer::Restore(distance + 5000);
+	Storage::Urgent();
+	uint32_t time = HAL_GetTick();
+	Storage::Loop(time);
+	CHECK(Storage::journal.Writing() == false);
+	Reboot();
+	CHECK_EQ(Odometer::total, distance + 5000);
+
+	return Check::Result("storage_test");
+}
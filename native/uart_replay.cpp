@@ -0,0 +1,134 @@
+/*
+	uart_replay: воспроизведение записи приёма от контроллеров (native/replay/Capture.h) через
+		Motors::RXEventProcessing с исходными временами и запись получившихся кадров CAN.
+
+	uart_replay CAPTURE [опции]
+		--start MS           время начала, мс (по умолчанию время первой порции)
+		--tail MS            сколько работать после последней порции, мс (1000)
+		--output FILE        кадры CAN в файл, по умолчанию в stdout
+
+	Основной цикл (Motors::Loop, CANLib::Loop) вызывается раз в миллисекунду, порции отдаются
+		перед циклом своей миллисекунды. Результат зависит только от записи, поэтому выход
+		повторяется байт в байт: его можно сравнивать между версиями прошивки.
+	Кадры пишутся так же, как fardriver_sim --can: time,can,id,data. Итог - в stderr.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <HalShim.h>
+#include <MotorStack.h>
+#include <replay/Capture.h>
+
+static FILE *out = stdout;
+static uint32_t can_frames = 0;
+
+static void OnCANTX(uint16_t id, const uint8_t *data, uint8_t length)
+{
+	can_frames++;
+
+	fprintf(out, "%u,can,0x%04X,", HAL_GetTick(), id);
+	for(uint8_t i = 0; i < length; ++i) fprintf(out, "%02X", data[i]);
+	fprintf(out, "\n");
+}
+
+static void Usage()
+{
+	fprintf(stderr, "usage: uart_replay CAPTURE [--start MS] [--tail MS] [--output FILE]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *path = nullptr;
+	const char *output = nullptr;
+	bool has_start = false;
+	uint32_t start = 0;
+	uint32_t tail = 1000;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if(arg[0] != '-')
+		{
+			if(path != nullptr) Usage();
+			path = argv[i];
+			continue;
+		}
+		if(i + 1 >= argc) Usage();
+		const char *value = argv[++i];
+
+		if(arg == "--start") { start = strtoul(value, nullptr, 10); has_start = true; }
+		else if(arg == "--tail") tail = strtoul(value, nullptr, 10);
+		else if(arg == "--output") output = value;
+		else Usage();
+	}
+	if(path == nullptr) Usage();
+
+	Capture capture;
+	std::string error;
+	if(capture.Load(path, error) == false)
+	{
+		fprintf(stderr, "capture: %s\n", error.c_str());
+		return 1;
+	}
+	const std::vector<Capture::chunk_t> &chunks = capture.Chunks();
+	if(chunks.empty())
+	{
+		fprintf(stderr, "capture: %s: empty\n", path);
+		return 1;
+	}
+	if(has_start == false) start = chunks.front().time;
+	uint32_t end = chunks.back().time + tail;
+
+	if(output != nullptr && (out = fopen(output, "w")) == nullptr)
+	{
+		perror(output);
+		return 1;
+	}
+
+	HalShim::on_can_tx = OnCANTX;
+	HalShim::SetTick(start);
+	MotorStack::Setup();
+
+	uint32_t bytes = 0;
+	size_t next = 0;
+	while(next < chunks.size() && chunks[next].time < start) next++;
+
+	for(uint32_t now = start; now <= end; ++now)
+	{
+		HalShim::SetTick(now);
+
+		for(; next < chunks.size() && chunks[next].time == now; ++next)
+		{
+			const Capture::chunk_t &chunk = chunks[next];
+			if(chunk.kind == Capture::KIND_RX)
+			{
+				MotorStack::Receive(chunk.uart, chunk.bytes.data(), chunk.bytes.size());
+				bytes += chunk.bytes.size();
+			}
+			else
+			{
+				MotorStack::ReceiveError(chunk.uart);
+			}
+		}
+
+		MotorStack::Loop();
+	}
+
+	if(out != stdout) fclose(out);
+
+	fprintf(stderr, "chunks=%zu bytes=%u can_frames=%u\n", chunks.size(), bytes, can_frames);
+	for(uint8_t m = 1; m <= 2; ++m)
+	{
+		const motor_link_stats_t &link = MotorStack::Stats(m);
+		fprintf(stderr, "motor=%u frames=%u crc=%u format=%u timeout=%u lost=%u uart=%u auth=%u\n", m,
+			link.counters[motor_link_stats_t::FRAMES], link.counters[motor_link_stats_t::CRC],
+			link.counters[motor_link_stats_t::FORMAT], link.counters[motor_link_stats_t::TIMEOUT],
+			link.counters[motor_link_stats_t::LOST], link.counters[motor_link_stats_t::UART],
+			link.counters[motor_link_stats_t::AUTH]);
+	}
+	MotorStack::PrintFreshness(stderr);
+
+	return 0;
+}
@@ -18,16 +18,34 @@
 
 #include "main.h"
 
-#include <cmath>
 #include <string.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <ConstantLibrary.h>
 #include <LoggerLibrary.h>
-#include <About.h>
 #include <Leds.h>
+#include <AsyncLog.h>
+#include <About.h>
+#include <Trace.h>
+#include <Profiler.h>
+#include <FlightRecorder.h>
+#include <Speed.h>
+#include <Odometer.h>
+#include <Energy.h>
+#include <Filters.h>
+#include <FlashErase.h>
+#include <FlashJournal.h>
+#include <Storage.h>
+#include <Config.h>
 #include <CANLogic.h>
+#include <Freshness.h>
+#include <Supply.h>
 #include <MotorLogic.h>
+#include <MotorEvents.h>
+#include <LoopMonitor.h>
+#include <Watchdog.h>
+#include <MemoryMonitor.h>
+#include <ParserBench.h>
 
 ADC_HandleTypeDef hadc1;
 CAN_HandleTypeDef hcan;
@@ -37,21 +55,18 @@ TIM_HandleTypeDef htim2;
 UART_HandleTypeDef hDebugUart; // debug log
 UART_HandleTypeDef huart2; // motor 1
 UART_HandleTypeDef huart3; // motor 2
+DMA_HandleTypeDef hdma_usart1_tx; // debug log TX
+DMA_HandleTypeDef hdma_adc1; // supply voltage samples
 
 /* Private variables ---------------------------------------------------------*/
 
 // For Timers
 uint32_t Timer1 = 0;
 
-uint32_t odometer_last_update = 0;
-
-// Hardcoded speed calc.
-float WheelDiameter = 680;							// Диаметр колеса, мм.
-float WheelLenght = M_PI * WheelDiameter;			// Длина колеса, мм.
-uint32_t SpeedCoef = (WheelLenght * 60.0F) + 0.5F;	// Коэффициент скорости, просто добавить RPM и поделить на 100000.
-
 //------------------------ For UART
+// Приём идёт порциями Config::values.uart_rx_chunk байт (не больше буфера), прерывание - по заполнению порции или по Idle.
 #define UART_BUFFER_SIZE 128
+static_assert(Config::CFG_UartChunkMax <= UART_BUFFER_SIZE, "UART chunk must fit the buffer!");
 
 uint8_t huart2_rx_buff_hot[UART_BUFFER_SIZE] = {0};
 //uint8_t huart2_rx_buff_cold[UART_BUFFER_SIZE] = {0};
@@ -67,6 +82,7 @@ uint8_t huart3_rx_buff_hot[UART_BUFFER_SIZE] = {0};
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_TIM2_Init(void);
 static void MX_CAN_Init(void);
 static void MX_TIM1_Init(void);
@@ -102,6 +118,8 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 //-------------------------------- Прерывание от USART по флагу Idle
 void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
 {
+	PROFILER_SCOPE(Profiler::PROBE_UART_RX);
+	
 	uint32_t time = HAL_GetTick();
 	
 	if(huart->Instance == USART1)
@@ -111,14 +129,16 @@ void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
 	
 	if(huart->Instance == USART2)
 	{
+		Trace::RecordUART(1, huart2_rx_buff_hot, Size, time);
 		Motors::RXEventProcessing(1, huart2_rx_buff_hot, Size, time);
-		HAL_UARTEx_ReceiveToIdle_IT(&huart2, huart2_rx_buff_hot, UART_BUFFER_SIZE);
+		HAL_UARTEx_ReceiveToIdle_IT(&huart2, huart2_rx_buff_hot, Config::values.uart_rx_chunk);
 	}
 
 	if(huart->Instance == USART3)
 	{
+		Trace::RecordUART(2, huart3_rx_buff_hot, Size, time);
 		Motors::RXEventProcessing(2, huart3_rx_buff_hot, Size, time);
-		HAL_UARTEx_ReceiveToIdle_IT(&huart3, huart3_rx_buff_hot, UART_BUFFER_SIZE);
+		HAL_UARTEx_ReceiveToIdle_IT(&huart3, huart3_rx_buff_hot, Config::values.uart_rx_chunk);
 	}
 
 	return;
@@ -128,18 +148,22 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
 {
     if(huart->Instance == USART2)
     {
-        DEBUG_LOG_TOPIC("uart2", "ERR: %d\r\n", huart->ErrorCode);
+        Motors::RXErrorProcessing(1);
+        FlightRecorder::Record(FlightRecorder::EVENT_UART_ERROR, 1, &huart->ErrorCode, sizeof(huart->ErrorCode));
+        ASYNC_LOG_TOPIC("uart2", "ERR: %lu\r\n", huart->ErrorCode);
 
         HAL_UART_AbortReceive_IT(&huart2);
-        HAL_UARTEx_ReceiveToIdle_IT(&huart2, huart2_rx_buff_hot, UART_BUFFER_SIZE);
+        HAL_UARTEx_ReceiveToIdle_IT(&huart2, huart2_rx_buff_hot, Config::values.uart_rx_chunk);
     }
 
     if(huart->Instance == USART3)
     {
-        DEBUG_LOG_TOPIC("uart3", "ERR: %d\r\n", huart->ErrorCode);
+        Motors::RXErrorProcessing(2);
+        FlightRecorder::Record(FlightRecorder::EVENT_UART_ERROR, 2, &huart->ErrorCode, sizeof(huart->ErrorCode));
+        ASYNC_LOG_TOPIC("uart3", "ERR: %lu\r\n", huart->ErrorCode);
 
         HAL_UART_AbortReceive_IT(&huart3);
-        HAL_UARTEx_ReceiveToIdle_IT(&huart3, huart3_rx_buff_hot, UART_BUFFER_SIZE);
+        HAL_UARTEx_ReceiveToIdle_IT(&huart3, huart3_rx_buff_hot, Config::values.uart_rx_chunk);
     }
 
    // __HAL_USART_CLEAR_FEFLAG(huart);
@@ -150,8 +174,25 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
 
 
 
+void HAL_SYSTICK_Callback(void)
+{
+	LoopMonitor::Tick();
+	Watchdog::Tick();
+	
+	return;
+}
+
+void HAL_PWR_PVDCallback(void)
+{
+	Storage::Urgent();
+	
+	return;
+}
+
 void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan)
 {
+	PROFILER_SCOPE(Profiler::PROBE_CAN_RX);
+	
 	CAN_RxHeaderTypeDef RxHeader = {0};
 	uint8_t RxData[8] = {0};
 	
@@ -167,7 +208,65 @@ void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan)
 {
 	Leds::obj.SetOn(Leds::LED_YELLOW, 100);
 	
-	DEBUG_LOG_TOPIC("CAN", "RX error event, code: 0x%08lX\n", HAL_CAN_GetError(hcan));
+	uint32_t error = HAL_CAN_GetError(hcan);
+	FlightRecorder::Record(FlightRecorder::EVENT_CAN_ERROR, 0, &error, sizeof(error));
+	
+	ASYNC_LOG_TOPIC("CAN", "RX error event, code: 0x%08lX\r\n", error);
+	
+	return;
+}
+
+//-------------------------------- Приём на время стирания flash, см. FlashErase.h
+UART_HandleTypeDef *const erase_uarts[FlashErase::CFG_PortCount] = { &huart2, &huart3 };
+uint8_t *const erase_buffers[FlashErase::CFG_PortCount] = { huart2_rx_buff_hot, huart3_rx_buff_hot };
+bool erase_receiving[FlashErase::CFG_PortCount] = {};
+
+void FlashErase_UARTData(uint8_t port, uint8_t *data, uint8_t length, uint32_t time)
+{
+	// Как из прерывания USART: приём порта остановлен, другие прерывания не вмешиваются.
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	Trace::RecordUART(port + 1, data, length, time);
+	Motors::RXEventProcessing(port + 1, data, length, time);
+	__set_PRIMASK(primask);
+	
+	return;
+}
+
+void FlashErase_UARTPause(uint8_t port)
+{
+	UART_HandleTypeDef *huart = erase_uarts[port];
+	
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	erase_receiving[port] = (huart->RxState == HAL_UART_STATE_BUSY_RX);
+	if(erase_receiving[port] == true)
+	{
+		// Принятое HAL до остановки идёт в парсер раньше принятого во время стирания.
+		uint16_t size = huart->RxXferSize - huart->RxXferCount;
+		HAL_UART_AbortReceive(huart);
+		if(size > 0) FlashErase_UARTData(port, erase_buffers[port], size, HAL_GetTick());
+	}
+	__set_PRIMASK(primask);
+	
+	return;
+}
+
+void FlashErase_UARTResume(uint8_t port)
+{
+	if(erase_receiving[port] == false) return;
+	
+	HAL_UARTEx_ReceiveToIdle_IT(erase_uarts[port], erase_buffers[port], Config::values.uart_rx_chunk);
+	
+	return;
+}
+
+void FlashErase_CANFrame(uint16_t id, uint8_t *data, uint8_t length)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	CANLib::can_manager.IncomingCANFrame(id, data, length);
+	__set_PRIMASK(primask);
 	
 	return;
 }
@@ -196,7 +295,13 @@ void HAL_CAN_Send(can_object_id_t id, uint8_t *data, uint8_t length)
 	{
 		Leds::obj.SetOn(Leds::LED_YELLOW, 100);
 
-		DEBUG_LOG_TOPIC("CAN", "TX error event, code: 0x%08lX\n", HAL_CAN_GetError(&hcan));
+		ASYNC_LOG_TOPIC("CAN", "TX error event, code: 0x%08lX\r\n", HAL_CAN_GetError(&hcan));
+	}
+	else
+	{
+		uint32_t time = HAL_GetTick();
+		About::OnTransmit(time);
+		Freshness::OnTransmit(id, time);
 	}
 	
 	return;
@@ -204,110 +309,6 @@ void HAL_CAN_Send(can_object_id_t id, uint8_t *data, uint8_t length)
 
 
 
-/// @brief Callback function: It is called when correct packet from motor controller PCB is received.
-/// @param motor_idx Index of the motor
-/// @param raw_packet Pointer to the structure with data.
-void OnMotorEvent(const uint8_t motor_idx, motor_packet_raw_t *raw_packet)
-{
-    if (motor_idx > 2 || motor_idx == 0)
-        return;
-
-    uint8_t idx = motor_idx - 1;
-
-    switch (raw_packet->_A1)
-    {
-    case 0x00:
-    {
-        motor_packet_0_t *packet0 = (motor_packet_0_t *)raw_packet;
-
-		// RPM fix. Контроллер возвращает RPMx4.
-		packet0->RPM >>= 2;
-
-        CANLib::obj_controller_rpm.SetValue(idx, packet0->RPM, CAN_TIMER_TYPE_NORMAL);
-
-        // TODO: Длина окружности колеса захардкожена!!
-        //#warning Wheel length is a const hardcoded value!
-        // TODO: Optimization of speed calculation needed!
-        // D=0.57m, WHEEL_LENGTH=Pi*D и делим на 100 для скорости в 100м/ч
-        // при RPM >= 61019 об/мин получим переполнение
-		//CANLib::obj_controller_speed.SetValue(idx, (uint16_t)(60 * packet0->RPM * 0.0179), CAN_TIMER_TYPE_NORMAL);
-		CANLib::obj_controller_speed.SetValue(idx, (uint16_t)((SpeedCoef * packet0->RPM) / 100000UL), CAN_TIMER_TYPE_NORMAL);
-        
-		// TODO: Добавить сюда флаги пониженной передачи и кнопки закиси азота..
-		// А пока просто фиксим значения до 2 младших бит.
-        CANLib::obj_controller_gear_n_roll.SetValue(2 * idx, FardriverController<>::FixGear(packet0->Gear), CAN_TIMER_TYPE_NORMAL);
-        CANLib::obj_controller_gear_n_roll.SetValue(2 * idx + 1, FardriverController<>::FixRoll(packet0->Roll), CAN_TIMER_TYPE_NORMAL);
-
-		DEBUG_LOG_TOPIC("GearRoll", "Motor: %d, Gear: %02X, Roll: %02X;\r\n", motor_idx, packet0->Gear, packet0->Roll);
-
-        uint16_t spd1 = CANLib::obj_controller_speed.GetValue(0);
-        uint16_t spd2 = CANLib::obj_controller_speed.GetValue(1);
-		//uint16_t avg_spd = (spd1 & spd2) + ((spd1 ^ spd2) >> 1);
-		uint16_t avg_spd = ((spd1 + spd2) >> 1);
-        uint32_t odometer_value = CANLib::obj_controller_odometer.GetValue(0);
-        odometer_value += avg_spd * (HAL_GetTick() - odometer_last_update) / 3600000;
-        odometer_last_update = HAL_GetTick();
-        CANLib::obj_controller_odometer.SetValue(0, odometer_value, CAN_TIMER_TYPE_NORMAL);
-        break;
-    }
-
-    case 0x01:
-    {
-        motor_packet_1_t *packet1 = (motor_packet_1_t *)raw_packet;
-        
-        int16_t current = (packet1->Current * 10) / 4;
-        int16_t power = ((uint32_t)abs(packet1->Current) * (uint32_t)packet1->Voltage) / 40U;
-        if(packet1->Current < 0) power = -power;
-        
-		CANLib::obj_controller_voltage.SetValue(idx, packet1->Voltage, CAN_TIMER_TYPE_NORMAL);
-        CANLib::obj_controller_current.SetValue(idx, current, CAN_TIMER_TYPE_NORMAL);
-        CANLib::obj_controller_power.SetValue(idx, power, CAN_TIMER_TYPE_NORMAL);
-        
-		break;
-    }
-
-    case 0x04:
-    {
-        // Градусы : uint8, но до 200 градусов. Если больше то int8
-        CANLib::obj_controller_temperature.SetValue(idx, FardriverController<>::FixTemp(raw_packet->D2), CAN_TIMER_TYPE_NORMAL);
-        break;
-    }
-
-    case 0x0D:
-    {
-        // Градусы : uint8, но до 200 градусов. Если больше то int8
-        CANLib::obj_motor_temperature.SetValue(idx, FardriverController<>::FixTemp(raw_packet->D0), CAN_TIMER_TYPE_NORMAL);
-        break;
-    }
-
-    default:
-        return;
-    }
-}
-
-/// @brief Callback function: It is called when motor controller reports errors
-/// @param motor_idx Index of the motor
-/// @param code Motor error code
-void OnMotorError(const uint8_t motor_idx, const motor_error_t code)
-{
-    if (motor_idx > 2 || motor_idx == 0)
-        return;
-
-    CANLib::obj_controller_errors.SetValue(motor_idx - 1, (uint16_t)code, CAN_TIMER_TYPE_NORMAL, CAN_EVENT_TYPE_NORMAL);
-}
-
-void OnMotorHWError(const uint8_t motor_idx, const uint8_t code)
-{
-	DEBUG_LOG_TOPIC("MotorErr", "motor: %d, code: %d\r", motor_idx, code);
-
-	uint8_t value_old = CANLib::obj_block_health.GetValue(6);
-	uint8_t value_new = (motor_idx == 2) ? ((code << 4) | (value_old & 0x0F)) : (code | (value_old & 0xF0));
-	CANLib::obj_block_health.SetValue(6, value_new, CAN_TIMER_TYPE_NONE, CAN_EVENT_TYPE_NORMAL);
-	#warning Move to BlockError ???
-	
-	return;
-}
-
 /// @brief Callback function: It is called by FardriverController classes for sending data to the PCB of motor controllers.
 /// @param motor_idx Index of the motor
 /// @param raw Pointer to the raw data buffer for sending
@@ -336,6 +337,7 @@ void OnMotorTX(const uint8_t motor_idx, const uint8_t *raw, const uint8_t raw_le
 void InitPeripherals()
 {
     MX_GPIO_Init();
+    MX_DMA_Init();
     MX_TIM2_Init();
     MX_CAN_Init();
     MX_TIM1_Init();
@@ -351,6 +353,8 @@ void InitPeripherals()
 /// @return int
 int main()
 {
+    MemoryMonitor::Paint();
+
     HAL_Init();
     SystemClock_Config();
     InitPeripherals();
@@ -359,34 +363,66 @@ int main()
     // Global Error handler (infinite loop) = Green LED
     // unused = Red LED
     // unused = Blue LED
+    // Самопроверка светодиодов и баннер идут из основного цикла, см. Leds::Loop и About::Loop.
     Leds::Setup();
 
+	HAL_GPIO_WritePin(GPIOA, GPIO_PIN_8, GPIO_PIN_RESET);
+
+	// Быстрый старт: до CAN и контроллеров только то, что не ждёт и нужно им самим.
+	FlashErase::Setup();
+	Watchdog::Setup();
+	FlightRecorder::Setup();
+	Storage::Setup();
+	Config::Setup();
+	Speed::Setup();
+    CANLib::Setup();
+    Motors::Setup();
+
     /* активируем события которые будут вызывать прерывания  */
     HAL_CAN_ActivateNotification(&hcan, CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_ERROR | CAN_IT_BUSOFF | CAN_IT_LAST_ERROR_CODE);
 
     HAL_CAN_Start(&hcan);
 
     // Настройка прерывания от uart (нужное раскоментировать)
-    HAL_UARTEx_ReceiveToIdle_IT(&huart2, huart2_rx_buff_hot, UART_BUFFER_SIZE); // настроить прерывание huart на прием по флагу Idle
+    HAL_UARTEx_ReceiveToIdle_IT(&huart2, huart2_rx_buff_hot, Config::values.uart_rx_chunk); // настроить прерывание huart на прием по флагу Idle
     //HAL_UART_Receive_IT(&huart2, huart2_rx_buff_hot, 16);                       // настроить прерывание huart на прием по достижения количества 16 байт
-    HAL_UARTEx_ReceiveToIdle_IT(&huart3, huart3_rx_buff_hot, UART_BUFFER_SIZE); // настроить прерывание huart на прием по флагу Idle
+    HAL_UARTEx_ReceiveToIdle_IT(&huart3, huart3_rx_buff_hot, Config::values.uart_rx_chunk); // настроить прерывание huart на прием по флагу Idle
     //HAL_UART_Receive_IT(&huart3, huart3_rx_buff_hot, 16);                       // настроить прерывание huart на прием по достижения количества 16 байт
 
-	HAL_GPIO_WritePin(GPIOA, GPIO_PIN_8, GPIO_PIN_RESET);
+	CANLib::obj_controller_odometer().SetValue(0, Odometer::GetTotal(), CAN_TIMER_TYPE_NORMAL);
+	CANLib::PublishEnergy();
+	CANLib::Announce();
+	Watchdog::Publish();
 
-	About::Setup();
-    CANLib::Setup();
-    Motors::Setup();
+	Supply::Setup();
 
-	Leds::obj.SetOn(Leds::LED_GREEN, 50, 1950);
+	Profiler::Setup();
+	LoopMonitor::Setup();
+	MemoryMonitor::Setup();
+	MemoryMonitor::SetModule(MemoryMonitor::MODULE_UART, sizeof(huart2_rx_buff_hot) + sizeof(huart3_rx_buff_hot));
+	ParserBench::Setup();
+	Watchdog::Start();
 
     uint32_t current_time = HAL_GetTick();
     while (1)
     {
-		About::Loop(current_time);
-        Leds::Loop(current_time);
-        CANLib::Loop(current_time);
-        Motors::Loop(current_time);
+		LoopMonitor::Iteration();
+		
+		LoopMonitor::Run(LoopMonitor::MODULE_ABOUT, About::Loop, current_time);
+		LoopMonitor::Run(LoopMonitor::MODULE_LEDS, Leds::Loop, current_time);
+		LoopMonitor::Run(LoopMonitor::MODULE_CAN, CANLib::Loop, current_time);
+		LoopMonitor::Run(LoopMonitor::MODULE_MOTORS, Motors::Loop, current_time);
+		LoopMonitor::Run(LoopMonitor::MODULE_STORAGE, Storage::Loop, current_time);
+		LoopMonitor::Run(LoopMonitor::MODULE_PROFILER, Profiler::Loop, current_time);
+		LoopMonitor::Run(LoopMonitor::MODULE_LOG, AsyncLog::Loop, current_time);
+		LoopMonitor::Run(LoopMonitor::MODULE_TRACE, Trace::Loop, current_time);
+		LoopMonitor::Run(LoopMonitor::MODULE_MEMORY, MemoryMonitor::Loop, current_time);
+		LoopMonitor::Run(LoopMonitor::MODULE_FRESHNESS, Freshness::Loop, current_time);
+		LoopMonitor::Run(LoopMonitor::MODULE_SUPPLY, Supply::Loop, current_time);
+		LoopMonitor::Run(LoopMonitor::MODULE_CONFIG, Config::Loop, current_time);
+		LoopMonitor::Run(LoopMonitor::MODULE_RECORDER, FlightRecorder::Loop, current_time);
+		LoopMonitor::Loop(current_time);
+		Watchdog::Loop(current_time);
 	}
 }
 
@@ -449,7 +485,7 @@ static void MX_ADC1_Init(void)
     hadc1.Init.ScanConvMode = ADC_SCAN_DISABLE;
     hadc1.Init.ContinuousConvMode = DISABLE;
     hadc1.Init.DiscontinuousConvMode = DISABLE;
-    hadc1.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+    hadc1.Init.ExternalTrigConv = ADC_EXTERNALTRIGCONV_T2_CC2;
     hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
     hadc1.Init.NbrOfConversion = 1;
     if (HAL_ADC_Init(&hadc1) != HAL_OK)
@@ -461,7 +497,7 @@ static void MX_ADC1_Init(void)
      */
     sConfig.Channel = ADC_CHANNEL_5;
     sConfig.Rank = ADC_REGULAR_RANK_1;
-    sConfig.SamplingTime = ADC_SAMPLETIME_1CYCLE_5;
+    sConfig.SamplingTime = ADC_SAMPLETIME_239CYCLES_5;
     if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK)
     {
         Error_Handler();
@@ -557,9 +593,10 @@ static void MX_TIM2_Init(void)
 {
     TIM_ClockConfigTypeDef sClockSourceConfig = {0};
     TIM_MasterConfigTypeDef sMasterConfig = {0};
+    TIM_OC_InitTypeDef sConfigOC = {0};
 
     htim2.Instance = TIM2;
-    htim2.Init.Prescaler = 0;
+    htim2.Init.Prescaler = 63;
     htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
     htim2.Init.Period = 89;
     htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
@@ -573,12 +610,25 @@ static void MX_TIM2_Init(void)
     {
         Error_Handler();
     }
+    if (HAL_TIM_PWM_Init(&htim2) != HAL_OK)
+    {
+        Error_Handler();
+    }
     sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
     sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
     if (HAL_TIMEx_MasterConfigSynchronization(&htim2, &sMasterConfig) != HAL_OK)
     {
         Error_Handler();
     }
+    // CC2 starts ADC1 conversions (see Supply.h), the TIM2_CH2 pin PA1 stays an input.
+    sConfigOC.OCMode = TIM_OCMODE_PWM1;
+    sConfigOC.Pulse = 45;
+    sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+    sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+    if (HAL_TIM_PWM_ConfigChannel(&htim2, &sConfigOC, TIM_CHANNEL_2) != HAL_OK)
+    {
+        Error_Handler();
+    }
 }
 
 /**
@@ -644,6 +694,25 @@ static void MX_USART3_UART_Init(void)
     }
 }
 
+/**
+ * @brief Enable DMA controller clock
+ * @param None
+ * @retval None
+ */
+static void MX_DMA_Init(void)
+{
+    /* DMA controller clock enable */
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    /* DMA interrupt init */
+    /* DMA1_Channel1_IRQn interrupt configuration */
+    HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+    /* DMA1_Channel4_IRQn interrupt configuration */
+    HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+}
+
 /**
  * @brief GPIO Initialization Function
  * @param None
@@ -687,6 +756,22 @@ static void MX_GPIO_Init(void)
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 }
 
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    if (hadc == &hadc1)
+    {
+        Supply::OnBlock(&Supply::samples[0]);
+    }
+}
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    if (hadc == &hadc1)
+    {
+        Supply::OnBlock(&Supply::samples[Supply::CFG_BlockSize]);
+    }
+}
+
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
     if (htim == &htim1)
@@ -706,10 +791,8 @@ void Error_Handler(void)
 	Leds::obj.SetOff(Leds::LED_GREEN);
 	Leds::obj.SetOff(Leds::LED_BLUE);
 	
-	while (1)
-	{
-
-	}
+	// Причина сохраняется в .noinit и после перезагрузки уходит в BlockError, см. Watchdog.h.
+	Watchdog::OnError();
 }
 
 #ifdef USE_FULL_ASSERT
@@ -56,9 +56,13 @@ void SVC_Handler(void);
 void DebugMon_Handler(void);
 void PendSV_Handler(void);
 void SysTick_Handler(void);
+void PVD_IRQHandler(void);
+void DMA1_Channel1_IRQHandler(void);
+void DMA1_Channel4_IRQHandler(void);
 void USB_LP_CAN1_RX0_IRQHandler(void);
 void CAN1_SCE_IRQHandler(void);
 void TIM1_UP_IRQHandler(void);
+void USART1_IRQHandler(void);
 void USART2_IRQHandler(void);
 void USART3_IRQHandler(void);
 /* USER CODE BEGIN EFP */
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""
+Compares parser benchmark results (see include/ParserBench.h) against a baseline.
+
+Results are JSON lines from native/parser_bench or from a debug UART capture of the
+Bench firmware; any text around the JSON objects is ignored. A result regresses when
+its per_packet time exceeds the baseline by more than the tolerance, or when the
+parser accepts a different number of frames from the same stream.
+
+    build-native/parser_bench --output bench.json
+    python3 tools/bench_compare.py bench.json --baseline bench_baseline.json --tolerance 10
+    python3 tools/bench_compare.py bench.json --baseline bench_baseline.json --update
+
+Exit code 1 on regression, so it can gate CI.
+"""
+
+import argparse
+import json
+import sys
+
+
+def read_results(path):
+    results = {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            start, end = line.find("{"), line.rfind("}")
+            if start < 0 or end < start:
+                continue
+            try:
+                row = json.loads(line[start:end + 1])
+            except ValueError:
+                continue
+            if "bench" in row and "per_packet" in row:
+                results[(row["bench"], row["corruption"], row["unit"])] = row
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Check parser benchmark results against a baseline.")
+    parser.add_argument("results")
+    parser.add_argument("--baseline", required=True)
+    parser.add_argument("--tolerance", type=float, default=10.0, help="allowed slowdown, percent")
+    parser.add_argument("--update", action="store_true", help="write the results as the new baseline")
+    args = parser.parse_args()
+
+    results = read_results(args.results)
+    if not results:
+        print("no results in %s" % args.results, file=sys.stderr)
+        return 1
+
+    if args.update:
+        with open(args.baseline, "w") as f:
+            for key in sorted(results):
+                f.write(json.dumps(results[key]) + "\n")
+        print("baseline %s: %d results" % (args.baseline, len(results)))
+        return 0
+
+    baseline = read_results(args.baseline)
+    failed = 0
+    for key in sorted(results):
+        row, base = results[key], baseline.get(key)
+        name = "%s/%s/%s" % key
+        if base is None:
+            print("%-24s %10.2f  (no baseline)" % (name, row["per_packet"]))
+            continue
+
+        change = 100.0 * (row["per_packet"] - base["per_packet"]) / base["per_packet"] if base["per_packet"] else 0.0
+        status = "ok"
+        if change > args.tolerance:
+            status = "SLOWER"
+            failed += 1
+        if row["packets"] == base["packets"] and row["frames"] != base["frames"]:
+            status = "FRAMES %d != %d" % (row["frames"], base["frames"])
+            failed += 1
+        print("%-24s %10.2f %10.2f %+7.1f%%  %s" % (name, base["per_packet"], row["per_packet"], change, status))
+
+    for key in sorted(set(baseline) - set(results)):
+        print("%-24s missing" % ("%s/%s/%s" % key))
+        failed += 1
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+"""
+Checks the firmware against the size and hot path budget in tools/budget.json.
+
+Flash and RAM are measured from the linked firmware like tools/size_report.py, or read from
+the size-report.json that env:ReleaseLTO writes next to it (CI keeps it as an artifact). The
+hot path budget is per_packet results of the parser benchmark (include/ParserBench.h), keyed
+"<bench>/<corruption>" under the result unit: "cycles" lines come from a debug UART capture
+of the Bench firmware, "ns" lines from native/parser_bench on the host. "ns" is kept relative
+to the host reference "ref" measured next to each result, so the budget does not depend on
+the speed of the CI runner. Only the parts that are given are checked: the ELF or report for flash and
+RAM, --bench for the units found in it. --bench can be repeated: the best result of the runs
+is taken, which evens out the noise of a shared runner.
+
+    python3 tools/budget_check.py .pio/build/ReleaseLTO/firmware.elf
+    python3 tools/budget_check.py .pio/build/ReleaseLTO/firmware.elf --bench bench_uart.log
+    python3 tools/budget_check.py --bench bench1.json --bench bench2.json --bench bench3.json
+    python3 tools/budget_check.py size-report.json --update
+    python3 tools/budget_check.py --bench bench_uart.log --update
+    python3 tools/budget_check.py --bench bench1.json --bench bench2.json --bench bench3.json --update
+
+--update writes the measured values plus the margin (percent, MARGINS by default) as the new
+budget; flash and RAM never exceed the hardware. A budget that is null or empty has not been
+measured yet: it is reported as unset and not checked until --update fills it.
+Exit code 1 when anything is over budget, so it can gate CI.
+"""
+
+import argparse
+import json
+import math
+import sys
+
+from bench_compare import read_results
+from size_report import FLASH_SIZE, RAM_SIZE, measure
+
+
+UNITS = ("cycles", "ns")
+MARGINS = {"flash": 2.0, "ram": 2.0, "cycles": 2.0, "ns": 20.0}
+
+
+def read_per_packet(path):
+    per_packet = {}
+    for (bench, corruption, unit), row in read_results(path).items():
+        if unit not in UNITS:
+            continue
+        value = row["per_packet"]
+        if unit == "ns":
+            if not row.get("ref"):
+                raise SystemExit("%s: no host reference \"ref\", rebuild native/parser_bench" % path)
+            value /= row["ref"]
+        per_packet.setdefault(unit, {})["%s/%s" % (bench, corruption)] = value
+    return per_packet
+
+
+def read_best(paths):
+    best = {}
+    for path in paths:
+        for unit, values in read_per_packet(path).items():
+            unit_best = best.setdefault(unit, {})
+            for key, value in values.items():
+                unit_best[key] = min(value, unit_best.get(key, value))
+    return best
+
+
+def read_sizes(path, nm, size_tool):
+    if path.endswith(".json"):
+        with open(path) as f:
+            return json.load(f)
+    return measure(path, nm, size_tool)
+
+
+def with_margin(value, margin):
+    return int(math.ceil(value * (100.0 + margin) / 100.0))
+
+
+def with_margin_ratio(value, margin):
+    return math.ceil(value * (100.0 + margin)) / 100.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Check flash, RAM and hot path cycles against a budget.")
+    parser.add_argument("elf", nargs="?", help="linked firmware or its size-report.json, flash and RAM are not checked without it")
+    parser.add_argument("--budget", default="tools/budget.json")
+    parser.add_argument("--bench", action="append", help="debug UART capture of the Bench firmware or native/parser_bench output, repeatable")
+    parser.add_argument("--nm", default="arm-none-eabi-nm")
+    parser.add_argument("--size", default="arm-none-eabi-size")
+    parser.add_argument("--update", action="store_true", help="write the measured values as the new budget")
+    parser.add_argument("--margin", type=float, help="headroom for --update, percent, instead of MARGINS")
+    args = parser.parse_args()
+
+    if args.elf is None and args.bench is None:
+        parser.error("nothing to check: give the ELF, --bench or both")
+
+    report = read_sizes(args.elf, args.nm, args.size) if args.elf else None
+    per_packet = read_best(args.bench) if args.bench else {}
+    if args.bench and not per_packet:
+        print("no %s results in %s" % (" or ".join(UNITS), ", ".join(args.bench)), file=sys.stderr)
+        return 1
+
+    with open(args.budget) as f:
+        budget = json.load(f)
+
+    def margin(name):
+        return MARGINS[name] if args.margin is None else args.margin
+
+    if args.update:
+        if report is not None:
+            budget["flash"] = min(with_margin(report["flash"], margin("flash")), FLASH_SIZE)
+            budget["ram"] = min(with_margin(report["ram"], margin("ram")), RAM_SIZE)
+        for unit, values in per_packet.items():
+            rounding = with_margin if unit == "cycles" else with_margin_ratio
+            budget[unit] = {key: rounding(value, margin(unit)) for key, value in sorted(values.items())}
+        with open(args.budget, "w") as f:
+            json.dump(budget, f, indent=1, sort_keys=True)
+            f.write("\n")
+        print("budget %s: flash %s, ram %s, %s"
+              % (args.budget, budget.get("flash"), budget.get("ram"),
+                 ", ".join("%d %s entries" % (len(budget.get(unit) or {}), unit) for unit in UNITS)))
+        return 0
+
+    failed = 0
+    if report is None:
+        print("flash, ram: not checked, no ELF")
+    else:
+        for name in ("flash", "ram"):
+            if budget.get(name) is None:
+                print("%-24s %10s %10d  unset" % (name, "-", report[name]))
+                continue
+            status = "ok" if report[name] <= budget[name] else "OVER"
+            failed += status != "ok"
+            print("%-24s %10d %10d  %s" % (name, budget[name], report[name], status))
+
+    for unit in UNITS:
+        values = per_packet.get(unit)
+        if values is None:
+            print("%s: not checked, no --bench results" % unit)
+            continue
+        if not budget.get(unit):
+            print("%s: unset, fill with --update" % unit)
+            continue
+        for key, limit in sorted(budget[unit].items()):
+            value = values.get(key)
+            if value is None:
+                status = "missing"
+                value = float("nan")
+            else:
+                status = "ok" if value <= limit else "OVER"
+            failed += status != "ok"
+            print("%-24s %10.2f %10.2f  %s" % ("%s %s" % (unit, key), limit, value, status))
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
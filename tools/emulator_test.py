@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""
+Runs the firmware in the Renode STM32F103 emulator against emulator scenarios.
+
+For every scenario (tools/emulator/scenarios/*.txt, format in native/emu/Scenario.h)
+Renode is started from reset with tools/emulator/motor_ecu.resc, and
+native/emu_bridge connects the Fardriver simulators to USART2/USART3 and the
+scenario's CAN peers to the SocketCAN interface of the emulated bxCAN. Then it
+starts the emulation through the Renode monitor and checks the scenario
+expectations.
+
+    pio run -e Release
+    sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+    python3 tools/emulator_test.py --bridge build-native/emu_bridge
+    python3 tools/emulator_test.py --bridge build-native/emu_bridge tools/emulator/scenarios/latency.txt
+
+The same run is the `emulator_test` target of native/CMakeLists.txt. The exit code is 1
+when any scenario fails, so it can gate CI. The output of each scenario is kept in
+--output (emulator-results/) together with the firmware debug log.
+"""
+
+import argparse
+import glob
+import os
+import socket
+import subprocess
+import sys
+import time
+
+MONITOR_PORT = 3400
+DEBUG_PORT = 3401
+
+
+def wait_port(port, timeout):
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        try:
+            with socket.create_connection(("127.0.0.1", port), timeout=0.5):
+                return True
+        except OSError:
+            time.sleep(0.2)
+    return False
+
+
+def can_interface_ready(name):
+    return os.path.exists("/sys/class/net/%s" % name)
+
+
+def run_scenario(args, scenario, output_dir):
+    name = os.path.splitext(os.path.basename(scenario))[0]
+    script = "$bin=@%s; $can_if=\"%s\"; include @tools/emulator/motor_ecu.resc" % (os.path.abspath(args.elf), args.can)
+    renode = subprocess.Popen([args.renode, "--disable-xwt", "--port", str(MONITOR_PORT), "-e", script],
+                              stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    try:
+        if not wait_port(MONITOR_PORT, args.timeout):
+            print("%s: Renode monitor did not start" % name, file=sys.stderr)
+            return False
+
+        # Debug log of the firmware, read in the background by a socket client.
+        log_path = os.path.join(output_dir, name + ".debug.log")
+        logger = subprocess.Popen([sys.executable, "-c",
+                                   "import socket,sys\n"
+                                   "s=socket.create_connection(('127.0.0.1',%d))\n"
+                                   "f=open(sys.argv[1],'wb')\n"
+                                   "while True:\n"
+                                   "    d=s.recv(4096)\n"
+                                   "    if not d: break\n"
+                                   "    f.write(d); f.flush()\n" % DEBUG_PORT, log_path])
+
+        result_path = os.path.join(output_dir, name + ".txt")
+        with open(result_path, "w") as result:
+            code = subprocess.call([args.bridge, "--scenario", scenario, "--can", args.can,
+                                    "--monitor", str(MONITOR_PORT), "--connect-timeout", str(args.timeout)],
+                                   stdout=subprocess.DEVNULL, stderr=result)
+        logger.kill()
+
+        with open(result_path) as result:
+            for line in result:
+                if line.startswith("expect ") or line.startswith("scenario=") or code not in (0, 1):
+                    print("%s: %s" % (name, line.rstrip()))
+        return code == 0
+    finally:
+        renode.terminate()
+        try:
+            renode.wait(10)
+        except subprocess.TimeoutExpired:
+            renode.kill()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run emulator scenarios against firmware.elf.")
+    parser.add_argument("scenarios", nargs="*", help="scenario files (all in tools/emulator/scenarios)")
+    parser.add_argument("--elf", default=".pio/build/Release/firmware.elf")
+    parser.add_argument("--bridge", default="build-native/emu_bridge")
+    parser.add_argument("--renode", default="renode")
+    parser.add_argument("--can", default="vcan0", help="SocketCAN interface of the emulated bus")
+    parser.add_argument("--timeout", type=float, default=30.0, help="emulator start timeout, s")
+    parser.add_argument("--output", default="emulator-results")
+    args = parser.parse_args()
+
+    scenarios = args.scenarios or sorted(glob.glob("tools/emulator/scenarios/*.txt"))
+    if not os.path.exists(args.elf):
+        print("%s: not found, build it with `pio run -e Release`" % args.elf, file=sys.stderr)
+        return 2
+    if not can_interface_ready(args.can):
+        print("%s: no such interface, create it with `ip link add dev %s type vcan && ip link set up %s`"
+              % (args.can, args.can, args.can), file=sys.stderr)
+        return 2
+
+    os.makedirs(args.output, exist_ok=True)
+    failed = [s for s in scenarios if not run_scenario(args, s, args.output)]
+    print("%d scenarios, %d failed%s" % (len(scenarios), len(failed),
+                                         (": " + ", ".join(failed)) if failed else ""))
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""
+Seed corpus for the parser fuzz target (native/fuzz/FardriverFuzz.cpp).
+
+Controller packets are taken from EVENT_FRAME records of a binary trace capture
+(include/Trace.h, enabled via BLOCK_CFG_TRACE). Each record holds D11..D0 A1 of a valid
+packet; the 0xAA marker and the additive checksum are restored and the packet is
+written back in wire order with the captured time gaps. Consecutive frames of one
+controller are grouped into seeds of --frames packets.
+
+    python3 tools/fuzz_corpus.py --trace capture.bin corpus/
+    python3 tools/fuzz_corpus.py --synthetic corpus/     (no capture at hand)
+"""
+
+import argparse
+import os
+import random
+import struct
+import sys
+
+from trace_decode import cobs_decode, crc8, read_file, split_frames
+
+EVENT_FRAME = 0x02
+
+# motor_packet_init_rx in wire order.
+INIT_RX = b"AT+PASS=29688781"
+
+
+def wire_packet(body):
+    """body - D11..D0 A1 (struct order), returns the 16 wire bytes."""
+    buffer = bytearray(2) + bytearray(body[:13]) + b"\xAA"
+    struct.pack_into("<H", buffer, 0, sum(buffer[2:]) & 0xFFFF)
+    return bytes(reversed(buffer))
+
+
+def records(chunks, start_time):
+    """chunks - (delay_ms, motor, bytes); returns the fuzz input."""
+    out = bytearray(struct.pack("<I", start_time & 0xFFFFFFFF))
+    for delay, motor, data in chunks:
+        for offset in range(0, max(len(data), 1), 255):
+            piece = data[offset:offset + 255]
+            out += bytes([(motor << 7) | min(delay, 0x7F), len(piece)]) + piece
+            delay = 0
+    return bytes(out)
+
+
+def from_trace(path, frames_per_seed):
+    frames = {}
+    for raw in split_frames(read_file(path)):
+        frame = cobs_decode(raw)
+        if frame is None or len(frame) < 7 or crc8(frame[:-1]) != frame[-1]:
+            continue
+        type_id, source, time_ms = struct.unpack_from("<BBI", frame)
+        data = frame[6:-1]
+        if type_id == EVENT_FRAME and source in (1, 2) and len(data) >= 13:
+            frames.setdefault(source, []).append((time_ms, wire_packet(data)))
+
+    for source, items in frames.items():
+        for start in range(0, len(items), frames_per_seed):
+            group = items[start:start + frames_per_seed]
+            chunks, last = [], group[0][0]
+            for time_ms, packet in group:
+                chunks.append((time_ms - last, source - 1, packet))
+                last = time_ms
+            yield records(chunks, group[0][0])
+
+
+def synthetic(count, frames_per_seed):
+    rng = random.Random(1)
+    for n in range(count):
+        chunks = [(0, 0, INIT_RX)]
+        for i in range(frames_per_seed):
+            body = bytes(rng.randrange(256) for _ in range(12)) + bytes([[0x00, 0x01, 0x04, 0x0D][i % 4]])
+            chunks.append((15, n & 1, wire_packet(body)))
+        # Near the 32-bit millisecond wrap for every other seed.
+        yield records(chunks, 0xFFFFFF00 if n % 2 else 1000)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build the parser fuzz seed corpus.")
+    parser.add_argument("output", help="corpus directory")
+    parser.add_argument("--trace", help="binary trace capture with frame events")
+    parser.add_argument("--synthetic", action="store_true", help="generated seeds instead of a capture")
+    parser.add_argument("--count", type=int, default=16, help="number of synthetic seeds")
+    parser.add_argument("--frames", type=int, default=38, help="packets per seed (one request burst)")
+    args = parser.parse_args()
+
+    if args.trace:
+        seeds = from_trace(args.trace, args.frames)
+    elif args.synthetic:
+        seeds = synthetic(args.count, args.frames)
+    else:
+        parser.error("--trace or --synthetic is required")
+
+    os.makedirs(args.output, exist_ok=True)
+    count = 0
+    for count, seed in enumerate(seeds, 1):
+        with open(os.path.join(args.output, "seed-%04d.bin" % count), "wb") as f:
+            f.write(seed)
+    print("%d seeds in %s" % (count, args.output), file=sys.stderr)
+
+    return 0 if count else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
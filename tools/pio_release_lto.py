@@ -0,0 +1,31 @@
+"""
+PlatformIO extra script of env:ReleaseLTO.
+
+build_flags reach the compiler only: the link step runs the LTO code generation and needs
+-flto and the optimisation level too. Libraries are archived with the gcc-ar wrappers so
+their LTO objects keep the plugin symbol index. After every link the size report
+(tools/size_report.py) is written next to firmware.elf.
+"""
+
+import os
+import subprocess
+import sys
+
+Import("env")
+
+env.Append(LINKFLAGS=["-flto", "-O2", "-Wl,--gc-sections"])
+env.Replace(AR="arm-none-eabi-gcc-ar", RANLIB="arm-none-eabi-gcc-ranlib")
+
+
+def size_report(source, target, env):
+    elf = str(target[0])
+    nm = env.WhereIs("arm-none-eabi-nm") or "arm-none-eabi-nm"
+    size = env.WhereIs("arm-none-eabi-size") or "arm-none-eabi-size"
+    script = os.path.join(env.subst("$PROJECT_DIR"), "tools", "size_report.py")
+    output = os.path.join(os.path.dirname(elf), "size-report")
+    with open(output + ".txt", "w") as out:
+        subprocess.call([sys.executable, script, elf, "--nm", nm, "--size", size, "--top", "0", "--json", output + ".json"],
+                        stdout=out)
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", size_report)
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""
+Static RAM summary per module from the linked firmware (see include/MemoryMonitor.h).
+
+Symbols placed in RAM (.data, .bss, .noinit) are grouped by their C++ namespace,
+everything else by name prefix (HAL handles, libc, ...).
+
+    python3 tools/ram_report.py .pio/build/Release/firmware.elf
+    python3 tools/ram_report.py --symbols .pio/build/Debug/firmware.elf
+"""
+
+import argparse
+import re
+import subprocess
+import sys
+from collections import defaultdict
+
+RAM_START = 0x20000000
+RAM_SIZE = 20 * 1024
+
+GROUPS = [
+    (re.compile(r"^(h[a-z]+\d*|hDebugUart|hdma_\w+)$"), "HAL handles"),
+    (re.compile(r"^huart\d_rx_buff"), "UART"),
+    (re.compile(r"^(uwTick|SystemCoreClock|pFlash)"), "HAL"),
+    (re.compile(r"^(_impure_ptr|impure_data|__malloc|errno|__sf)"), "libc"),
+]
+
+
+def group_of(name):
+    # Template arguments may contain '::', only the leading scope matters.
+    base = name.split("<", 1)[0]
+    if "::" in base:
+        return base.split("::", 1)[0]
+    for pattern, group in GROUPS:
+        if pattern.search(name):
+            return group
+    return "other"
+
+
+def read_symbols(elf, nm):
+    out = subprocess.run([nm, "-S", "-C", "--size-sort", elf], check=True, capture_output=True, text=True).stdout
+    for line in out.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) < 4:
+            continue
+        addr, size, kind, name = int(parts[0], 16), int(parts[1], 16), parts[2], parts[3]
+        if RAM_START <= addr < RAM_START + RAM_SIZE and kind in "bBdDvV":
+            yield name, size
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Static RAM usage per module.")
+    parser.add_argument("elf")
+    parser.add_argument("--nm", default="arm-none-eabi-nm")
+    parser.add_argument("--symbols", action="store_true", help="also list every symbol")
+    args = parser.parse_args()
+
+    groups = defaultdict(list)
+    for name, size in read_symbols(args.elf, args.nm):
+        groups[group_of(name)].append((size, name))
+
+    total = sum(size for symbols in groups.values() for size, _ in symbols)
+    for group, symbols in sorted(groups.items(), key=lambda item: -sum(s for s, _ in item[1])):
+        size = sum(s for s, _ in symbols)
+        print("%-16s %6d  %5.1f%%" % (group, size, 100.0 * size / RAM_SIZE))
+        if args.symbols:
+            for sym_size, name in sorted(symbols, reverse=True):
+                print("    %6d  %s" % (sym_size, name))
+    print("%-16s %6d  %5.1f%% of %d" % ("total", total, 100.0 * total / RAM_SIZE, RAM_SIZE))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+Flash and RAM usage of the linked firmware per section, per module and per symbol.
+
+Section totals come from `size -A`: flash is every section linked into flash plus the
+initial values of .data, RAM is every section in RAM including the reserved heap and
+stack (._user_heap_stack). Symbols are grouped by module like tools/ram_report.py.
+vtables and typeinfo are summed separately to show what RTTI and virtual calls cost.
+
+    python3 tools/size_report.py .pio/build/ReleaseLTO/firmware.elf
+    python3 tools/size_report.py --top 0 --json size.json .pio/build/Release/firmware.elf
+
+env:ReleaseLTO writes this report next to firmware.elf (size-report.txt) after every link.
+"""
+
+import argparse
+import json
+import re
+import subprocess
+import sys
+from collections import defaultdict
+
+from ram_report import group_of
+
+FLASH_START = 0x08000000
+FLASH_SIZE = 59392          # board_upload.maximum_size, the last 6 KB are the config store and odometer journal.
+RAM_START = 0x20000000
+RAM_SIZE = 20 * 1024
+
+RTTI = re.compile(r"^(vtable for|typeinfo for|typeinfo name for|construction vtable for|VTT for) ")
+
+
+def region_of(addr):
+    if FLASH_START <= addr < FLASH_START + 0x100000:
+        return "flash"
+    if RAM_START <= addr < RAM_START + RAM_SIZE:
+        return "ram"
+    return None
+
+
+def read_sections(elf, size_tool):
+    out = subprocess.run([size_tool, "-A", elf], check=True, capture_output=True, text=True).stdout
+    sections = []
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) != 3 or not parts[0].startswith("."):
+            continue
+        name, size, addr = parts[0], int(parts[1]), int(parts[2])
+        region = region_of(addr)
+        if region is not None and size > 0:
+            sections.append({"name": name, "size": size, "addr": addr, "region": region})
+    return sections
+
+
+def read_symbols(elf, nm):
+    out = subprocess.run([nm, "-S", "-C", "--size-sort", elf], check=True, capture_output=True, text=True).stdout
+    for line in out.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) < 4:
+            continue
+        addr, size, kind, name = int(parts[0], 16), int(parts[1], 16), parts[2], parts[3]
+        region = region_of(addr)
+        if region is not None:
+            yield {"name": name, "size": size, "kind": kind, "region": region}
+
+
+def measure(elf, nm, size_tool):
+    sections = read_sections(elf, size_tool)
+    symbols = sorted(read_symbols(elf, nm), key=lambda s: -s["size"])
+
+    flash = sum(s["size"] for s in sections if s["region"] == "flash")
+    flash += sum(s["size"] for s in sections if s["name"] == ".data")
+    ram = sum(s["size"] for s in sections if s["region"] == "ram")
+
+    return {"flash": flash, "ram": ram, "sections": sections, "symbols": symbols}
+
+
+def print_report(report, top, out):
+    print("%-20s %8s %10s" % ("section", "size", "addr"), file=out)
+    for section in report["sections"]:
+        print("%-20s %8d 0x%08x" % (section["name"], section["size"], section["addr"]), file=out)
+    print("flash %6d  %5.1f%% of %d" % (report["flash"], 100.0 * report["flash"] / FLASH_SIZE, FLASH_SIZE), file=out)
+    print("ram   %6d  %5.1f%% of %d" % (report["ram"], 100.0 * report["ram"] / RAM_SIZE, RAM_SIZE), file=out)
+
+    for region in ("flash", "ram"):
+        groups = defaultdict(int)
+        for symbol in report["symbols"]:
+            if symbol["region"] == region:
+                groups[group_of(symbol["name"])] += symbol["size"]
+        print("\n%s by module:" % region, file=out)
+        for group, size in sorted(groups.items(), key=lambda item: -item[1]):
+            print("    %-16s %6d" % (group, size), file=out)
+
+    rtti = [s for s in report["symbols"] if RTTI.match(s["name"])]
+    print("\nvtables and typeinfo: %d symbols, %d bytes" % (len(rtti), sum(s["size"] for s in rtti)), file=out)
+
+    symbols = report["symbols"] if top == 0 else report["symbols"][:top]
+    print("\n%s symbols:" % ("all" if top == 0 else "top %d" % top), file=out)
+    for symbol in symbols:
+        print("    %6d  %-5s %s %s" % (symbol["size"], symbol["region"], symbol["kind"], symbol["name"]), file=out)
+
+    return
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flash and RAM usage per section, module and symbol.")
+    parser.add_argument("elf")
+    parser.add_argument("--nm", default="arm-none-eabi-nm")
+    parser.add_argument("--size", default="arm-none-eabi-size")
+    parser.add_argument("--top", type=int, default=40, help="symbols to list, 0 - all")
+    parser.add_argument("--json", help="also write the report as JSON")
+    args = parser.parse_args()
+
+    report = measure(args.elf, args.nm, args.size)
+    print_report(report, args.top, sys.stdout)
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(report, f, indent=1)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""
+Decoder of the binary trace written to the debug UART (see include/Trace.h).
+
+Reads a raw capture of the USART1 stream and writes one CSV row per valid frame.
+Text log lines mixed into the stream fail the CRC check and are skipped.
+
+    python3 tools/trace_decode.py capture.bin > trace.csv
+    python3 tools/trace_decode.py --port /dev/ttyUSB0 --baud 500000 > trace.csv   (needs pyserial)
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+TYPES = {
+    0x01: "boot",
+    0x02: "frame",
+    0x03: "motor_error",
+    0x04: "link_error",
+    0x05: "can_error",
+    0x06: "uart_error",
+    0x07: "config",
+    0x80: "profiler",
+    0x81: "dropped",
+    0x82: "uart_rx",
+}
+
+PROBES = ["UartRx", "CanRx", "MotorProc", "CanProc"]
+
+COLUMNS = ["time_ms", "type", "source", "addr", "rpm", "gear", "roll", "current", "voltage", "code", "probe", "min", "max", "mean", "raw"]
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    idx = 0
+    while idx < len(data):
+        code = data[idx]
+        if code == 0 or idx + code > len(data):
+            return None
+        out += data[idx + 1:idx + code]
+        idx += code
+        if code < 0xFF and idx < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def split_frames(stream):
+    """Yields the raw bytes between 0x00 delimiters, keeping the unfinished tail."""
+    buffer = bytearray()
+    for chunk in stream:
+        buffer += chunk
+        while True:
+            end = buffer.find(b"\x00")
+            if end < 0:
+                break
+            frame = bytes(buffer[:end])
+            del buffer[:end + 1]
+            if frame:
+                yield frame
+
+
+def decode_frame(frame):
+    """Frame layout (after COBS): type[0] source[1] time[2..5] data[6..-2] crc8[-1]."""
+    if len(frame) < 7 or crc8(frame[:-1]) != frame[-1]:
+        return None
+
+    type_id, source, time_ms = struct.unpack_from("<BBI", frame)
+    data = frame[6:-1]
+    row = {"time_ms": time_ms, "type": TYPES.get(type_id, "0x%02X" % type_id), "source": source, "raw": data.hex()}
+
+    if type_id == 0x02 and len(data) >= 13:
+        # Controller packet without CRC and 0xAA: D11..D0 A1, same layout as motor_packet_*_t from offset 2.
+        addr = data[12]
+        row["addr"] = "0x%02X" % addr
+        if addr == 0x00:
+            code, rpm = struct.unpack_from("<HH", data, 4)
+            row["code"] = "0x%04X" % code
+            row["rpm"] = rpm >> 2
+            row["gear"] = data[9] & 0x0F
+            row["roll"] = data[9] >> 4
+        elif addr == 0x01:
+            current, voltage = struct.unpack_from("<hH", data, 8)
+            row["current"] = current / 4.0
+            row["voltage"] = voltage / 10.0
+    elif type_id == 0x03 and len(data) >= 2:
+        row["code"] = "0x%04X" % struct.unpack_from("<H", data)[0]
+    elif type_id in (0x04,) and len(data) >= 1:
+        row["code"] = data[0]
+    elif type_id in (0x01, 0x05, 0x06) and len(data) >= 4:
+        row["code"] = "0x%08X" % struct.unpack_from("<I", data)[0]
+    elif type_id == 0x80 and len(data) >= 7:
+        probe, cmin, cmax, cmean = struct.unpack_from("<BHHH", data)
+        row["probe"] = PROBES[probe] if probe < len(PROBES) else probe
+        row["min"], row["max"], row["mean"] = cmin, cmax, cmean
+    elif type_id == 0x81 and len(data) >= 4:
+        row["code"] = struct.unpack_from("<I", data)[0]
+
+    return row
+
+
+def read_file(path):
+    with open(path, "rb") as f:
+        while True:
+            chunk = f.read(65536)
+            if not chunk:
+                return
+            yield chunk
+
+
+def read_port(port, baud):
+    import serial
+    with serial.Serial(port, baud, timeout=0.1) as ser:
+        while True:
+            chunk = ser.read(4096)
+            if chunk:
+                yield chunk
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the binary debug UART trace into CSV.")
+    parser.add_argument("capture", nargs="?", help="raw capture file")
+    parser.add_argument("--port", help="read from a serial port instead of a file")
+    parser.add_argument("--baud", type=int, default=500000)
+    parser.add_argument("--type", action="append", help="only output the given types (frame, profiler, ...)")
+    args = parser.parse_args()
+
+    if args.port:
+        stream = read_port(args.port, args.baud)
+    elif args.capture:
+        stream = read_file(args.capture)
+    else:
+        parser.error("capture file or --port is required")
+
+    writer = csv.DictWriter(sys.stdout, fieldnames=COLUMNS)
+    writer.writeheader()
+
+    bad = 0
+    for raw in split_frames(stream):
+        frame = cobs_decode(raw)
+        row = decode_frame(frame) if frame is not None else None
+        if row is None:
+            bad += 1
+            continue
+        if args.type and row["type"] not in args.type:
+            continue
+        writer.writerow(row)
+        sys.stdout.flush()
+
+    print("skipped %d invalid frames" % bad, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""
+Controller UART capture from the binary trace (see include/Trace.h, TRACE_UART_RX).
+
+Enable recording over CAN with BLOCK_CFG_CAPTURE, record the debug UART, then convert
+it into the text capture replayed by native/uart_replay (native/replay/Capture.h):
+
+    <time_ms> <uart> rx <hex bytes>
+    <time_ms> <uart> error <code>
+    # comments, including "# lost N pieces" where the trace dropped records
+
+uart is the controller number (1 - USART2, 2 - USART3). Pieces of one controller with
+the same time are merged; the parser sees exactly these bytes at exactly these times.
+
+    python3 tools/uart_capture.py debug.bin > ride.cap
+    python3 tools/uart_capture.py --port /dev/ttyUSB0 > ride.cap   (needs pyserial)
+"""
+
+import argparse
+import struct
+import sys
+
+from trace_decode import cobs_decode, crc8, read_file, read_port, split_frames
+
+EVENT_UART_ERROR = 0x06
+TRACE_DROPPED = 0x81
+TRACE_UART_RX = 0x82
+
+
+def frames(stream):
+    for raw in split_frames(stream):
+        frame = cobs_decode(raw)
+        if frame is None or len(frame) < 7 or crc8(frame[:-1]) != frame[-1]:
+            continue
+        type_id, source, time_ms = struct.unpack_from("<BBI", frame)
+        yield type_id, source, time_ms, frame[6:-1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert a trace with TRACE_UART_RX records into a replay capture.")
+    parser.add_argument("capture", nargs="?", help="raw debug UART capture")
+    parser.add_argument("--port", help="read from a serial port instead of a file")
+    parser.add_argument("--baud", type=int, default=500000)
+    args = parser.parse_args()
+
+    if args.port:
+        stream = read_port(args.port, args.baud)
+    elif args.capture:
+        stream = read_file(args.capture)
+    else:
+        parser.error("capture file or --port is required")
+
+    out = sys.stdout
+    out.write("# controller UART capture: <time_ms> <uart> rx <hex> | <time_ms> <uart> error <code>\n")
+
+    pending = {}        # uart -> [time, bytearray]
+    next_seq = {}
+    lost = 0
+
+    def flush(uart):
+        item = pending.pop(uart, None)
+        if item:
+            out.write("%u %u rx %s\n" % (item[0], uart, item[1].hex().upper()))
+
+    for type_id, source, time_ms, data in frames(stream):
+        # Lines go out in time order, pieces of the current millisecond are still merged.
+        for uart in [u for u, item in pending.items() if item[0] != time_ms]:
+            flush(uart)
+
+        if type_id == TRACE_UART_RX and source in (1, 2) and len(data) >= 2:
+            seq = data[0]
+            if source in next_seq and seq != next_seq[source]:
+                gap = (seq - next_seq[source]) & 0xFF
+                flush(source)
+                out.write("# lost %u pieces of uart %u before %u\n" % (gap, source, time_ms))
+                lost += gap
+            next_seq[source] = (seq + 1) & 0xFF
+
+            item = pending.get(source)
+            if item is None:
+                pending[source] = item = [time_ms, bytearray()]
+            item[1] += data[1:]
+        elif type_id == EVENT_UART_ERROR and source in (1, 2) and len(data) >= 4:
+            flush(source)
+            out.write("%u %u error %u\n" % (time_ms, source, struct.unpack_from("<I", data)[0]))
+        elif type_id == TRACE_DROPPED:
+            out.write("# trace dropped %u records at %u\n" % (struct.unpack_from("<I", data)[0], time_ms))
+        out.flush()
+
+    for uart in list(pending):
+        flush(uart)
+
+    if lost:
+        print("lost %d pieces, the capture is incomplete" % lost, file=sys.stderr)
+    return 1 if lost else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())